@@ -20,6 +20,9 @@ extern "C" {
 #define FIFO_ERR_CLEANUP   -5
 #define FIFO_ERR_BUSY      -6
 #define FIFO_ERR_NODATA    -7
+#define FIFO_ERR_LEASED    -8   // root owned by another engine process
+#define FIFO_ERR_FULL      -9   // reservation refused: no room even after eviction
+#define FIFO_ERR_ARG      -10   // null output pointer or out-of-range argument
 
 // Granularity levels
 #define FIFO_GRAN_ASSET         0
@@ -32,6 +35,23 @@ extern "C" {
 #define FIFO_ACTION_CAUTION 2
 #define FIFO_ACTION_CLEANUP 3
 
+// Deletion log export formats
+#define FIFO_EXPORT_CSV    0
+#define FIFO_EXPORT_NDJSON 1
+
+// Bulk view kinds (fifo_view_open)
+#define FIFO_VIEW_ENTRIES 0   // last scan's per-entity rows
+#define FIFO_VIEW_FILES   1   // last scan's file listing; empty when the scan
+                              // spilled past scan_memory_mb
+#define FIFO_VIEW_WEIGHTS 2   // average daily weights over a span
+
+// Event kinds (bit flags) for fifo_subscribe
+#define FIFO_EVENT_SCAN_DONE        0x1
+#define FIFO_EVENT_ACTION_CHANGED   0x2
+#define FIFO_EVENT_CLEANUP_STARTED  0x4
+#define FIFO_EVENT_CLEANUP_FINISHED 0x8
+#define FIFO_EVENT_ALL              0xF
+
 // Progress callback
 typedef void (*ProgressCallback)(int percent, const char* message);
 
@@ -78,8 +98,93 @@ typedef struct {
     int    files_deleted;
     double mb_freed;
     int    history_days;
+    // Pipelined mode (execute_mode=pipelined): the part of files_deleted and
+    // mb_freed removed while the scan was still walking, and the seconds
+    // from the start of the cycle to the first freed byte (-1 if none)
+    int    early_files_deleted;
+    double early_mb_freed;
+    double first_free_secs;
 } FullResult;
 
+typedef struct {
+    double total_mb;            // point estimate of current usage
+    double low_mb;              // confidence interval around total_mb
+    double high_mb;
+    double predicted_low_mb;    // forecast at both ends of the interval
+    double predicted_high_mb;
+    int    action;              // FIFO_ACTION_*, or -1 when the range straddles a band
+    int    needs_exact_scan;    // straddles a band or reaches cleanup
+    int    manifest_folders;    // day folders answered from daily_ingest
+    int    listed_folders;
+    int    sampled_folders;
+    int    estimated_folders;
+} EstimateResult;
+
+typedef struct {
+    int       held_by_me;       // this process owns the root
+    int       owner_pid;        // 0 when the root is unowned
+    char      owner_host[64];
+    long long heartbeat_age_secs;
+} LeaseInfo;
+
+typedef struct {
+    long long id;
+    char   deleted_at[32];
+    char   asset[64];
+    char   file_path[260];
+    double size_mb;
+    char   reason[32];
+} DeletionLogEntry;
+
+// Rows of a bulk view. *_off fields are byte offsets of NUL-terminated
+// strings in the view's string table.
+typedef struct {
+    long long asset_off;
+    long long date_off;
+    int    entity_id;
+    int    granularity;      // FIFO_GRAN_*
+    int    index_val;        // -1 above FIFO_GRAN_ASSET_INDEX
+    char   category;         // 'E', 'F', or '*'
+    char   _pad[3];
+    double size_mb;
+    int    file_count;
+    int    _pad2;
+} ScanEntryRow;
+
+typedef struct {
+    long long path_off;
+    long long created_time;  // unix time
+    double size_mb;
+    int    entity_id;
+    int    day;              // YYYYMMDD
+} ScanFileRow;
+
+typedef struct {
+    long long asset_off;
+    int    index_val;
+    char   category;
+    char   _pad[3];
+    double avg_mb;
+    double total_mb;
+    int    day_count;
+    int    _pad2;
+} WeightRow;
+
+// Read-only view over engine-owned memory: row i is at rows + i * stride.
+// The memory stays valid and unchanged until fifo_view_release, even
+// across later scans.
+typedef struct {
+    int         handle;
+    int         kind;          // FIFO_VIEW_*
+    const void* rows;
+    long long   count;
+    int         stride;        // bytes per row
+    int         _pad;
+    const char* strings;
+    long long   strings_size;
+    long long   snapshot_id;   // changes with every scan
+} FifoView;
+
 typedef struct {
     int  is_scheduled;
     int  schedule_hour;
@@ -91,17 +196,85 @@ typedef struct {
     int  last_action;
 } StatusInfo;
 
+// Hours from now until usage crosses the MONITOR, CAUTION and CLEANUP band
+// edges and the limit itself, from the intraday ingest profile. The early
+// and late rows bound an 80% band. 0 = already crossed, -1 = not within
+// 14 days.
+typedef struct {
+    double current_mb;          // projected to now from the last exact scan
+    double rate_mb_per_hour;    // expected ingest over the next hour
+    double eta_hours[4];
+    double eta_early_hours[4];
+    double eta_late_hours[4];
+    int    intervals;           // scan-to-scan intervals in the model
+    int    hours_covered;       // hours of the day with their own rate
+} TimeToFull;
+
+typedef struct {
+    double usage_mb;            // last scan, minus cleanups, plus released writes
+    double reserved_mb;         // outstanding reservations
+    double limit_mb;            // 0 while admission is off
+    double evicted_mb;          // freed by reservation-triggered evictions
+    long long evictions;
+    long long denied;           // reservations refused with FIFO_ERR_FULL
+} AdmissionInfo;
+
+// One delivery to a subscriber. Changes published between deliveries are
+// coalesced: kinds holds every FIFO_EVENT_* bit since the previous one and
+// the values are the latest.
+typedef struct {
+    long long seq;
+    long long at;               // unix time of the latest change
+    int    kinds;
+    int    action;              // current FIFO_ACTION_*, -1 before the first evaluation
+    int    prev_action;
+    int    files_deleted;       // last finished cleanup
+    double mb_freed;
+    double current_mb;          // latest scanned or evaluated usage
+    double cleanup_planned_mb;  // first plan of the last started cleanup
+} FifoEvent;
+
+// Event callback, called on the engine's notifier thread
+typedef void (*FifoEventCallback)(const FifoEvent* ev, void* user);
+
+// Counters since fifo_init, covering every full cycle whether it came from
+// fifo_execute_full or the scheduler. Readable while a cycle is running.
+typedef struct {
+    long long uptime_secs;
+    long long cycles;
+    long long failed_cycles;    // cycles that returned an error
+    int    last_rc;
+    int    last_action;         // -1 when the cycle did not report one
+    double last_cycle_ms;
+    long long files_deleted;
+    double mb_freed;
+    long long scan_id;          // changes with every scan
+    int    scan_files;          // files held in the in-memory scan
+    int    in_cycle;            // a cycle is running now
+    double scan_mb;
+} EngineMetrics;
+
 #pragma pack(pop)
 
 // Core API
 FIFO_API int  fifo_init(const char* db_path);
 FIFO_API void fifo_shutdown();
 
-// Operations
+// Operations that scan or delete take the root's cross-process lease. When
+// another engine process owns it they return FIFO_ERR_LEASED without
+// touching the tree, and fill their results from the shared database.
 FIFO_API int fifo_scan(const char* root_path, int granularity);
 FIFO_API int fifo_forecast(ForecastResult* out_result);
+// Forecast for one ASSET/Index/Category from its incremental state
+FIFO_API int fifo_forecast_entity(const char* asset, int index_val, char category,
+                                  ForecastResult* out_result);
+// Rebuild the incremental forecast state from the stored daily ingest
+FIFO_API int fifo_rebuild_forecast_state();
 FIFO_API int fifo_evaluate(double limit_mb, EvalResult* out_result);
 FIFO_API int fifo_cleanup(double limit_mb, double target_pct, CleanupResult* out_result);
+// Sampled usage estimate with a 95% confidence interval; cheap enough for
+// interval checks on trees with millions of files per day
+FIFO_API int fifo_estimate(const char* root_path, double limit_mb, EstimateResult* out_result);
 FIFO_API int fifo_execute_full(const char* root, int granularity, double limit_mb,
                                double target_pct, FullResult* out_result);
 
@@ -111,10 +284,26 @@ FIFO_API int fifo_generate_test_data(const char* root_path, double size_gb,
 FIFO_API int fifo_generate_one_day(const char* root_path, double day_size_mb,
                                    int day_offset, ProgressCallback cb);
 
-// Average weights query
+// Average weights query (every scan stores all granularities; the plain
+// variant uses the granularity of the last scan)
 FIFO_API int fifo_get_weights(WeightInfo* buf, int buf_size, int* out_count);
+FIFO_API int fifo_get_weights_at(int granularity, WeightInfo* buf, int buf_size, int* out_count);
+
+// Long-horizon history: spans over 30 days are read from the columnar
+// store next to the database instead of SQLite
+FIFO_API int fifo_get_weights_span(int days, int granularity, WeightInfo* buf, int buf_size,
+                                   int* out_count);
+// Total usage per day for the last `days` days plus today, oldest first
+// (-1 for days without a snapshot)
+FIFO_API int fifo_get_usage_series(int days, double* buf, int buf_size, int* out_count);
 FIFO_API int fifo_get_history_day_count();
 
+// Intraday ETA to each threshold band and the limit. Interval scans feed
+// the model; with the cleanup_eta_hours config key set, a cycle also
+// cleans up when the fast edge of the band crosses CLEANUP within that
+// many hours.
+FIFO_API int fifo_time_to_full(double limit_mb, TimeToFull* out);
+
 // Scheduler
 FIFO_API int  fifo_schedule_start(const char* root, int granularity,
                                   double limit_mb, double target_pct,
@@ -122,8 +311,71 @@ FIFO_API int  fifo_schedule_start(const char* root, int granularity,
 FIFO_API int  fifo_schedule_start_interval(const char* root, int granularity,
                                            double limit_mb, double target_pct,
                                            int interval_minutes);
+// Adaptive interval: scans rarely while usage is far from the threshold
+// bands and tightens toward min_interval_minutes as it approaches them.
+// Tuned by the schedule_safety and schedule_jitter_pct config keys.
+FIFO_API int  fifo_schedule_start_adaptive(const char* root, int granularity,
+                                           double limit_mb, double target_pct,
+                                           int min_interval_minutes, int max_interval_minutes);
 FIFO_API int  fifo_schedule_stop();
+// Let scheduled cycles refresh this process's in-memory scan, as
+// fifo_execute_full does. Not persisted: only the calling process is affected.
+// In both modes a scheduled cycle excludes the other API calls while it
+// runs; fifo_get_metrics and events are still served.
+FIFO_API int  fifo_set_scheduler_warm(int enabled);
 FIFO_API int  fifo_get_status(StatusInfo* out);
+FIFO_API int  fifo_get_metrics(EngineMetrics* out);
+
+// Cross-process lease on a root (see lease_stale_secs)
+FIFO_API int fifo_get_lease(const char* root_path, LeaseInfo* out);
+
+// Deletion log, keyset-paginated on (deleted_at, id), newest first.
+// from/to bound deleted_at ("YYYY-MM-DD" or "YYYY-MM-DD HH:MM:SS", to is
+// exclusive); asset filters by asset. NULL or "" leaves a filter open.
+// fifo_log_next fills up to min(page_size, buf_size) rows; 0 rows = end.
+FIFO_API int fifo_log_query(const char* from, const char* to, const char* asset,
+                            int page_size, int* out_handle);
+FIFO_API int fifo_log_next(int handle, DeletionLogEntry* buf, int buf_size, int* out_count);
+FIFO_API int fifo_log_close(int handle);
+
+// Stream every matching row, oldest first, as FIFO_EXPORT_* to a CRT file
+// descriptor (or a file path). Runs on its own connection, so other API
+// calls are not blocked during a long export. out_rows may be NULL.
+FIFO_API int fifo_log_export(const char* from, const char* to, const char* asset,
+                             int format, int fd, long long* out_rows);
+FIFO_API int fifo_log_export_file(const char* from, const char* to, const char* asset,
+                                  int format, const char* path, long long* out_rows);
+
+// Zero-copy bulk access. granularity selects the entry/weight level (-1
+// for all entry levels); days is the weights span and is ignored for
+// scan views. Every opened view must be released.
+FIFO_API int fifo_view_open(int kind, int granularity, int days, FifoView* out);
+FIFO_API int fifo_view_release(int handle);
+
+// Space admission for producers. fifo_reserve answers from atomic counters
+// while usage plus reservations stays below the CLEANUP band; past it, just
+// the excess is evicted oldest first before granting anything up to the
+// limit, or FIFO_ERR_FULL. Release every reservation with the bytes
+// actually written.
+FIFO_API int fifo_admission_start(const char* root_path, double limit_mb);
+FIFO_API int fifo_reserve(long long bytes);
+FIFO_API int fifo_release(long long reserved_bytes, long long written_bytes);
+FIFO_API int fifo_get_admission(AdmissionInfo* out);
+
+// Workload trace for fiforeplay: ingest per day folder as seen by scans,
+// cleanup removals and cycle timings. Also started at fifo_init when the
+// trace_path config key is set.
+FIFO_API int fifo_trace_start(const char* path);
+FIFO_API int fifo_trace_stop();
+
+// Event subscriptions. Callbacks run on a dedicated notifier thread and
+// must not call fifo_shutdown. A handle subscription gets an auto-reset
+// Win32 event, owned by the engine until fifo_unsubscribe, that is
+// signalled instead; read the state with fifo_get_last_event.
+FIFO_API int fifo_subscribe(int kinds, FifoEventCallback cb, void* user, int* out_handle);
+FIFO_API int fifo_subscribe_handle(int kinds, void** out_event, int* out_handle);
+FIFO_API int fifo_unsubscribe(int handle);
+FIFO_API int fifo_get_last_event(FifoEvent* out);
 
 // Configuration
 FIFO_API int fifo_set_config(const char* key, const char* value);
@@ -0,0 +1,108 @@
+#include "admission.h"
+#include "cleanup.h"
+#include "eviction.h"
+#include "lease.h"
+#include "oldest_first.h"
+#include "fifo_api.h"
+#include <cstdlib>
+
+static const double BYTES_PER_MB = 1048576.0;
+
+static long long to_bytes(double mb) { return (long long)(mb * BYTES_PER_MB); }
+
+Admission::Admission() : root_(std::make_shared<const std::string>()) {}
+
+Admission::~Admission() { close(); }
+
+void Admission::configure(const std::string& db_path, const std::string& root_path,
+                          double limit_mb, double usage_mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (db_path != db_path_ && db_.is_open()) db_.close();
+    db_path_ = db_path;
+    std::atomic_store(&root_, std::make_shared<const std::string>(root_path));
+    usage_bytes_.store(to_bytes(usage_mb));
+    edge_bytes_.store(to_bytes(band_edge_mb(FIFO_ACTION_CLEANUP, limit_mb)));
+    limit_bytes_.store(to_bytes(limit_mb));
+}
+
+int Admission::reserve(long long bytes) {
+    if (bytes <= 0) return FIFO_OK;
+    long long limit = limit_bytes_.load();
+    if (limit <= 0) return FIFO_OK;  // nothing configured: admission is off
+
+    // Fast path: fits below the cleanup band
+    long long edge = edge_bytes_.load();
+    long long reserved = reserved_bytes_.load();
+    while (usage_bytes_.load() + reserved + bytes <= edge) {
+        if (reserved_bytes_.compare_exchange_weak(reserved, reserved + bytes)) return FIFO_OK;
+    }
+
+    // Make room for the excess, then admit anything up to the limit
+    std::lock_guard<std::mutex> lock(mutex_);
+    reserved = reserved_bytes_.load();
+    long long excess = usage_bytes_.load() + reserved + bytes - edge;
+    if (excess > 0) evict(excess);
+
+    reserved = reserved_bytes_.load();
+    while (usage_bytes_.load() + reserved + bytes <= limit) {
+        if (reserved_bytes_.compare_exchange_weak(reserved, reserved + bytes)) return FIFO_OK;
+    }
+    denied_++;
+    return FIFO_ERR_FULL;
+}
+
+void Admission::release(long long reserved_bytes, long long written_bytes) {
+    if (reserved_bytes > 0) reserved_bytes_ -= reserved_bytes;
+    if (written_bytes > 0) usage_bytes_ += written_bytes;
+}
+
+void Admission::on_scan(const std::string& root_path, double total_mb) {
+    if (!configured() || root_path != *std::atomic_load(&root_)) return;
+    usage_bytes_.store(to_bytes(total_mb));
+}
+
+void Admission::on_freed(const std::string& root_path, double mb) {
+    // Called per file from cleanups, including the ones evict() runs
+    if (!configured() || root_path != *std::atomic_load(&root_)) return;
+    usage_bytes_ -= to_bytes(mb);
+}
+
+long long Admission::evict(long long bytes) {
+    std::string root = *std::atomic_load(&root_);
+
+    // Deleting needs the root's lease; a root owned elsewhere is its owner's job
+    if (!root_lease().owns(root)) {
+        if (root_lease().held()) return 0;
+        if (!db_.is_open() && db_.open(db_path_) != 0) return 0;
+        int stale = std::atoi(db_.get_config("lease_stale_secs", "90").c_str());
+        if (root_lease().acquire(root, stale) != 0) return 0;
+    }
+    if (!db_.is_open() && db_.open(db_path_) != 0) return 0;
+
+    // Usage drops through on_freed as the journal removes files
+    long long before = usage_bytes_.load();
+    EvictionParams params = load_eviction_params(db_);
+    OldestFirstIterator oldest(root);
+    CleanupStats stats = execute_cleanup(db_, oldest, bytes / BYTES_PER_MB, params);
+
+    evictions_++;
+    evicted_bytes_ += to_bytes(stats.mb_freed);
+    long long freed = before - usage_bytes_.load();
+    return freed > 0 ? freed : 0;
+}
+
+double Admission::usage_mb() const { return usage_bytes_.load() / BYTES_PER_MB; }
+double Admission::reserved_mb() const { return reserved_bytes_.load() / BYTES_PER_MB; }
+double Admission::limit_mb() const { return limit_bytes_.load() / BYTES_PER_MB; }
+double Admission::evicted_mb() const { return evicted_bytes_.load() / BYTES_PER_MB; }
+
+void Admission::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    limit_bytes_.store(0);
+    if (db_.is_open()) db_.close();
+}
+
+Admission& admission() {
+    static Admission instance;
+    return instance;
+}
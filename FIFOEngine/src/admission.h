@@ -0,0 +1,73 @@
+#ifndef ADMISSION_H
+#define ADMISSION_H
+
+#include "database.h"
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <string>
+
+// Space admission for producers. Live usage is the last exact scan of the
+// root, minus what cleanups have removed from it since, plus what writers
+// have reported through release(); outstanding reservations are counted
+// on top. All of it lives in atomics, so a reservation that fits below
+// the cleanup band is granted with a few loads and one compare-exchange.
+// One that does not triggers a targeted oldest-first eviction of just the
+// excess, run on the admission's own connection, before being granted
+// (anywhere up to the limit) or refused.
+class Admission {
+public:
+    Admission();
+    ~Admission();
+
+    // Root and limit reservations are checked against; usage is seeded
+    // from the caller's last known total
+    void configure(const std::string& db_path, const std::string& root_path,
+                   double limit_mb, double usage_mb);
+    bool configured() const { return limit_bytes_.load() > 0; }
+
+    // FIFO_OK, FIFO_ERR_FULL when not even eviction makes room
+    int reserve(long long bytes);
+
+    // Drop a reservation; written bytes count as usage until the next scan
+    void release(long long reserved_bytes, long long written_bytes);
+
+    // Engine hooks: an exact scan re-bases usage, a cleanup lowers it
+    void on_scan(const std::string& root_path, double total_mb);
+    void on_freed(const std::string& root_path, double mb);
+
+    double usage_mb() const;
+    double reserved_mb() const;
+    double limit_mb() const;
+    long long evictions() const { return evictions_.load(); }
+    double evicted_mb() const;
+    long long denied() const { return denied_.load(); }
+
+    void close();
+
+private:
+    // Free at least `bytes` from the root, oldest first; bytes freed
+    long long evict(long long bytes);
+
+    std::atomic<long long> usage_bytes_{0};
+    std::atomic<long long> reserved_bytes_{0};
+    std::atomic<long long> limit_bytes_{0};
+    std::atomic<long long> edge_bytes_{0};     // lower edge of the cleanup band
+    std::atomic<long long> evictions_{0};
+    std::atomic<long long> evicted_bytes_{0};
+    std::atomic<long long> denied_{0};
+
+    // Read by the cleanup hooks, which also run inside evict() with
+    // mutex_ held, so it is swapped whole with std::atomic_store
+    std::shared_ptr<const std::string> root_;
+
+    // Slow path only
+    std::mutex  mutex_;
+    std::string db_path_;
+    Database    db_;
+};
+
+// Process-wide admission shared by the API, scans and cleanups
+Admission& admission();
+
+#endif // ADMISSION_H
@@ -1,16 +1,28 @@
 #include "cleanup.h"
+#include "entity_registry.h"
+#include "journal.h"
 #include "fifo_api.h"
+#include "spill.h"
 #include <algorithm>
 #include <ctime>
 #include <cstdio>
-#include <map>
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 #include <windows.h>
 
-int evaluate_threshold(double predicted_mb, double limit_mb, double* amount_to_delete) {
+// Lower edges of the MONITOR, CAUTION and CLEANUP bands, in % of the limit
+static const double BAND_PCT[] = {85.0, 90.0, 95.0};
+
+double target_fraction(double target_pct) {
+    double f = target_pct > 1.0 ? target_pct / 100.0 : target_pct;
+    if (f <= 0 || f >= 1.0) f = DEFAULT_TARGET_PCT / 100.0;
+    return f;
+}
+
+int evaluate_threshold(double predicted_mb, double limit_mb, double* amount_to_delete,
+                       double target_pct) {
     if (limit_mb <= 0) {
         if (amount_to_delete) *amount_to_delete = 0;
         return FIFO_ACTION_SAFE;
@@ -18,94 +30,251 @@ int evaluate_threshold(double predicted_mb, double limit_mb, double* amount_to_d
 
     double pct = (predicted_mb / limit_mb) * 100.0;
 
-    if (pct < 85.0) {
+    if (pct < BAND_PCT[0]) {
         if (amount_to_delete) *amount_to_delete = 0;
         return FIFO_ACTION_SAFE;
     }
-    if (pct < 90.0) {
+    if (pct < BAND_PCT[1]) {
         if (amount_to_delete) *amount_to_delete = 0;
         return FIFO_ACTION_MONITOR;
     }
-    if (pct < 95.0) {
+    if (pct < BAND_PCT[2]) {
         if (amount_to_delete) *amount_to_delete = 0;
         return FIFO_ACTION_CAUTION;
     }
 
-    // Cleanup needed: reduce to 70% target
-    double target_mb = limit_mb * 0.70;
+    // Cleanup needed: reduce to the target
+    double target_mb = limit_mb * target_fraction(target_pct);
     double to_delete = predicted_mb - target_mb;
     if (to_delete < 0) to_delete = 0;
     if (amount_to_delete) *amount_to_delete = to_delete;
     return FIFO_ACTION_CLEANUP;
 }
 
-CleanupStats execute_cleanup(Database& db, std::vector<ScannedFile>& files,
+double band_edge_mb(int action, double limit_mb) {
+    if (action < FIFO_ACTION_MONITOR || action > FIFO_ACTION_CLEANUP) return 0;
+    return limit_mb * BAND_PCT[action - FIFO_ACTION_MONITOR] / 100.0;
+}
+
+double next_band_mb(double usage_mb, double limit_mb) {
+    if (limit_mb <= 0) return -1;
+    for (double pct : BAND_PCT) {
+        double edge = limit_mb * pct / 100.0;
+        if (usage_mb < edge) return edge;
+    }
+    return -1;
+}
+
+int evaluate_threshold_interval(double low_mb, double high_mb, double limit_mb,
+                                double* amount_to_delete, double target_pct) {
+    int low_action = evaluate_threshold(low_mb, limit_mb, nullptr);
+    int high_action = evaluate_threshold(high_mb, limit_mb, amount_to_delete, target_pct);
+    if (low_action != high_action) {
+        if (amount_to_delete) *amount_to_delete = 0;
+        return -1;
+    }
+    return high_action;
+}
+
+// Files journaled per plan() call: small enough that a crash leaves little
+// to reconcile, large enough that the plan commit is not paid per file
+static const size_t PLAN_CHUNK = 64;
+
+CleanupStats execute_cleanup(Database& db, const std::string& root_path,
+                             std::vector<ScannedFile>& files,
                              double amount_to_delete_mb,
-                             int min_retention_hours, int max_deletions) {
+                             const EvictionParams& params) {
     CleanupStats stats{};
     if (amount_to_delete_mb <= 0 || files.empty()) return stats;
 
     time_t now = time(nullptr);
-    time_t cutoff = now - (min_retention_hours * 3600);
-
-    // Sort files by creation time ascending (oldest first)
-    std::sort(files.begin(), files.end(), [](const ScannedFile& a, const ScannedFile& b) {
-        return a.created_time < b.created_time;
-    });
+    time_t cutoff = now - (params.min_retention_hours * 3600);
 
     // Count files per asset-index-category to avoid deleting everything
-    struct EntityKey {
-        std::string asset;
-        int index_val;
-        char category;
-        bool operator<(const EntityKey& o) const {
-            if (asset != o.asset) return asset < o.asset;
-            if (index_val != o.index_val) return index_val < o.index_val;
-            return category < o.category;
-        }
-    };
-    std::map<EntityKey, int> entity_counts;
+    std::vector<int> entity_counts(entity_registry().size(), 0);
+    std::vector<ScannedFile> candidates;
     for (auto& f : files) {
-        entity_counts[{f.asset, f.index_val, f.category}]++;
+        entity_counts[f.entity_id]++;
+        // Skip files newer than retention period
+        if (f.created_time <= cutoff) candidates.push_back(f);
     }
+    make_eviction_policy(params)->order(candidates, files, amount_to_delete_mb);
 
     double freed = 0;
     int count = 0;
+    size_t pos = 0;
+    CleanupJournal journal(db, root_path, "PREDICTIVE_CLEANUP", params.cold_root,
+                           params.verify_content);
 
-    for (auto& f : files) {
-        if (freed >= amount_to_delete_mb || count >= max_deletions)
-            break;
+    while (pos < candidates.size() && freed < amount_to_delete_mb && count < params.max_deletions) {
+        // Plan the next chunk as if every deletion succeeds
+        std::vector<ScannedFile> chunk;
+        double planned_mb = freed;
+        int planned = count;
+        for (; pos < candidates.size() && chunk.size() < PLAN_CHUNK; ++pos) {
+            if (planned_mb >= amount_to_delete_mb || planned >= params.max_deletions)
+                break;
+            const ScannedFile& f = candidates[pos];
 
-        // Skip files newer than retention period
-        if (f.created_time > cutoff)
-            continue;
+            // Keep the minimum number of files per entity
+            int& entity_count = entity_counts[f.entity_id];
+            if (entity_count <= params.keep_per_entity)
+                continue;
+
+            entity_count--;
+            planned_mb += f.size_mb;
+            planned++;
+            chunk.push_back(f);
+        }
+        if (chunk.empty()) break;
+
+        int seq = journal.plan(chunk);
+        if (seq < 0) break;
+        for (auto& f : chunk) {
+            if (journal.remove(f, seq++)) {
+                freed += f.size_mb;
+                count++;
+            } else {
+                entity_counts[f.entity_id]++;
+            }
+        }
+    }
+    journal.close();
+
+    stats.files_deleted = count;
+    stats.mb_freed = freed;
+    return stats;
+}
+
+CleanupStats execute_cleanup(Database& db, OldestFirstIterator& oldest,
+                             double amount_to_delete_mb,
+                             const EvictionParams& params) {
+    CleanupStats stats{};
+    if (amount_to_delete_mb <= 0) return stats;
+
+    int max_deletions = params.max_deletions;
+    time_t now = time(nullptr);
+    time_t cutoff = now - (params.min_retention_hours * 3600);
+    struct tm lt;
+    localtime_s(&lt, &cutoff);
+    char cutoff_date[16];
+    snprintf(cutoff_date, sizeof(cutoff_date), "%04d-%02d-%02d",
+             lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
 
-        // Keep minimum 5 files per entity
-        EntityKey ek = {f.asset, f.index_val, f.category};
-        if (entity_counts[ek] <= 5)
+    double freed = 0;
+    int count = 0;
+    CleanupJournal journal(db, oldest.root(), "PREDICTIVE_CLEANUP", params.cold_root,
+                           params.verify_content);
+
+    DayFolder folder;
+    while (freed < amount_to_delete_mb && count < max_deletions && oldest.next_folder(folder)) {
+        // Folders arrive in date order: past the retention day nothing older remains
+        if (folder.date > cutoff_date)
+            break;
+
+        // Keep each entity's newest day folder
+        if (!folder.has_newer)
             continue;
 
-        // Delete file
-        try {
-            if (DeleteFileA(f.full_path.c_str())) {
-                // Log deletion
-                DeletionRecord dr;
-                dr.file_path = f.full_path;
-                dr.asset = f.asset;
-                dr.size_mb = f.size_mb;
-                dr.reason = "PREDICTIVE_CLEANUP";
-                db.log_deletion(dr);
+        // One plan per day folder, as if every deletion succeeds
+        std::vector<ScannedFile> chunk;
+        double planned_mb = freed;
+        int planned = count;
+        for (auto& f : list_day_files(folder)) {
+            if (planned_mb >= amount_to_delete_mb || planned >= max_deletions)
+                break;
+            if (f.created_time > cutoff)
+                continue;
+            planned_mb += f.size_mb;
+            planned++;
+            chunk.push_back(f);
+        }
 
+        int seq = journal.plan(chunk);
+        if (seq < 0) break;
+        for (auto& f : chunk) {
+            if (journal.remove(f, seq++)) {
                 freed += f.size_mb;
                 count++;
-                entity_counts[ek]--;
             }
-        } catch (...) {
-            // Skip files we can't delete
         }
     }
+    journal.close();
 
     stats.files_deleted = count;
     stats.mb_freed = freed;
     return stats;
 }
+
+CleanupStats execute_cleanup(Database& db, const std::string& root_path,
+                             const FileSpill& spill,
+                             double amount_to_delete_mb,
+                             const EvictionParams& params) {
+    CleanupStats stats{};
+    if (amount_to_delete_mb <= 0 || spill.files() == 0) return stats;
+
+    std::unique_ptr<FileSpill::Reader> reader = spill.open();
+    if (!reader) return stats;
+
+    time_t now = time(nullptr);
+    time_t cutoff = now - (params.min_retention_hours * 3600);
+    std::vector<int> entity_counts = spill.entity_counts();
+
+    double freed = 0;
+    int count = 0;
+    bool more = true;
+    CleanupJournal journal(db, root_path, "PREDICTIVE_CLEANUP", params.cold_root,
+                           params.verify_content);
+
+    ScannedFile f;
+    while (more && freed < amount_to_delete_mb && count < params.max_deletions) {
+        std::vector<ScannedFile> chunk;
+        double planned_mb = freed;
+        int planned = count;
+        while (chunk.size() < PLAN_CHUNK) {
+            if (planned_mb >= amount_to_delete_mb || planned >= params.max_deletions)
+                break;
+            // Files arrive in time order: past the retention cutoff nothing older remains
+            if (!reader->next(f) || f.created_time > cutoff) {
+                more = false;
+                break;
+            }
+
+            int& entity_count = entity_counts[f.entity_id];
+            if (entity_count <= params.keep_per_entity)
+                continue;
+
+            entity_count--;
+            planned_mb += f.size_mb;
+            planned++;
+            chunk.push_back(f);
+        }
+        if (chunk.empty()) break;
+
+        int seq = journal.plan(chunk);
+        if (seq < 0) break;
+        for (auto& c : chunk) {
+            if (journal.remove(c, seq++)) {
+                freed += c.size_mb;
+                count++;
+            } else {
+                entity_counts[c.entity_id]++;
+            }
+        }
+    }
+    journal.close();
+
+    stats.files_deleted = count;
+    stats.mb_freed = freed;
+    return stats;
+}
+
+CleanupStats cleanup_scan(Database& db, ScanResult& scan,
+                          double amount_to_delete_mb,
+                          const EvictionParams& params) {
+    // A spilled list is only available in time order, so the eviction
+    // policy is fifo whatever is configured
+    if (scan.spill)
+        return execute_cleanup(db, scan.root_path, *scan.spill, amount_to_delete_mb, params);
+    return execute_cleanup(db, scan.root_path, scan.all_files, amount_to_delete_mb, params);
+}
@@ -3,6 +3,9 @@
 
 #include "database.h"
 #include "scanner.h"
+#include "oldest_first.h"
+#include "eviction.h"
+#include <string>
 #include <vector>
 
 struct CleanupStats {
@@ -11,16 +14,63 @@ struct CleanupStats {
     double new_usage_mb;
 };
 
-// Evaluate whether cleanup is needed
+// Usage a cleanup reduces to when the caller gives no usable target
+static const double DEFAULT_TARGET_PCT = 70.0;
+
+// target_pct as it arrives through the API, either a fraction (0.70) or a
+// percentage (70), as a fraction of the limit; anything outside (0, 1)
+// after that falls back to DEFAULT_TARGET_PCT
+double target_fraction(double target_pct);
+
+// Evaluate whether cleanup is needed; a cleanup amount reduces usage to
+// target_pct of the limit
 // Returns: FIFO_ACTION_SAFE, _MONITOR, _CAUTION, or _CLEANUP
-int evaluate_threshold(double predicted_mb, double limit_mb, double* amount_to_delete);
+int evaluate_threshold(double predicted_mb, double limit_mb, double* amount_to_delete,
+                       double target_pct = DEFAULT_TARGET_PCT);
+
+// Lower edge in MB of the MONITOR, CAUTION or CLEANUP band
+double band_edge_mb(int action, double limit_mb);
+
+// Usage at which evaluate_threshold's action next changes upward, or -1
+// when usage is already in the cleanup band
+double next_band_mb(double usage_mb, double limit_mb);
+
+// Evaluate a predicted range: the action when both ends fall in the same
+// band (amount taken from the high end), -1 when the range straddles one
+int evaluate_threshold_interval(double low_mb, double high_mb, double limit_mb,
+                                double* amount_to_delete,
+                                double target_pct = DEFAULT_TARGET_PCT);
 
-// Execute FIFO cleanup: delete oldest files from E/F until target reached
-// min_retention_hours: skip files younger than this (default 24)
-// max_deletions: safety limit per cycle (default 500)
-CleanupStats execute_cleanup(Database& db, std::vector<ScannedFile>& files,
+// Execute cleanup: delete files in the order chosen by the configured
+// eviction policy until the target is reached. Files younger than
+// params.min_retention_hours are never touched, each entity keeps at least
+// params.keep_per_entity files, and at most params.max_deletions go per
+// cycle. Deletions are journaled (see CleanupJournal) against root_path.
+// With params.cold_root set, evicted files are tiered there instead.
+CleanupStats execute_cleanup(Database& db, const std::string& root_path,
+                             std::vector<ScannedFile>& files,
                              double amount_to_delete_mb,
-                             int min_retention_hours = 24,
-                             int max_deletions = 500);
+                             const EvictionParams& params);
+
+// Strict oldest-first cleanup driven by the lazy walk: only the day folders
+// that are actually consumed get their files listed. Each entity's newest
+// day folder is kept in place of the per-entity file minimum; the policy
+// selection does not apply, the retention and deletion limits do.
+CleanupStats execute_cleanup(Database& db, OldestFirstIterator& oldest,
+                             double amount_to_delete_mb,
+                             const EvictionParams& params);
+
+// Cleanup over a spilled scan (see FileSpill): strictly oldest first, read
+// back through the merge, with the retention, per-entity and deletion
+// limits of the in-memory path. A spill that failed deletes nothing.
+CleanupStats execute_cleanup(Database& db, const std::string& root_path,
+                             const FileSpill& spill,
+                             double amount_to_delete_mb,
+                             const EvictionParams& params);
+
+// Cleanup over whichever file list the scan ended up with
+CleanupStats cleanup_scan(Database& db, ScanResult& scan,
+                          double amount_to_delete_mb,
+                          const EvictionParams& params);
 
 #endif // CLEANUP_H
@@ -1,7 +1,19 @@
 #include "database.h"
+#include "db_manager.h"
+#include <cstdlib>
 #include <cstring>
 #include <cstdio>
 
+namespace {
+// Returns a cached statement to its unbound, idle state on scope exit, so a
+// half-read SELECT does not hold its read transaction open between calls
+struct StmtReset {
+    sqlite3_stmt* stmt;
+    explicit StmtReset(sqlite3_stmt* s) : stmt(s) {}
+    ~StmtReset() { sqlite3_reset(stmt); sqlite3_clear_bindings(stmt); }
+};
+}
+
 Database::Database() {}
 Database::~Database() { close(); }
 
@@ -9,14 +21,62 @@ int Database::open(const std::string& path) {
     if (db_) close();
     int rc = sqlite3_open(path.c_str(), &db_);
     if (rc != SQLITE_OK) return -1;
+    sqlite3_busy_timeout(db_, profile_.busy_timeout_ms);
     exec("PRAGMA journal_mode=WAL");
     exec("PRAGMA synchronous=NORMAL");
     exec("PRAGMA foreign_keys=ON");
-    return create_tables();
+    if (create_tables() != 0) return -1;
+    // Tuning only: a pragma this build does not support leaves SQLite's default
+    apply_profile();
+    return 0;
 }
 
 void Database::close() {
+    for (auto& kv : stmts_) sqlite3_finalize(kv.second);
+    stmts_.clear();
     if (db_) { sqlite3_close(db_); db_ = nullptr; }
+    end_transaction();
+}
+
+int Database::apply_profile() {
+    SqliteProfile p;
+    p.mmap_mb = std::atof(get_config("sqlite_mmap_mb", "256").c_str());
+    p.cache_mb = std::atof(get_config("sqlite_cache_mb", "16").c_str());
+    p.temp_store = get_config("sqlite_temp_store", "memory");
+    p.wal_autocheckpoint = std::atoi(get_config("sqlite_wal_autocheckpoint", "4000").c_str());
+    p.busy_timeout_ms = std::atoi(get_config("sqlite_busy_timeout_ms", "5000").c_str());
+    if (p.mmap_mb < 0) p.mmap_mb = 0;
+    if (p.cache_mb <= 0) p.cache_mb = 2;   // SQLite's own default
+    if (p.wal_autocheckpoint < 0) p.wal_autocheckpoint = 0;
+    if (p.busy_timeout_ms < 0) p.busy_timeout_ms = 0;
+
+    const char* temp = p.temp_store == "file" ? "1" : p.temp_store == "default" ? "0" : "2";
+    char sql[96];
+    int rc = 0;
+    snprintf(sql, sizeof(sql), "PRAGMA mmap_size=%lld", (long long)(p.mmap_mb * 1048576.0));
+    rc |= exec(sql);
+    // Negative cache_size is in KiB rather than pages
+    snprintf(sql, sizeof(sql), "PRAGMA cache_size=%lld", -(long long)(p.cache_mb * 1024.0));
+    rc |= exec(sql);
+    snprintf(sql, sizeof(sql), "PRAGMA temp_store=%s", temp);
+    rc |= exec(sql);
+    snprintf(sql, sizeof(sql), "PRAGMA wal_autocheckpoint=%d", p.wal_autocheckpoint);
+    rc |= exec(sql);
+    sqlite3_busy_timeout(db_, p.busy_timeout_ms);
+    profile_ = p;
+    return rc;
+}
+
+sqlite3_stmt* Database::cached(const char* sql) {
+    auto it = stmts_.find(sql);
+    if (it != stmts_.end()) return it->second;
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) {
+        sqlite3_finalize(stmt);
+        return nullptr;
+    }
+    stmts_[sql] = stmt;
+    return stmt;
 }
 
 int Database::exec(const char* sql) {
@@ -52,6 +112,19 @@ int Database::create_tables() {
             reason TEXT NOT NULL DEFAULT 'PREDICTIVE_CLEANUP',
             deleted_at TEXT DEFAULT (datetime('now','localtime'))
         ))",
+        R"(CREATE TABLE IF NOT EXISTS tiering_log (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            source_path TEXT NOT NULL,
+            dest_path TEXT NOT NULL,
+            asset TEXT NOT NULL,
+            size_mb REAL NOT NULL,
+            method TEXT NOT NULL,
+            moved_at TEXT DEFAULT (datetime('now','localtime'))
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS usage_sample (
+            sampled_at INTEGER PRIMARY KEY,
+            total_mb REAL NOT NULL
+        ))",
         R"(CREATE TABLE IF NOT EXISTS scheduler_config (
             id INTEGER PRIMARY KEY CHECK(id = 1),
             schedule_hour INTEGER NOT NULL DEFAULT 3,
@@ -63,9 +136,61 @@ int Database::create_tables() {
             key TEXT PRIMARY KEY,
             value TEXT NOT NULL
         ))",
+        R"(CREATE TABLE IF NOT EXISTS entities (
+            id INTEGER PRIMARY KEY,
+            asset TEXT NOT NULL,
+            index_val INTEGER NOT NULL,
+            category TEXT NOT NULL,
+            UNIQUE(asset, index_val, category)
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS daily_ingest (
+            entity_id INTEGER NOT NULL,
+            ingest_date TEXT NOT NULL,
+            size_mb REAL NOT NULL,
+            file_count INTEGER NOT NULL DEFAULT 0,
+            dir_mtime INTEGER NOT NULL DEFAULT 0,
+            held_mb REAL NOT NULL DEFAULT -1,
+            updated_at TEXT DEFAULT (datetime('now','localtime')),
+            PRIMARY KEY(entity_id, ingest_date)
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS cleanup_batch (
+            id INTEGER PRIMARY KEY AUTOINCREMENT,
+            root_path TEXT NOT NULL,
+            reason TEXT NOT NULL,
+            cold_root TEXT NOT NULL DEFAULT '',
+            lease_root TEXT NOT NULL DEFAULT '',
+            is_open INTEGER NOT NULL DEFAULT 1,
+            created_at TEXT DEFAULT (datetime('now','localtime')),
+            closed_at TEXT
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS cleanup_intent (
+            batch_id INTEGER NOT NULL,
+            seq INTEGER NOT NULL,
+            file_path TEXT NOT NULL,
+            entity_id INTEGER NOT NULL,
+            size_mb REAL NOT NULL,
+            state INTEGER NOT NULL DEFAULT 0,
+            dest_path TEXT NOT NULL DEFAULT '',
+            PRIMARY KEY(batch_id, seq)
+        ))",
+        R"(CREATE TABLE IF NOT EXISTS forecast_state (
+            entity_id INTEGER PRIMARY KEY,
+            window_days INTEGER NOT NULL,
+            first_day INTEGER NOT NULL,
+            last_day INTEGER NOT NULL,
+            open_day INTEGER NOT NULL,
+            open_mb REAL NOT NULL,
+            ring TEXT NOT NULL,
+            level REAL NOT NULL,
+            trend REAL NOT NULL,
+            season TEXT NOT NULL,
+            updated_at TEXT DEFAULT (datetime('now','localtime'))
+        ))",
         "CREATE INDEX IF NOT EXISTS idx_hist_date ON storage_history(measurement_date)",
+        "CREATE INDEX IF NOT EXISTS idx_ingest_date ON daily_ingest(ingest_date)",
         "CREATE INDEX IF NOT EXISTS idx_hist_asset ON storage_history(asset, index_val, category)",
         "CREATE INDEX IF NOT EXISTS idx_del_date ON deletion_log(deleted_at)",
+        "CREATE INDEX IF NOT EXISTS idx_del_asset_date ON deletion_log(asset, deleted_at)",
         R"(INSERT OR IGNORE INTO scheduler_config(id, schedule_hour, schedule_minute, is_enabled)
            VALUES(1, 3, 0, 0))",
         nullptr
@@ -73,14 +198,94 @@ int Database::create_tables() {
     for (int i = 0; sqls[i]; ++i) {
         if (exec(sqls[i]) != 0) return -1;
     }
+
+    // Columns added after the first release
+    if (!has_column("storage_history", "entity_id")) {
+        if (exec("ALTER TABLE storage_history ADD COLUMN entity_id INTEGER NOT NULL DEFAULT -1") != 0)
+            return -1;
+    }
+    if (!has_column("storage_history", "granularity")) {
+        // Older rows hold a single level per scan; recover it from the key shape
+        if (exec("ALTER TABLE storage_history ADD COLUMN granularity INTEGER NOT NULL DEFAULT 2") != 0)
+            return -1;
+        if (exec("UPDATE storage_history SET granularity = CASE "
+                 "WHEN index_val < 0 THEN 0 WHEN category = '*' THEN 1 ELSE 2 END") != 0)
+            return -1;
+    }
+    if (!has_column("cleanup_batch", "cold_root")) {
+        if (exec("ALTER TABLE cleanup_batch ADD COLUMN cold_root TEXT NOT NULL DEFAULT ''") != 0)
+            return -1;
+    }
+    if (!has_column("cleanup_intent", "dest_path")) {
+        if (exec("ALTER TABLE cleanup_intent ADD COLUMN dest_path TEXT NOT NULL DEFAULT ''") != 0)
+            return -1;
+    }
+    if (!has_column("daily_ingest", "held_mb")) {
+        if (exec("ALTER TABLE daily_ingest ADD COLUMN held_mb REAL NOT NULL DEFAULT -1") != 0)
+            return -1;
+    }
+    if (!has_column("cleanup_batch", "lease_root")) {
+        if (exec("ALTER TABLE cleanup_batch ADD COLUMN lease_root TEXT NOT NULL DEFAULT ''") != 0)
+            return -1;
+    }
+    if (!has_column("storage_forecast", "growth_mb")) {
+        if (exec("ALTER TABLE storage_forecast ADD COLUMN growth_mb REAL NOT NULL DEFAULT 0") != 0)
+            return -1;
+    }
+    if (exec("CREATE INDEX IF NOT EXISTS idx_hist_entity ON storage_history(entity_id, measurement_date)") != 0)
+        return -1;
+    if (exec("CREATE INDEX IF NOT EXISTS idx_hist_gran_date ON storage_history(granularity, measurement_date)") != 0)
+        return -1;
     return 0;
 }
 
-int Database::insert_snapshot(const StorageRecord& rec) {
-    const char* sql = "INSERT INTO storage_history(asset, index_val, category, measurement_date, size_mb, file_count) "
-                      "VALUES(?,?,?,?,?,?)";
+int Database::begin() {
+    // A writer that times out in the queue is left to the busy timeout
+    if (!in_write_queue_)
+        in_write_queue_ = write_queue().acquire(profile_.busy_timeout_ms);
+    int rc = exec("BEGIN");
+    if (rc != 0 && sqlite3_get_autocommit(db_)) end_transaction();
+    return rc;
+}
+
+int Database::commit() {
+    int rc = exec("COMMIT");
+    // A commit that failed busy leaves the transaction open for a retry or rollback
+    if (sqlite3_get_autocommit(db_)) end_transaction();
+    return rc;
+}
+
+int Database::rollback() {
+    int rc = exec("ROLLBACK");
+    if (sqlite3_get_autocommit(db_)) end_transaction();
+    return rc;
+}
+
+void Database::end_transaction() {
+    if (!in_write_queue_) return;
+    in_write_queue_ = false;
+    write_queue().release();
+}
+
+bool Database::has_column(const char* table, const char* column) {
+    std::string sql = std::string("PRAGMA table_info(") + table + ")";
     sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    bool found = false;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return false;
+    while (!found && sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* name = (const char*)sqlite3_column_text(stmt, 1);
+        found = name && strcmp(name, column) == 0;
+    }
+    sqlite3_finalize(stmt);
+    return found;
+}
+
+int Database::insert_snapshot(const StorageRecord& rec) {
+    const char* sql = "INSERT INTO storage_history(asset, index_val, category, measurement_date, size_mb, file_count, entity_id, granularity) "
+                      "VALUES(?,?,?,?,?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
     sqlite3_bind_text(stmt, 1, rec.asset.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_int(stmt, 2, rec.index_val);
     char cat[2] = { rec.category, 0 };
@@ -88,16 +293,18 @@ int Database::insert_snapshot(const StorageRecord& rec) {
     sqlite3_bind_text(stmt, 4, rec.date.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_double(stmt, 5, rec.size_mb);
     sqlite3_bind_int(stmt, 6, rec.file_count);
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    return rc == SQLITE_DONE ? 0 : -1;
+    sqlite3_bind_int(stmt, 7, rec.entity_id);
+    sqlite3_bind_int(stmt, 8, rec.granularity);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
 }
 
 std::vector<StorageRecord> Database::get_history(int days, const std::string& asset,
-                                                  int index_val, char category) {
+                                                  int index_val, char category, int granularity) {
     std::vector<StorageRecord> result;
-    std::string sql = "SELECT asset, index_val, category, measurement_date, size_mb, file_count "
-                      "FROM storage_history WHERE measurement_date >= date('now','localtime','-" +
+    std::string sql = "SELECT asset, index_val, category, measurement_date, size_mb, file_count, "
+                      "entity_id, granularity "
+                      "FROM storage_history WHERE granularity=" + std::to_string(granularity) +
+                      " AND measurement_date >= date('now','localtime','-" +
                       std::to_string(days) + " days')";
     if (!asset.empty()) sql += " AND asset='" + asset + "'";
     if (index_val >= 0) sql += " AND index_val=" + std::to_string(index_val);
@@ -115,31 +322,157 @@ std::vector<StorageRecord> Database::get_history(int days, const std::string& as
         r.date = (const char*)sqlite3_column_text(stmt, 3);
         r.size_mb = sqlite3_column_double(stmt, 4);
         r.file_count = sqlite3_column_int(stmt, 5);
+        r.entity_id = sqlite3_column_int(stmt, 6);
+        r.granularity = sqlite3_column_int(stmt, 7);
         result.push_back(r);
     }
     sqlite3_finalize(stmt);
     return result;
 }
 
-double Database::get_total_current_mb() {
-    const char* sql = "SELECT COALESCE(SUM(size_mb),0) FROM storage_history "
-                      "WHERE measurement_date = date('now','localtime')";
+int Database::upsert_ingest(const IngestRecord& rec) {
+    const char* sql = "INSERT OR REPLACE INTO daily_ingest(entity_id, ingest_date, size_mb, file_count, "
+                      "dir_mtime, held_mb) VALUES(?,?,?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, rec.entity_id);
+    sqlite3_bind_text(stmt, 2, rec.date.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 3, rec.size_mb);
+    sqlite3_bind_int(stmt, 4, rec.file_count);
+    sqlite3_bind_int64(stmt, 5, rec.dir_mtime);
+    sqlite3_bind_double(stmt, 6, rec.held_mb);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+std::vector<IngestRecord> Database::get_ingest(int days) {
+    std::vector<IngestRecord> result;
+    std::string sql = "SELECT entity_id, ingest_date, size_mb, file_count, dir_mtime FROM daily_ingest";
+    if (days >= 0)
+        sql += " WHERE ingest_date >= date('now','localtime','-" + std::to_string(days) + " days')";
+    sql += " ORDER BY ingest_date ASC, entity_id ASC";
     sqlite3_stmt* stmt = nullptr;
-    double total = 0;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        if (sqlite3_step(stmt) == SQLITE_ROW)
-            total = sqlite3_column_double(stmt, 0);
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        IngestRecord r;
+        r.entity_id = sqlite3_column_int(stmt, 0);
+        r.date = (const char*)sqlite3_column_text(stmt, 1);
+        r.size_mb = sqlite3_column_double(stmt, 2);
+        r.file_count = sqlite3_column_int(stmt, 3);
+        r.dir_mtime = sqlite3_column_int64(stmt, 4);
+        result.push_back(r);
     }
     sqlite3_finalize(stmt);
-    return total;
+    return result;
+}
+
+static void read_ingest_row(sqlite3_stmt* stmt, IngestRecord& r) {
+    r.entity_id = sqlite3_column_int(stmt, 0);
+    r.date = (const char*)sqlite3_column_text(stmt, 1);
+    r.size_mb = sqlite3_column_double(stmt, 2);
+    r.file_count = sqlite3_column_int(stmt, 3);
+    r.dir_mtime = sqlite3_column_int64(stmt, 4);
+    r.held_mb = sqlite3_column_double(stmt, 5);
 }
 
-int Database::insert_forecast(const std::string& date, double predicted_mb) {
-    const char* sql = "INSERT INTO storage_forecast(forecast_date, predicted_mb) VALUES(?,?)";
+bool Database::get_ingest_day(int entity_id, const std::string& date, IngestRecord& out) {
+    const char* sql = "SELECT entity_id, ingest_date, size_mb, file_count, dir_mtime, held_mb "
+                      "FROM daily_ingest WHERE entity_id=? AND ingest_date=?";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return false;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, entity_id);
+    sqlite3_bind_text(stmt, 2, date.c_str(), -1, SQLITE_TRANSIENT);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+    read_ingest_row(stmt, out);
+    return true;
+}
+
+bool Database::get_latest_ingest(int entity_id, IngestRecord& out) {
+    const char* sql = "SELECT entity_id, ingest_date, size_mb, file_count, dir_mtime, held_mb "
+                      "FROM daily_ingest WHERE entity_id=? ORDER BY ingest_date DESC LIMIT 1";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return false;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, entity_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+    read_ingest_row(stmt, out);
+    return true;
+}
+
+std::vector<IngestRecord> Database::get_ingest_totals(int days) {
+    std::vector<IngestRecord> result;
+    std::string sql =
+        "SELECT ingest_date, SUM(size_mb), SUM(file_count) FROM daily_ingest "
+        "WHERE ingest_date >= date('now','localtime','-" + std::to_string(days) + " days') "
+        "GROUP BY ingest_date ORDER BY ingest_date ASC";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        IngestRecord r;
+        r.entity_id = -1;
+        r.date = (const char*)sqlite3_column_text(stmt, 0);
+        r.size_mb = sqlite3_column_double(stmt, 1);
+        r.file_count = sqlite3_column_int(stmt, 2);
+        r.dir_mtime = 0;
+        result.push_back(r);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+int Database::insert_entity(const EntityRecord& rec) {
+    const char* sql = "INSERT OR IGNORE INTO entities(id, asset, index_val, category) VALUES(?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, rec.id);
+    sqlite3_bind_text(stmt, 2, rec.asset.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 3, rec.index_val);
+    char cat[2] = { rec.category, 0 };
+    sqlite3_bind_text(stmt, 4, cat, -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+int Database::find_entity(const std::string& asset, int index_val, char category) {
+    const char* sql = "SELECT id FROM entities WHERE asset=? AND index_val=? AND category=?";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_text(stmt, 1, asset.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 2, index_val);
+    char cat[2] = { category, 0 };
+    sqlite3_bind_text(stmt, 3, cat, -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_int(stmt, 0) : -1;
+}
+
+std::vector<EntityRecord> Database::get_entities() {
+    std::vector<EntityRecord> result;
+    const char* sql = "SELECT id, asset, index_val, category FROM entities ORDER BY id ASC";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        EntityRecord r;
+        r.id = sqlite3_column_int(stmt, 0);
+        const char* a = (const char*)sqlite3_column_text(stmt, 1);
+        r.asset = a ? a : "";
+        r.index_val = sqlite3_column_int(stmt, 2);
+        const char* c = (const char*)sqlite3_column_text(stmt, 3);
+        r.category = c ? c[0] : '*';
+        result.push_back(r);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+int Database::insert_forecast(const std::string& date, double predicted_mb, double growth_mb) {
+    const char* sql = "INSERT INTO storage_forecast(forecast_date, predicted_mb, growth_mb) "
+                      "VALUES(?,?,?)";
     sqlite3_stmt* stmt = nullptr;
     if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
     sqlite3_bind_text(stmt, 1, date.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_double(stmt, 2, predicted_mb);
+    sqlite3_bind_double(stmt, 3, growth_mb);
     int rc = sqlite3_step(stmt);
     sqlite3_finalize(stmt);
     return rc == SQLITE_DONE ? 0 : -1;
@@ -157,73 +490,389 @@ double Database::get_latest_forecast() {
     return val;
 }
 
-int Database::log_deletion(const DeletionRecord& rec) {
-    const char* sql = "INSERT INTO deletion_log(file_path, asset, size_mb, reason) VALUES(?,?,?,?)";
+double Database::get_latest_growth() {
+    const char* sql = "SELECT growth_mb FROM storage_forecast ORDER BY id DESC LIMIT 1";
+    sqlite3_stmt* stmt = nullptr;
+    double val = 0;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
+        if (sqlite3_step(stmt) == SQLITE_ROW)
+            val = sqlite3_column_double(stmt, 0);
+    }
+    sqlite3_finalize(stmt);
+    return val;
+}
+
+double Database::get_freed_since_forecast(const std::string& root_path) {
+    const char* sql =
+        "SELECT (SELECT COALESCE(SUM(size_mb), 0) FROM deletion_log "
+        "        WHERE deleted_at >= f.created_at AND substr(file_path, 1, length(?1)) = ?1) + "
+        "       (SELECT COALESCE(SUM(size_mb), 0) FROM tiering_log "
+        "        WHERE moved_at >= f.created_at AND substr(source_path, 1, length(?1)) = ?1) "
+        "FROM (SELECT created_at FROM storage_forecast ORDER BY id DESC LIMIT 1) f";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return 0;
+    StmtReset reset(stmt);
+    sqlite3_bind_text(stmt, 1, root_path.c_str(), -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_ROW ? sqlite3_column_double(stmt, 0) : 0;
+}
+
+double Database::get_cold_change(const std::string& cold_root, long long* tier_id,
+                                 long long* del_id) {
+    double change = 0;
+    sqlite3_stmt* stmt = cached(
+        "SELECT COALESCE(SUM(CASE WHEN substr(dest_path, 1, length(?1)) = ?1 THEN size_mb END), 0), "
+        "       COALESCE(MAX(id), ?2) FROM tiering_log WHERE id > ?2");
+    if (!stmt) return 0;
+    {
+        StmtReset reset(stmt);
+        sqlite3_bind_text(stmt, 1, cold_root.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, 2, *tier_id);
+        if (sqlite3_step(stmt) != SQLITE_ROW) return 0;
+        change += sqlite3_column_double(stmt, 0);
+        *tier_id = sqlite3_column_int64(stmt, 1);
+    }
+
+    stmt = cached(
+        "SELECT COALESCE(SUM(CASE WHEN substr(file_path, 1, length(?1)) = ?1 THEN size_mb END), 0), "
+        "       COALESCE(MAX(id), ?2) FROM deletion_log WHERE id > ?2");
+    if (!stmt) return change;
+    StmtReset reset(stmt);
+    sqlite3_bind_text(stmt, 1, cold_root.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int64(stmt, 2, *del_id);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return change;
+    change -= sqlite3_column_double(stmt, 0);
+    *del_id = sqlite3_column_int64(stmt, 1);
+    return change;
+}
+
+int Database::add_usage_sample(long long sampled_at, double total_mb) {
+    sqlite3_stmt* stmt = cached("INSERT OR REPLACE INTO usage_sample(sampled_at, total_mb) VALUES(?,?)");
+    if (!stmt) return -1;
+    {
+        StmtReset reset(stmt);
+        sqlite3_bind_int64(stmt, 1, sampled_at);
+        sqlite3_bind_double(stmt, 2, total_mb);
+        if (sqlite3_step(stmt) != SQLITE_DONE) return -1;
+    }
+
+    stmt = cached("DELETE FROM usage_sample WHERE sampled_at < ?");
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int64(stmt, 1, sampled_at - 60LL * 86400);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+std::vector<UsageSample> Database::get_usage_samples(long long since) {
+    std::vector<UsageSample> results;
+    const char* sql = "SELECT sampled_at, total_mb FROM usage_sample "
+                      "WHERE sampled_at >= ? ORDER BY sampled_at";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return results;
+    sqlite3_bind_int64(stmt, 1, since);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        UsageSample s;
+        s.sampled_at = sqlite3_column_int64(stmt, 0);
+        s.total_mb = sqlite3_column_double(stmt, 1);
+        results.push_back(s);
+    }
+    sqlite3_finalize(stmt);
+    return results;
+}
+
+bool Database::get_latest_usage(UsageSample& out) {
+    const char* sql = "SELECT sampled_at, total_mb FROM usage_sample "
+                      "ORDER BY sampled_at DESC LIMIT 1";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return false;
+    StmtReset reset(stmt);
+    if (sqlite3_step(stmt) != SQLITE_ROW) return false;
+    out.sampled_at = sqlite3_column_int64(stmt, 0);
+    out.total_mb = sqlite3_column_double(stmt, 1);
+    return true;
+}
+
+int Database::upsert_forecast_state(const ForecastStateRecord& rec) {
+    const char* sql = "INSERT OR REPLACE INTO forecast_state(entity_id, window_days, first_day, "
+                      "last_day, open_day, open_mb, ring, level, trend, season) "
+                      "VALUES(?,?,?,?,?,?,?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, rec.entity_id);
+    sqlite3_bind_int(stmt, 2, rec.window_days);
+    sqlite3_bind_int64(stmt, 3, rec.first_day);
+    sqlite3_bind_int64(stmt, 4, rec.last_day);
+    sqlite3_bind_int64(stmt, 5, rec.open_day);
+    sqlite3_bind_double(stmt, 6, rec.open_mb);
+    sqlite3_bind_text(stmt, 7, rec.ring.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 8, rec.level);
+    sqlite3_bind_double(stmt, 9, rec.trend);
+    sqlite3_bind_text(stmt, 10, rec.season.c_str(), -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+std::vector<ForecastStateRecord> Database::get_forecast_states() {
+    std::vector<ForecastStateRecord> result;
+    const char* sql = "SELECT entity_id, window_days, first_day, last_day, open_day, open_mb, "
+                      "ring, level, trend, season FROM forecast_state ORDER BY entity_id";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        ForecastStateRecord r;
+        r.entity_id = sqlite3_column_int(stmt, 0);
+        r.window_days = sqlite3_column_int(stmt, 1);
+        r.first_day = (long)sqlite3_column_int64(stmt, 2);
+        r.last_day = (long)sqlite3_column_int64(stmt, 3);
+        r.open_day = (long)sqlite3_column_int64(stmt, 4);
+        r.open_mb = sqlite3_column_double(stmt, 5);
+        r.ring = (const char*)sqlite3_column_text(stmt, 6);
+        r.level = sqlite3_column_double(stmt, 7);
+        r.trend = sqlite3_column_double(stmt, 8);
+        r.season = (const char*)sqlite3_column_text(stmt, 9);
+        result.push_back(r);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+int Database::clear_forecast_states() {
+    return exec("DELETE FROM forecast_state");
+}
+
+long long Database::open_cleanup_batch(const std::string& root_path, const std::string& reason,
+                                       const std::string& cold_root, const std::string& lease_root) {
+    const char* sql = "INSERT INTO cleanup_batch(root_path, reason, cold_root, lease_root) "
+                      "VALUES(?,?,?,?)";
     sqlite3_stmt* stmt = nullptr;
     if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    sqlite3_bind_text(stmt, 1, root_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, reason.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, cold_root.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 4, lease_root.c_str(), -1, SQLITE_TRANSIENT);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? (long long)sqlite3_last_insert_rowid(db_) : -1;
+}
+
+int Database::add_cleanup_intent(long long batch_id, int seq, const std::string& file_path,
+                                 int entity_id, double size_mb, const std::string& dest_path) {
+    const char* sql = "INSERT INTO cleanup_intent(batch_id, seq, file_path, entity_id, size_mb, "
+                      "dest_path) VALUES(?,?,?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int64(stmt, 1, batch_id);
+    sqlite3_bind_int(stmt, 2, seq);
+    sqlite3_bind_text(stmt, 3, file_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_int(stmt, 4, entity_id);
+    sqlite3_bind_double(stmt, 5, size_mb);
+    sqlite3_bind_text(stmt, 6, dest_path.c_str(), -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+int Database::mark_cleanup_intent(long long batch_id, int seq, int state) {
+    const char* sql = "UPDATE cleanup_intent SET state = ? WHERE batch_id = ? AND seq = ?";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_int(stmt, 1, state);
+    sqlite3_bind_int64(stmt, 2, batch_id);
+    sqlite3_bind_int(stmt, 3, seq);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+int Database::close_cleanup_batch(long long batch_id) {
+    const char* sql = "UPDATE cleanup_batch SET is_open = 0, closed_at = datetime('now','localtime') "
+                      "WHERE id = ?";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    sqlite3_bind_int64(stmt, 1, batch_id);
+    int rc = sqlite3_step(stmt);
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+std::vector<CleanupBatchRecord> Database::get_open_cleanup_batches() {
+    std::vector<CleanupBatchRecord> result;
+    const char* sql = "SELECT id, root_path, reason, cold_root, lease_root FROM cleanup_batch "
+                      "WHERE is_open = 1 ORDER BY id";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        CleanupBatchRecord r;
+        r.id = sqlite3_column_int64(stmt, 0);
+        r.root_path = (const char*)sqlite3_column_text(stmt, 1);
+        r.reason = (const char*)sqlite3_column_text(stmt, 2);
+        r.cold_root = (const char*)sqlite3_column_text(stmt, 3);
+        r.lease_root = (const char*)sqlite3_column_text(stmt, 4);
+        result.push_back(r);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+std::vector<CleanupIntentRecord> Database::get_planned_intents(long long batch_id) {
+    std::vector<CleanupIntentRecord> result;
+    const char* sql = "SELECT seq, file_path, entity_id, size_mb, dest_path FROM cleanup_intent "
+                      "WHERE batch_id = ? AND state = 0 ORDER BY seq";
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return result;
+    sqlite3_bind_int64(stmt, 1, batch_id);
+    while (sqlite3_step(stmt) == SQLITE_ROW) {
+        CleanupIntentRecord r;
+        r.batch_id = batch_id;
+        r.seq = sqlite3_column_int(stmt, 0);
+        r.file_path = (const char*)sqlite3_column_text(stmt, 1);
+        r.entity_id = sqlite3_column_int(stmt, 2);
+        r.size_mb = sqlite3_column_double(stmt, 3);
+        r.dest_path = (const char*)sqlite3_column_text(stmt, 4);
+        result.push_back(r);
+    }
+    sqlite3_finalize(stmt);
+    return result;
+}
+
+int Database::log_tiering(const TieringRecord& rec) {
+    const char* sql = "INSERT INTO tiering_log(source_path, dest_path, asset, size_mb, method) "
+                      "VALUES(?,?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
+    sqlite3_bind_text(stmt, 1, rec.source_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 2, rec.dest_path.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_text(stmt, 3, rec.asset.c_str(), -1, SQLITE_TRANSIENT);
+    sqlite3_bind_double(stmt, 4, rec.size_mb);
+    sqlite3_bind_text(stmt, 5, rec.method.c_str(), -1, SQLITE_TRANSIENT);
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
+}
+
+int Database::log_deletion(const DeletionRecord& rec) {
+    const char* sql = "INSERT INTO deletion_log(file_path, asset, size_mb, reason) VALUES(?,?,?,?)";
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
     sqlite3_bind_text(stmt, 1, rec.file_path.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, rec.asset.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_double(stmt, 3, rec.size_mb);
     sqlite3_bind_text(stmt, 4, rec.reason.c_str(), -1, SQLITE_TRANSIENT);
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    return rc == SQLITE_DONE ? 0 : -1;
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
 }
 
 std::vector<DeletionRecord> Database::get_deletion_logs(int limit) {
     std::vector<DeletionRecord> result;
-    std::string sql = "SELECT file_path, asset, size_mb, reason, deleted_at FROM deletion_log "
+    std::string sql = "SELECT id, file_path, asset, size_mb, reason, deleted_at FROM deletion_log "
                       "ORDER BY id DESC LIMIT " + std::to_string(limit);
     sqlite3_stmt* stmt = nullptr;
     if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return result;
     while (sqlite3_step(stmt) == SQLITE_ROW) {
         DeletionRecord r;
-        r.file_path = (const char*)sqlite3_column_text(stmt, 0);
-        r.asset = (const char*)sqlite3_column_text(stmt, 1);
-        r.size_mb = sqlite3_column_double(stmt, 2);
-        r.reason = (const char*)sqlite3_column_text(stmt, 3);
-        const char* ts = (const char*)sqlite3_column_text(stmt, 4);
-        r.timestamp = ts ? ts : "";
+        read_deletion_row(stmt, r);
         result.push_back(r);
     }
     sqlite3_finalize(stmt);
     return result;
 }
 
+void Database::read_deletion_row(sqlite3_stmt* stmt, DeletionRecord& r) {
+    r.id = sqlite3_column_int64(stmt, 0);
+    r.file_path = (const char*)sqlite3_column_text(stmt, 1);
+    r.asset = (const char*)sqlite3_column_text(stmt, 2);
+    r.size_mb = sqlite3_column_double(stmt, 3);
+    r.reason = (const char*)sqlite3_column_text(stmt, 4);
+    const char* ts = (const char*)sqlite3_column_text(stmt, 5);
+    r.timestamp = ts ? ts : "";
+}
+
+sqlite3_stmt* Database::prepare_deletion_query(const DeletionQuery& q, const DeletionKey* after,
+                                               int limit) {
+    std::string sql = "SELECT id, file_path, asset, size_mb, reason, deleted_at FROM deletion_log "
+                      "WHERE 1";
+    if (!q.from.empty()) sql += " AND deleted_at >= ?";
+    if (!q.to.empty()) sql += " AND deleted_at < ?";
+    if (!q.asset.empty()) sql += " AND asset = ?";
+    if (after) {
+        sql += q.newest_first ? " AND (deleted_at < ? OR (deleted_at = ? AND id < ?))"
+                              : " AND (deleted_at > ? OR (deleted_at = ? AND id > ?))";
+    }
+    sql += q.newest_first ? " ORDER BY deleted_at DESC, id DESC" : " ORDER BY deleted_at, id";
+    if (limit > 0) sql += " LIMIT " + std::to_string(limit);
+
+    sqlite3_stmt* stmt = nullptr;
+    if (sqlite3_prepare_v2(db_, sql.c_str(), -1, &stmt, nullptr) != SQLITE_OK) return nullptr;
+    int i = 1;
+    if (!q.from.empty()) sqlite3_bind_text(stmt, i++, q.from.c_str(), -1, SQLITE_TRANSIENT);
+    if (!q.to.empty()) sqlite3_bind_text(stmt, i++, q.to.c_str(), -1, SQLITE_TRANSIENT);
+    if (!q.asset.empty()) sqlite3_bind_text(stmt, i++, q.asset.c_str(), -1, SQLITE_TRANSIENT);
+    if (after) {
+        sqlite3_bind_text(stmt, i++, after->deleted_at.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_text(stmt, i++, after->deleted_at.c_str(), -1, SQLITE_TRANSIENT);
+        sqlite3_bind_int64(stmt, i++, after->id);
+    }
+    return stmt;
+}
+
+int Database::get_deletion_page(const DeletionQuery& q, const DeletionKey* after, int limit,
+                                std::vector<DeletionRecord>& out) {
+    out.clear();
+    sqlite3_stmt* stmt = prepare_deletion_query(q, after, limit);
+    if (!stmt) return -1;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        out.emplace_back();
+        read_deletion_row(stmt, out.back());
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
+int Database::stream_deletions(const DeletionQuery& q, DeletionRowFn row, void* ctx) {
+    sqlite3_stmt* stmt = prepare_deletion_query(q, nullptr, 0);
+    if (!stmt) return -1;
+    DeletionRecord r;
+    int rc;
+    while ((rc = sqlite3_step(stmt)) == SQLITE_ROW) {
+        read_deletion_row(stmt, r);
+        if (!row(r, ctx)) {
+            rc = SQLITE_DONE;
+            break;
+        }
+    }
+    sqlite3_finalize(stmt);
+    return rc == SQLITE_DONE ? 0 : -1;
+}
+
 int Database::set_config(const std::string& key, const std::string& value) {
     const char* sql = "INSERT OR REPLACE INTO configuration(key, value) VALUES(?,?)";
-    sqlite3_stmt* stmt = nullptr;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) != SQLITE_OK) return -1;
+    sqlite3_stmt* stmt = cached(sql);
+    if (!stmt) return -1;
+    StmtReset reset(stmt);
     sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
     sqlite3_bind_text(stmt, 2, value.c_str(), -1, SQLITE_TRANSIENT);
-    int rc = sqlite3_step(stmt);
-    sqlite3_finalize(stmt);
-    return rc == SQLITE_DONE ? 0 : -1;
+    return sqlite3_step(stmt) == SQLITE_DONE ? 0 : -1;
 }
 
 std::string Database::get_config(const std::string& key, const std::string& default_val) {
-    const char* sql = "SELECT value FROM configuration WHERE key=?";
-    sqlite3_stmt* stmt = nullptr;
+    sqlite3_stmt* stmt = cached("SELECT value FROM configuration WHERE key=?");
+    if (!stmt) return default_val;
+    StmtReset reset(stmt);
+    sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
     std::string val = default_val;
-    if (sqlite3_prepare_v2(db_, sql, -1, &stmt, nullptr) == SQLITE_OK) {
-        sqlite3_bind_text(stmt, 1, key.c_str(), -1, SQLITE_TRANSIENT);
-        if (sqlite3_step(stmt) == SQLITE_ROW) {
-            const char* v = (const char*)sqlite3_column_text(stmt, 0);
-            if (v) val = v;
-        }
+    if (sqlite3_step(stmt) == SQLITE_ROW) {
+        const char* v = (const char*)sqlite3_column_text(stmt, 0);
+        if (v) val = v;
     }
-    sqlite3_finalize(stmt);
     return val;
 }
 
-std::vector<WeightRecord> Database::get_average_weights(int days) {
+std::vector<WeightRecord> Database::get_average_weights(int days, int granularity) {
     std::vector<WeightRecord> result;
     std::string sql =
         "SELECT asset, index_val, category, "
         "AVG(size_mb) as avg_mb, SUM(size_mb) as total_mb, "
         "COUNT(DISTINCT measurement_date) as day_count "
         "FROM storage_history "
-        "WHERE measurement_date >= date('now','localtime','-" + std::to_string(days) + " days') "
+        "WHERE granularity = " + std::to_string(granularity) + " "
+        "AND measurement_date >= date('now','localtime','-" + std::to_string(days) + " days') "
         "GROUP BY asset, index_val, category "
         "ORDER BY asset, index_val, category";
     sqlite3_stmt* stmt = nullptr;
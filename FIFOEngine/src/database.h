@@ -2,11 +2,14 @@
 #define DATABASE_H
 
 #include "sqlite3.h"
+#include <map>
 #include <string>
 #include <vector>
 #include <ctime>
 
 struct StorageRecord {
+    int         entity_id = -1;
+    int         granularity = 2;  // FIFO_GRAN_* level of this row
     std::string asset;
     int         index_val;
     char        category; // 'E', 'F', or '*' (all)
@@ -15,6 +18,61 @@ struct StorageRecord {
     int         file_count;
 };
 
+struct IngestRecord {
+    int         entity_id;   // -1 for totals over all entities
+    std::string date;        // YYYY-MM-DD of the Day folder
+    double      size_mb;
+    int         file_count;
+    long long   dir_mtime;   // Day folder write time when measured
+    double      held_mb = -1; // folder size at dir_mtime once eviction shrank it
+                              // below size_mb; -1 while nothing was evicted
+};
+
+struct EntityRecord {
+    int         id;
+    std::string asset;
+    int         index_val;
+    char        category;
+};
+
+struct ForecastStateRecord {
+    int         entity_id;    // -1 for the total over all entities
+    int         window_days;
+    long        first_day;    // day ordinals (days since 1970-01-01), -1 if unset
+    long        last_day;
+    long        open_day;
+    double      open_mb;
+    std::string ring;         // closed-day ingest, oldest first, space separated
+    double      level;
+    double      trend;
+    std::string season;       // 7 day-of-week indices, space separated
+};
+
+struct CleanupBatchRecord {
+    long long   id;
+    std::string root_path;
+    std::string reason;      // deletion_log reason for the batch's files
+    std::string cold_root;   // files move here instead of being deleted; empty = delete
+    std::string lease_root;  // root whose lease covered the batch; differs from
+                             // root_path when evicting from the cold tier
+};
+
+struct CleanupIntentRecord {
+    long long   batch_id;
+    int         seq;
+    std::string file_path;
+    int         entity_id;
+    double      size_mb;
+    std::string dest_path;   // cold-tier batches: where the file is moved, chosen when planned
+};
+
+// cleanup_intent.state values
+enum IntentState {
+    INTENT_PLANNED = 0,
+    INTENT_DELETED = 1,  // gone from the root: deleted, or moved to the cold root
+    INTENT_SKIPPED = 2   // could not be deleted (locked, permissions)
+};
+
 struct WeightRecord {
     std::string asset;
     int         index_val;
@@ -33,7 +91,21 @@ struct FileRecord {
     char        category;
 };
 
+struct TieringRecord {
+    std::string source_path;
+    std::string dest_path;
+    std::string asset;
+    double      size_mb;
+    std::string method;      // RENAME, COPY, or RESUMED when reconciled at init
+};
+
+struct UsageSample {
+    long long sampled_at;    // unix time of the exact scan
+    double    total_mb;
+};
+
 struct DeletionRecord {
+    long long   id = 0;
     std::string file_path;
     std::string asset;
     double      size_mb;
@@ -41,6 +113,33 @@ struct DeletionRecord {
     std::string timestamp;
 };
 
+// Filter for deletion_log reads; empty strings leave a bound open
+struct DeletionQuery {
+    std::string from;          // deleted_at >= from ("YYYY-MM-DD[ HH:MM:SS]")
+    std::string to;            // deleted_at <  to
+    std::string asset;
+    bool        newest_first = true;
+};
+
+// Keyset position: (deleted_at, id) of the last row already returned
+struct DeletionKey {
+    std::string deleted_at;
+    long long   id = 0;
+};
+
+// Row callback for stream_deletions; return false to stop
+typedef bool (*DeletionRowFn)(const DeletionRecord& rec, void* ctx);
+
+// SQLite tuning applied to every connection at open, from the sqlite_*
+// configuration keys
+struct SqliteProfile {
+    double mmap_mb = 256;            // sqlite_mmap_mb: memory-mapped reads, 0 = off
+    double cache_mb = 16;            // sqlite_cache_mb: page cache per connection
+    std::string temp_store = "memory";  // sqlite_temp_store: memory, file or default
+    int wal_autocheckpoint = 4000;   // sqlite_wal_autocheckpoint: pages, 0 = manual
+    int busy_timeout_ms = 5000;      // sqlite_busy_timeout_ms: wait for another writer
+};
+
 class Database {
 public:
     Database();
@@ -53,29 +152,104 @@ public:
     // Schema
     int create_tables();
 
+    // Re-read the sqlite_* keys and apply them to this connection
+    int apply_profile();
+    const SqliteProfile& profile() const { return profile_; }
+
+    // Transactions (batch writes). begin() waits for this process's
+    // earlier writers first (see WriteQueue).
+    int begin();
+    int commit();
+    int rollback();
+
     // Storage history
     int insert_snapshot(const StorageRecord& rec);
+    // Every scan stores all three granularities; queries pick one level
     std::vector<StorageRecord> get_history(int days, const std::string& asset = "",
-                                           int index_val = -1, char category = '*');
-    double get_total_current_mb();
-    std::vector<WeightRecord> get_average_weights(int days = 14);
+                                           int index_val = -1, char category = '*',
+                                           int granularity = 2);
+    std::vector<WeightRecord> get_average_weights(int days = 14, int granularity = 2);
     int get_history_day_count();
 
+    // Per-day ingest (bytes that landed in each Day folder)
+    int upsert_ingest(const IngestRecord& rec);
+    std::vector<IngestRecord> get_ingest(int days);         // days < 0: all rows
+    std::vector<IngestRecord> get_ingest_totals(int days);  // summed per date, oldest first
+    // One entity's row for a date, and its newest row; primary key seeks
+    bool get_ingest_day(int entity_id, const std::string& date, IngestRecord& out);
+    bool get_latest_ingest(int entity_id, IngestRecord& out);
+
+    // Entity ids (see EntityRegistry)
+    int insert_entity(const EntityRecord& rec);
+    int find_entity(const std::string& asset, int index_val, char category);  // id or -1
+    std::vector<EntityRecord> get_entities();
+
     // Forecast
-    int insert_forecast(const std::string& date, double predicted_mb);
+    int insert_forecast(const std::string& date, double predicted_mb, double growth_mb = 0);
     double get_latest_forecast();
+    double get_latest_growth();   // MB/day stored with the latest forecast
+    // MB deleted or tiered out of root_path since the latest forecast was
+    // stored; a cycle stores its forecast before it cleans up
+    double get_freed_since_forecast(const std::string& root_path);
+    // Net MB moved into cold_root (tiering_log) less MB deleted from it
+    // (deletion_log) in rows after *tier_id / *del_id; both ids advance to
+    // the last row read
+    double get_cold_change(const std::string& cold_root, long long* tier_id, long long* del_id);
+
+    // Total usage after every exact scan, for the intraday model. Samples
+    // older than 60 days are dropped as new ones arrive.
+    int add_usage_sample(long long sampled_at, double total_mb);
+    std::vector<UsageSample> get_usage_samples(long long since);
+    // Newest sample, i.e. the total of the last exact scan; false if none
+    bool get_latest_usage(UsageSample& out);
+
+    // Incremental forecast state (see ForecastState)
+    int upsert_forecast_state(const ForecastStateRecord& rec);
+    std::vector<ForecastStateRecord> get_forecast_states();
+    int clear_forecast_states();
+
+    // Cleanup intent journal (see CleanupJournal)
+    long long open_cleanup_batch(const std::string& root_path, const std::string& reason,
+                                 const std::string& cold_root = "", const std::string& lease_root = "");
+    int add_cleanup_intent(long long batch_id, int seq, const std::string& file_path,
+                           int entity_id, double size_mb, const std::string& dest_path = "");
+    int mark_cleanup_intent(long long batch_id, int seq, int state);
+    int close_cleanup_batch(long long batch_id);
+    std::vector<CleanupBatchRecord> get_open_cleanup_batches();
+    std::vector<CleanupIntentRecord> get_planned_intents(long long batch_id);
+
+    // Tiering log
+    int log_tiering(const TieringRecord& rec);
 
     // Deletion log
     int log_deletion(const DeletionRecord& rec);
     std::vector<DeletionRecord> get_deletion_logs(int limit = 100);
 
+    // One page of at most limit rows after `after` (nullptr = first page),
+    // ordered on (deleted_at, id) so each page is an index range seek
+    int get_deletion_page(const DeletionQuery& q, const DeletionKey* after, int limit,
+                          std::vector<DeletionRecord>& out);
+
+    // Every matching row, one at a time, without collecting them
+    int stream_deletions(const DeletionQuery& q, DeletionRowFn row, void* ctx);
+
     // Configuration
     int set_config(const std::string& key, const std::string& value);
     std::string get_config(const std::string& key, const std::string& default_val = "");
 
 private:
     sqlite3* db_ = nullptr;
+    SqliteProfile profile_;
+    bool in_write_queue_ = false;
+    // Prepared once per connection for the fixed-text statements a cycle runs
+    // per row (snapshots, ingest, intents, log rows, config); finalized by close()
+    std::map<std::string, sqlite3_stmt*> stmts_;
+    sqlite3_stmt* cached(const char* sql);
+    void end_transaction();
     int exec(const char* sql);
+    bool has_column(const char* table, const char* column);
+    sqlite3_stmt* prepare_deletion_query(const DeletionQuery& q, const DeletionKey* after, int limit);
+    static void read_deletion_row(sqlite3_stmt* stmt, DeletionRecord& r);
 };
 
 #endif // DATABASE_H
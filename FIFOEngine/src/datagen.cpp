@@ -1,4 +1,6 @@
 #include "datagen.h"
+#include "entity_registry.h"
+#include "forecast_state.h"
 #include <algorithm>
 #include <fstream>
 #include <ctime>
@@ -137,6 +139,7 @@ int generate_test_data(Database& db, const std::string& root_path,
                     double file_mb = ((double)bytes_per_file * growth) / (1024.0 * 1024.0);
 
                     StorageRecord rec;
+                    rec.entity_id = entity_registry().intern(assets[a], idx, cats[c]);
                     rec.asset = assets[a];
                     rec.index_val = idx;
                     rec.category = cats[c];
@@ -144,11 +147,21 @@ int generate_test_data(Database& db, const std::string& root_path,
                     rec.size_mb = file_mb;
                     rec.file_count = 1;
                     db.insert_snapshot(rec);
+
+                    IngestRecord ing;
+                    ing.entity_id = rec.entity_id;
+                    ing.date = date;
+                    ing.size_mb = file_mb;
+                    ing.file_count = 1;
+                    ing.dir_mtime = 0;
+                    db.upsert_ingest(ing);
                 }
             }
         }
     }
 
+    entity_registry().persist(db);
+    forecast_state().invalidate();  // ingest rows were written directly
     if (cb) cb(100, "Test data generation complete");
     return 0;
 }
@@ -206,6 +219,7 @@ int generate_one_day(Database& db, const std::string& root_path,
 
                 // Store in DB
                 StorageRecord rec;
+                rec.entity_id = entity_registry().intern(assets[a], idx, cats[c]);
                 rec.asset = assets[a];
                 rec.index_val = idx;
                 rec.category = cats[c];
@@ -214,6 +228,14 @@ int generate_one_day(Database& db, const std::string& root_path,
                 rec.file_count = 1;
                 db.insert_snapshot(rec);
 
+                IngestRecord ing;
+                ing.entity_id = rec.entity_id;
+                ing.date = date;
+                ing.size_mb = file_mb;
+                ing.file_count = 1;
+                ing.dir_mtime = 0;
+                db.upsert_ingest(ing);
+
                 entity_idx++;
                 if (cb) {
                     int pct = (int)((entity_idx * 100) / total_entities);
@@ -225,6 +247,8 @@ int generate_one_day(Database& db, const std::string& root_path,
         }
     }
 
+    entity_registry().persist(db);
+    forecast_state().invalidate();  // ingest rows were written directly
     if (cb) cb(100, "One day of data generated");
     return 0;
 }
@@ -0,0 +1,62 @@
+#include "db_manager.h"
+#include <algorithm>
+#include <chrono>
+
+bool WriteQueue::acquire(int timeout_ms) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    std::thread::id self = std::this_thread::get_id();
+    if (depth_ > 0 && owner_ == self) {
+        depth_++;
+        return true;
+    }
+
+    unsigned long long ticket = next_ticket_++;
+    waiting_.push_back(ticket);
+    bool turn = cv_.wait_for(lock, std::chrono::milliseconds(std::max(timeout_ms, 0)), [&] {
+        return depth_ == 0 && waiting_.front() == ticket;
+    });
+    if (!turn) {
+        waiting_.erase(std::find(waiting_.begin(), waiting_.end(), ticket));
+        cv_.notify_all();
+        return false;
+    }
+    waiting_.pop_front();
+    owner_ = self;
+    depth_ = 1;
+    return true;
+}
+
+void WriteQueue::release() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (depth_ == 0 || --depth_ > 0) return;
+    owner_ = std::thread::id();
+    cv_.notify_all();
+}
+
+WriteQueue& write_queue() {
+    static WriteQueue instance;
+    return instance;
+}
+
+DbManager::Session DbManager::acquire(const std::string& path) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    if (!db_.is_open() || path != path_) {
+        path_ = path;
+        if (db_.open(path) != 0) {
+            db_.close();
+            return Session();
+        }
+    }
+    return Session(std::move(lock), &db_);
+}
+
+void DbManager::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    db_.close();
+    path_.clear();
+}
+
+DbManager& db_manager() {
+    static DbManager instance;
+    return instance;
+}
@@ -0,0 +1,73 @@
+#ifndef DB_MANAGER_H
+#define DB_MANAGER_H
+
+#include "database.h"
+#include <condition_variable>
+#include <deque>
+#include <mutex>
+#include <string>
+#include <thread>
+
+// Orders write transactions across every connection in the process
+// (Database::begin takes a place, commit or rollback gives it up), so the
+// API, the scheduler and admission queue up in arrival order instead of
+// racing for SQLite's write lock. A thread that already holds the queue
+// can begin on another connection. A waiter gives up after timeout_ms and
+// is left to SQLite's busy timeout, so the queue can delay a writer but
+// never deadlock one.
+class WriteQueue {
+public:
+    // True when the caller now holds the queue and must release() it
+    bool acquire(int timeout_ms);
+    void release();
+
+private:
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<unsigned long long> waiting_;   // tickets, oldest first
+    unsigned long long next_ticket_ = 0;
+    std::thread::id owner_;
+    int depth_ = 0;
+};
+
+WriteQueue& write_queue();
+
+// The process's long-lived connection, shared by the API and the scheduler
+// thread. Opening a Database runs the schema checks and pragmas and starts
+// with a cold page cache, which a short interval cycle paid on every run;
+// the manager opens it once and hands it to one user at a time. The API
+// takes it after g_mutex for the length of each entry point.
+class DbManager {
+public:
+    // Exclusive use of the connection for as long as it lives
+    class Session {
+    public:
+        Session() {}
+        Session(std::unique_lock<std::mutex> lock, Database* db)
+            : lock_(std::move(lock)), db_(db) {}
+
+        explicit operator bool() const { return db_ != nullptr; }
+        Database& operator*() const { return *db_; }
+        Database* operator->() const { return db_; }
+
+    private:
+        std::unique_lock<std::mutex> lock_;
+        Database* db_ = nullptr;
+    };
+
+    // The connection to path, opened on first use or when the path changes;
+    // an empty session when it cannot be opened
+    Session acquire(const std::string& path);
+
+    void close();
+
+private:
+    std::mutex mutex_;
+    Database db_;
+    std::string path_;
+};
+
+// Process-wide manager shared by the API and scheduled cycles
+DbManager& db_manager();
+
+#endif // DB_MANAGER_H
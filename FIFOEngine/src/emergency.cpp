@@ -0,0 +1,137 @@
+#include "emergency.h"
+#include "journal.h"
+#include "oldest_first.h"
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <ctime>
+#include <vector>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// Files per plan() call: a step only checks its clock between files, and a
+// small plan keeps what is left journaled when the step ends mid-folder
+static const size_t EMERGENCY_CHUNK = 16;
+
+EmergencyParams load_emergency_params(Database& db) {
+    EmergencyParams p;
+    p.hard_pct = std::atof(db.get_config("emergency_hard_pct", "97").c_str());
+    p.soft_pct = std::atof(db.get_config("emergency_soft_pct", "92").c_str());
+    p.step_ms = std::atoi(db.get_config("emergency_step_ms", "500").c_str());
+    p.max_secs = std::atoi(db.get_config("emergency_max_secs", "30").c_str());
+    if (p.hard_pct < 0 || p.hard_pct > 100) p.hard_pct = 0;
+    if (p.soft_pct <= 0 || p.soft_pct >= p.hard_pct) p.soft_pct = p.hard_pct - 5;
+    if (p.step_ms < 50) p.step_ms = 50;
+    if (p.max_secs < 1) p.max_secs = 1;
+    return p;
+}
+
+bool volume_space(const std::string& path, VolumeSpace& out) {
+    ULARGE_INTEGER avail, total, total_free;
+    if (!GetDiskFreeSpaceExA(path.c_str(), &avail, &total, &total_free)) return false;
+    if (total.QuadPart == 0) return false;
+    out.total_mb = total.QuadPart / (1024.0 * 1024.0);
+    out.free_mb = total_free.QuadPart / (1024.0 * 1024.0);
+    out.used_pct = (out.total_mb - out.free_mb) / out.total_mb * 100.0;
+    return true;
+}
+
+EmergencyStats run_emergency(Database& db, const std::string& root_path,
+                             const EvictionParams& eviction) {
+    typedef std::chrono::steady_clock clock;
+    EmergencyStats stats{};
+    auto start = clock::now();
+
+    EmergencyParams params = load_emergency_params(db);
+    VolumeSpace vol;
+    if (params.hard_pct <= 0 || !volume_space(root_path, vol)) return stats;
+    stats.used_pct_before = vol.used_pct;
+    stats.used_pct_after = vol.used_pct;
+    if (vol.used_pct < params.hard_pct) return stats;
+    stats.triggered = true;
+
+    time_t cutoff = time(nullptr) - (eviction.min_retention_hours * 3600);
+    struct tm lt;
+    localtime_s(&lt, &cutoff);
+    char cutoff_date[16];
+    snprintf(cutoff_date, sizeof(cutoff_date), "%04d-%02d-%02d",
+             lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
+
+    // Tiering would only move the data within the volume in the common
+    // case, so the journal gets no cold root
+    CleanupJournal journal(db, root_path, "EMERGENCY_CLEANUP");
+    OldestFirstIterator oldest(root_path);
+    auto deadline = start + std::chrono::seconds(params.max_secs);
+
+    // Files of the current day folder not yet deleted; a step that runs out
+    // of time leaves the rest for the next one
+    std::vector<ScannedFile> pending;
+    size_t pos = 0;
+    bool exhausted = false;
+
+    while (!exhausted && stats.files_deleted < eviction.max_deletions && clock::now() < deadline) {
+        double excess_mb = vol.total_mb * (vol.used_pct - params.soft_pct) / 100.0;
+        if (excess_mb <= 0) break;
+        double step_freed = 0;
+        auto step_end = clock::now() + std::chrono::milliseconds(params.step_ms);
+
+        while (step_freed < excess_mb && stats.files_deleted < eviction.max_deletions &&
+               clock::now() < step_end) {
+            if (pos == pending.size()) {
+                // Next eligible day folder; folders arrive in date order, so
+                // past the retention day nothing older remains
+                DayFolder folder;
+                pending.clear();
+                pos = 0;
+                while (pending.empty()) {
+                    if (!oldest.next_folder(folder) || folder.date > cutoff_date) {
+                        exhausted = true;
+                        break;
+                    }
+                    if (!folder.has_newer) continue;
+                    for (auto& f : list_day_files(folder)) {
+                        if (f.created_time <= cutoff) pending.push_back(f);
+                    }
+                }
+                if (exhausted) break;
+            }
+
+            std::vector<ScannedFile> chunk;
+            double planned_mb = step_freed;
+            int planned = stats.files_deleted;
+            for (; pos < pending.size() && chunk.size() < EMERGENCY_CHUNK; ++pos) {
+                if (planned_mb >= excess_mb || planned >= eviction.max_deletions) break;
+                planned_mb += pending[pos].size_mb;
+                planned++;
+                chunk.push_back(pending[pos]);
+            }
+
+            int seq = journal.plan(chunk);
+            if (seq < 0) {
+                exhausted = true;
+                break;
+            }
+            for (auto& f : chunk) {
+                if (journal.remove(f, seq++)) {
+                    step_freed += f.size_mb;
+                    stats.files_deleted++;
+                }
+            }
+        }
+
+        stats.mb_freed += step_freed;
+        stats.steps++;
+
+        // Measured, not estimated: other writers keep filling the volume
+        if (!volume_space(root_path, vol)) break;
+        stats.used_pct_after = vol.used_pct;
+        if (vol.used_pct <= params.soft_pct) break;
+    }
+    journal.close();
+
+    stats.elapsed_ms = std::chrono::duration<double, std::milli>(clock::now() - start).count();
+    return stats;
+}
@@ -0,0 +1,49 @@
+#ifndef EMERGENCY_H
+#define EMERGENCY_H
+
+#include "database.h"
+#include "eviction.h"
+#include <string>
+
+// Watermarks on the measured fill of the root's volume, from the
+// configuration table
+struct EmergencyParams {
+    double hard_pct = 97;     // emergency_hard_pct: used % that triggers, 0 = off
+    double soft_pct = 92;     // emergency_soft_pct: stop once back under
+    int    step_ms = 500;     // emergency_step_ms: time budget of one step
+    int    max_secs = 30;     // emergency_max_secs: time budget of the run
+};
+
+EmergencyParams load_emergency_params(Database& db);
+
+struct VolumeSpace {
+    double total_mb;
+    double free_mb;
+    double used_pct;
+};
+
+// Size and free space of the volume holding path; false if it cannot be queried
+bool volume_space(const std::string& path, VolumeSpace& out);
+
+struct EmergencyStats {
+    bool   triggered;         // the volume was past the hard watermark
+    int    files_deleted;
+    double mb_freed;
+    int    steps;
+    double used_pct_before;
+    double used_pct_after;
+    double elapsed_ms;
+};
+
+// Emergency eviction. When the root's volume is past the hard watermark,
+// deletes the oldest eligible day folders, without a scan or forecast,
+// until the volume is back under the soft watermark. Work is done in steps
+// of at most step_ms: each step deletes from the oldest-first walk until
+// the estimated excess is freed or its time is up, then free space is
+// measured again. Retention, the per-entity newest folder and
+// max_deletions still apply; files are always deleted, never tiered.
+// Returns with triggered = false after one free-space query otherwise.
+EmergencyStats run_emergency(Database& db, const std::string& root_path,
+                             const EvictionParams& eviction);
+
+#endif // EMERGENCY_H
@@ -0,0 +1,158 @@
+#include "entity_registry.h"
+
+EntityRegistry::EntityRegistry() {
+    rehash(64);
+}
+
+size_t EntityRegistry::hash_key(const std::string& asset, int index_val, char category) {
+    // FNV-1a over the asset name, index and category
+    unsigned long long h = 1469598103934665603ULL;
+    for (unsigned char c : asset) {
+        h ^= c;
+        h *= 1099511628211ULL;
+    }
+    h ^= (unsigned long long)(unsigned int)index_val;
+    h *= 1099511628211ULL;
+    h ^= (unsigned char)category;
+    h *= 1099511628211ULL;
+    return (size_t)h;
+}
+
+int EntityRegistry::probe(const std::string& asset, int index_val, char category,
+                          size_t hash) const {
+    size_t mask = slots_.size() - 1;
+    for (size_t i = hash & mask; ; i = (i + 1) & mask) {
+        int id = slots_[i];
+        if (id < 0) return -1;
+        if (hashes_[id] != hash) continue;
+        const EntityKey& k = keys_[id];
+        if (k.index_val == index_val && k.category == category && k.asset == asset)
+            return id;
+    }
+}
+
+void EntityRegistry::insert_slot(int id, size_t hash) {
+    size_t mask = slots_.size() - 1;
+    size_t i = hash & mask;
+    while (slots_[i] >= 0) i = (i + 1) & mask;
+    slots_[i] = id;
+}
+
+void EntityRegistry::rehash(size_t capacity) {
+    slots_.assign(capacity, -1);
+    for (int id = 0; id < (int)keys_.size(); ++id)
+        insert_slot(id, hashes_[id]);
+}
+
+int EntityRegistry::intern(const std::string& asset, int index_val, char category) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    size_t h = hash_key(asset, index_val, category);
+    int id = probe(asset, index_val, category, h);
+    if (id >= 0) return id;
+
+    id = (int)keys_.size();
+    keys_.push_back({asset, index_val, category});
+    hashes_.push_back(h);
+    // Keep the load factor at or below 1/2
+    if (keys_.size() * 2 > slots_.size()) rehash(slots_.size() * 2);
+    else insert_slot(id, h);
+    return id;
+}
+
+int EntityRegistry::find(const std::string& asset, int index_val, char category) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return probe(asset, index_val, category, hash_key(asset, index_val, category));
+}
+
+const EntityKey& EntityRegistry::key(int id) const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return keys_[id];
+}
+
+int EntityRegistry::size() const {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return (int)keys_.size();
+}
+
+int EntityRegistry::load(Database& db) {
+    auto rows = db.get_entities();
+    std::lock_guard<std::mutex> lock(mutex_);
+    for (size_t i = 0; i < rows.size(); ++i) {
+        // Rows come back ordered by id; ids are dense from 0
+        if (rows[i].id != (int)i) return -1;
+    }
+    load_locked(rows);
+    return 0;
+}
+
+void EntityRegistry::load_locked(const std::vector<EntityRecord>& rows) {
+    // key() hands out references: the old keys stay where they are
+    if (!keys_.empty()) retired_.push_back(std::move(keys_));
+    keys_.clear();
+    hashes_.clear();
+    for (auto& r : rows) {
+        keys_.push_back({r.asset, r.index_val, r.category});
+        hashes_.push_back(hash_key(r.asset, r.index_val, r.category));
+    }
+    size_t capacity = 64;
+    while (keys_.size() * 2 > capacity) capacity *= 2;
+    rehash(capacity);
+    persisted_ = (int)keys_.size();
+}
+
+// Insert ids from persisted_ on in one transaction; 1 when the database
+// holds a different id for one of them (or the id for a different key)
+int EntityRegistry::write_new(Database& db) {
+    if (persisted_ == (int)keys_.size()) return 0;
+    if (db.begin() != 0) return -1;
+    for (int id = persisted_; id < (int)keys_.size(); ++id) {
+        EntityRecord rec;
+        rec.id = id;
+        rec.asset = keys_[id].asset;
+        rec.index_val = keys_[id].index_val;
+        rec.category = keys_[id].category;
+        // INSERT OR IGNORE drops a conflict silently: read the id back
+        if (db.insert_entity(rec) != 0) {
+            db.rollback();
+            return -1;
+        }
+        if (db.find_entity(rec.asset, rec.index_val, rec.category) != id) {
+            db.rollback();
+            return 1;
+        }
+    }
+    if (db.commit() != 0) {
+        db.rollback();
+        return -1;
+    }
+    persisted_ = (int)keys_.size();
+    return 0;
+}
+
+int EntityRegistry::persist(Database& db) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int rc = write_new(db);
+    if (rc <= 0) return rc;
+
+    // Take the stored ids, then append what only this process has seen
+    std::vector<EntityKey> mine(keys_.begin() + persisted_, keys_.end());
+    auto rows = db.get_entities();
+    for (size_t i = 0; i < rows.size(); ++i) {
+        if (rows[i].id != (int)i) return -1;
+    }
+    load_locked(rows);
+    for (auto& k : mine) {
+        size_t h = hash_key(k.asset, k.index_val, k.category);
+        if (probe(k.asset, k.index_val, k.category, h) >= 0) continue;
+        keys_.push_back(k);
+        hashes_.push_back(h);
+        if (keys_.size() * 2 > slots_.size()) rehash(slots_.size() * 2);
+        else insert_slot((int)keys_.size() - 1, h);
+    }
+    return write_new(db) == 0 ? ENTITY_IDS_CHANGED : -1;
+}
+
+EntityRegistry& entity_registry() {
+    static EntityRegistry registry;
+    return registry;
+}
@@ -0,0 +1,68 @@
+#ifndef ENTITY_REGISTRY_H
+#define ENTITY_REGISTRY_H
+
+#include "database.h"
+#include <deque>
+#include <mutex>
+#include <string>
+#include <vector>
+
+struct EntityKey {
+    std::string asset;
+    int         index_val;  // -1 when rolled up to asset level
+    char        category;   // 'E', 'F', or '*' (all)
+};
+
+// Interns each ASSET/Index/Category once into a dense integer id so the
+// per-file scan and cleanup paths can index plain vectors instead of
+// keying maps on strings. Ids are persisted in the `entities` table and
+// stored alongside storage_history rows.
+class EntityRegistry {
+public:
+    EntityRegistry();
+
+    // Id for the key, assigning the next free id on first sight
+    int intern(const std::string& asset, int index_val, char category);
+
+    // Id for the key, or -1 if it has never been interned
+    int find(const std::string& asset, int index_val, char category) const;
+
+    // Key for an id; the reference stays valid for the registry's lifetime
+    const EntityKey& key(int id) const;
+
+    int size() const;
+
+    // Replace the in-memory ids with the ones stored in the database
+    int load(Database& db);
+
+    // Write ids assigned since the last load/persist. Another process
+    // sharing the database may have given one of those ids to another key
+    // (or this key another id); then nothing is written, the registry is
+    // reloaded with the stored ids, the keys the database lacks are
+    // appended after them, and ENTITY_IDS_CHANGED is returned: anything
+    // built with the old ids (a scan) must be rebuilt before it is stored.
+    int persist(Database& db);
+
+private:
+    void load_locked(const std::vector<EntityRecord>& rows);
+    int  write_new(Database& db);
+    static size_t hash_key(const std::string& asset, int index_val, char category);
+    int  probe(const std::string& asset, int index_val, char category, size_t hash) const;
+    void insert_slot(int id, size_t hash);
+    void rehash(size_t capacity);
+
+    mutable std::mutex mutex_;
+    std::deque<EntityKey> keys_;   // deque: references survive growth
+    std::vector<std::deque<EntityKey>> retired_;  // replaced by a reload, still referenced
+    std::vector<size_t>   hashes_;
+    std::vector<int>      slots_;  // open addressing, -1 = empty
+    int persisted_ = 0;
+};
+
+// persist() result when stored ids replaced the in-memory ones
+static const int ENTITY_IDS_CHANGED = -2;
+
+// Process-wide registry shared by the API, scheduler and pipeline
+EntityRegistry& entity_registry();
+
+#endif // ENTITY_REGISTRY_H
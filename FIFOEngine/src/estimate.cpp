@@ -0,0 +1,143 @@
+#include "estimate.h"
+#include "oldest_first.h"
+#include "forecast.h"
+#include "cleanup.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+#include <ctime>
+#include <map>
+#include <random>
+#include <vector>
+
+namespace {
+
+struct LargeFolder {
+    DayFolder folder;
+    double    prior_mb;  // manifest size of the folder, or of the entity's latest day
+};
+
+}
+
+static double z_score(double confidence) {
+    if (confidence >= 0.99) return 2.576;
+    if (confidence >= 0.95) return 1.960;
+    if (confidence >= 0.90) return 1.645;
+    return 1.282;
+}
+
+static double folder_mb(const DayFolder& folder, long long& files_listed) {
+    double mb = 0;
+    for (auto& e : list_dir(folder.path)) {
+        if (e.is_dir) continue;
+        mb += (double)e.size / (1024.0 * 1024.0);
+        files_listed++;
+    }
+    return mb;
+}
+
+UsageEstimate estimate_usage(Database& db, const std::string& root_path, double confidence) {
+    UsageEstimate est{};
+    int large_files = std::atoi(db.get_config("estimate_large_files", "2000").c_str());
+    double fraction = std::atof(db.get_config("estimate_sample_fraction", "0.1").c_str());
+    int min_sample = std::atoi(db.get_config("estimate_min_sample", "5").c_str());
+    if (min_sample < 2) min_sample = 2;  // two points needed for a variance
+
+    // Each entity's latest row is the prior for a day folder it has not
+    // recorded yet; looked up once per entity the walk reaches
+    std::map<int, IngestRecord> latest;
+
+    std::string today = today_date();
+    double exact_mb = 0;
+    std::vector<LargeFolder> large;
+    OldestFirstIterator walk(root_path);
+    DayFolder folder;
+    while (walk.next_folder(folder)) {
+        const IngestRecord* prior = nullptr;
+        IngestRecord row;
+        if (db.get_ingest_day(folder.entity_id, folder.date, row)) {
+            // Today's folder can take another file within the write-time
+            // resolution, so only a closed day's row is taken as exact
+            if (folder.date < today && row.dir_mtime == (long long)folder.write_time) {
+                exact_mb += row.held_mb >= 0 ? row.held_mb : row.size_mb;
+                est.manifest_folders++;
+                continue;
+            }
+            prior = &row;
+        } else {
+            auto l = latest.find(folder.entity_id);
+            if (l == latest.end()) {
+                IngestRecord r{};
+                if (!db.get_latest_ingest(folder.entity_id, r)) r.size_mb = 0;  // listed in full
+                l = latest.emplace(folder.entity_id, r).first;
+            }
+            prior = &l->second;
+        }
+
+        double prior_mb = !prior ? 0 : prior->held_mb >= 0 ? prior->held_mb : prior->size_mb;
+        if (!prior || prior->file_count < large_files || prior_mb <= 0) {
+            exact_mb += folder_mb(folder, est.files_listed);
+            est.listed_folders++;
+        } else {
+            large.push_back({folder, prior_mb});
+        }
+    }
+
+    double sampled_total = 0;
+    double variance = 0;
+    size_t count = large.size();
+    if (count > 0) {
+        size_t n = (size_t)std::ceil(fraction * (double)count);
+        n = std::min(std::max(n, (size_t)min_sample), count);
+
+        // Partial Fisher-Yates: the first n folders become the sample
+        std::mt19937 rng((unsigned)time(nullptr));
+        for (size_t i = 0; i < n; ++i) {
+            std::uniform_int_distribution<size_t> pick(i, count - 1);
+            std::swap(large[i], large[pick(rng)]);
+        }
+
+        std::vector<double> actual(n);
+        double sum_actual = 0, sum_prior = 0, all_prior = 0;
+        for (size_t i = 0; i < n; ++i) {
+            actual[i] = folder_mb(large[i].folder, est.files_listed);
+            sum_actual += actual[i];
+            sum_prior += large[i].prior_mb;
+        }
+        for (auto& f : large) all_prior += f.prior_mb;
+        est.sampled_folders = (int)n;
+        est.estimated_folders = (int)(count - n);
+
+        if (n == count) {
+            sampled_total = sum_actual;
+        } else {
+            // Ratio estimator: open folders grow (or get evicted) roughly in
+            // proportion to their manifest size
+            double ratio = sum_actual / sum_prior;
+            sampled_total = ratio * all_prior;
+
+            double ss = 0;
+            for (size_t i = 0; i < n; ++i) {
+                double resid = actual[i] - ratio * large[i].prior_mb;
+                ss += resid * resid;
+            }
+            double N = (double)count;
+            variance = N * N * (1.0 - (double)n / N) * (ss / (double)(n - 1)) / (double)n;
+        }
+    }
+
+    double half_width = z_score(confidence) * std::sqrt(variance);
+    est.total_mb = exact_mb + sampled_total;
+    est.low_mb = std::max(exact_mb, est.total_mb - half_width);
+    est.high_mb = est.total_mb + half_width;
+    return est;
+}
+
+int evaluate_estimate(Database& db, const UsageEstimate& est, int granularity, double limit_mb,
+                      double* predicted_low_mb, double* predicted_high_mb) {
+    double low = compute_forecast(db, est.low_mb, granularity).predicted_mb;
+    double high = compute_forecast(db, est.high_mb, granularity).predicted_mb;
+    if (predicted_low_mb) *predicted_low_mb = low;
+    if (predicted_high_mb) *predicted_high_mb = high;
+    return evaluate_threshold_interval(low, high, limit_mb, nullptr);
+}
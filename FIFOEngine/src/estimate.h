@@ -0,0 +1,35 @@
+#ifndef ESTIMATE_H
+#define ESTIMATE_H
+
+#include "database.h"
+#include <string>
+
+struct UsageEstimate {
+    double total_mb;           // point estimate
+    double low_mb;             // confidence interval around total_mb
+    double high_mb;
+    int    manifest_folders;   // closed day folders taken from daily_ingest
+    int    listed_folders;     // open folders listed in full
+    int    sampled_folders;    // large open folders listed as the sample
+    int    estimated_folders;  // large open folders extrapolated from it
+    long long files_listed;
+};
+
+// Fast usage estimate for interval checks. Only directories are walked:
+// a past day's folder whose write time still matches its daily_ingest row is
+// taken from the manifest as-is. Open folders are listed in full when the
+// manifest says they are small; large ones are sampled, listing a random
+// subset and extrapolating the rest with a ratio estimator against their
+// manifest size (or the entity's latest day for a new folder).
+//
+// Tuned by config keys estimate_large_files (2000), estimate_sample_fraction
+// (0.1) and estimate_min_sample (5).
+UsageEstimate estimate_usage(Database& db, const std::string& root_path,
+                             double confidence = 0.95);
+
+// Forecast both ends of the interval and evaluate them: FIFO_ACTION_* when
+// they fall in the same band, -1 when an exact scan is needed to decide
+int evaluate_estimate(Database& db, const UsageEstimate& est, int granularity, double limit_mb,
+                      double* predicted_low_mb, double* predicted_high_mb);
+
+#endif // ESTIMATE_H
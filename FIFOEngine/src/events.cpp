@@ -0,0 +1,159 @@
+#include "events.h"
+#include <cstring>
+#include <ctime>
+#include <vector>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+EventBus::EventBus() {
+    std::memset(&state_, 0, sizeof(state_));
+    state_.action = -1;
+    state_.prev_action = -1;
+    delivered_ = state_;
+}
+
+EventBus::~EventBus() { stop(); }
+
+void EventBus::ensure_thread() {
+    if (running_) return;
+    if (thread_.joinable()) thread_.join();
+    stopping_ = false;
+    running_ = true;
+    thread_ = std::thread(&EventBus::run, this);
+}
+
+int EventBus::subscribe(int kinds, FifoEventCallback cb, void* user) {
+    if (!cb || !(kinds & FIFO_EVENT_ALL)) return -1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    int handle = next_handle_++;
+    subs_[handle] = Subscriber{kinds, cb, user, nullptr};
+    ensure_thread();
+    return handle;
+}
+
+int EventBus::subscribe_handle(int kinds, void** out_event) {
+    if (!out_event || !(kinds & FIFO_EVENT_ALL)) return -1;
+    HANDLE ev = CreateEventA(NULL, FALSE, FALSE, NULL);
+    if (!ev) return -1;
+    std::lock_guard<std::mutex> lock(mutex_);
+    int handle = next_handle_++;
+    subs_[handle] = Subscriber{kinds, nullptr, nullptr, ev};
+    ensure_thread();
+    *out_event = ev;
+    return handle;
+}
+
+int EventBus::unsubscribe(int handle) {
+    std::unique_lock<std::mutex> lock(mutex_);
+    auto it = subs_.find(handle);
+    if (it == subs_.end()) return -1;
+    void* ev = it->second.event;
+    subs_.erase(it);
+
+    // A delivery in flight may still hold a copy of the subscriber
+    if (std::this_thread::get_id() != thread_.get_id())
+        idle_.wait(lock, [this] { return !dispatching_; });
+    lock.unlock();
+    if (ev) CloseHandle((HANDLE)ev);
+    return 0;
+}
+
+void EventBus::publish(int kind) {
+    state_.at = (long long)time(nullptr);
+    // Nothing accumulates while nobody listens
+    if (subs_.empty()) return;
+    state_.kinds |= kind;
+    wake_.notify_one();
+}
+
+void EventBus::scan_done(double total_mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.current_mb = total_mb;
+    publish(FIFO_EVENT_SCAN_DONE);
+}
+
+void EventBus::action(int action, double usage_mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.current_mb = usage_mb;
+    if (action == state_.action) return;
+    state_.prev_action = state_.action;
+    state_.action = action;
+    publish(FIFO_EVENT_ACTION_CHANGED);
+}
+
+void EventBus::cleanup_started(double planned_mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.cleanup_planned_mb = planned_mb;
+    publish(FIFO_EVENT_CLEANUP_STARTED);
+}
+
+void EventBus::cleanup_finished(int files, double mb) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    state_.files_deleted = files;
+    state_.mb_freed = mb;
+    publish(FIFO_EVENT_CLEANUP_FINISHED);
+}
+
+int EventBus::current_action() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return state_.action;
+}
+
+FifoEvent EventBus::last_delivered() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return delivered_;
+}
+
+void EventBus::run() {
+    std::unique_lock<std::mutex> lock(mutex_);
+    for (;;) {
+        wake_.wait(lock, [this] { return stopping_ || state_.kinds != 0; });
+        if (stopping_) break;
+
+        FifoEvent ev = state_;
+        ev.seq = ++seq_;
+        state_.kinds = 0;
+        delivered_ = ev;
+
+        std::vector<Subscriber> targets;
+        for (auto& s : subs_) {
+            if (s.second.kinds & ev.kinds) targets.push_back(s.second);
+        }
+        dispatching_ = true;
+        lock.unlock();
+
+        for (auto& s : targets) {
+            if (s.cb) s.cb(&ev, s.user);
+            else SetEvent((HANDLE)s.event);
+        }
+
+        lock.lock();
+        dispatching_ = false;
+        idle_.notify_all();
+    }
+    running_ = false;
+}
+
+void EventBus::stop() {
+    std::vector<void*> handles;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        stopping_ = true;
+        for (auto& s : subs_) {
+            if (s.second.event) handles.push_back(s.second.event);
+        }
+        subs_.clear();
+        state_.kinds = 0;
+    }
+    wake_.notify_one();
+    if (thread_.joinable() && std::this_thread::get_id() != thread_.get_id()) thread_.join();
+    for (void* h : handles) CloseHandle((HANDLE)h);
+}
+
+EventBus& event_bus() {
+    static EventBus bus;
+    return bus;
+}
@@ -0,0 +1,70 @@
+#ifndef EVENTS_H
+#define EVENTS_H
+
+#include "fifo_api.h"
+#include <condition_variable>
+#include <map>
+#include <mutex>
+#include <thread>
+
+// Process-wide publisher of FIFO_EVENT_* notifications. Publishers only
+// merge their change into one pending event under a short lock and wake
+// the notifier thread, which calls subscriber callbacks and signals
+// subscriber handles. Everything published between two deliveries goes
+// out as a single event carrying the union of kinds and the latest values,
+// so a slow subscriber delays its own notifications but never a scan or
+// cleanup.
+class EventBus {
+public:
+    EventBus();
+    ~EventBus();
+
+    // Returns a subscription handle > 0
+    int subscribe(int kinds, FifoEventCallback cb, void* user);
+    // Same, signalling an auto-reset Win32 event owned by the bus
+    int subscribe_handle(int kinds, void** out_event);
+    // After this returns, no callback for the subscription is running or
+    // will start (unless called from inside that callback)
+    int unsubscribe(int handle);
+
+    void scan_done(double total_mb);
+    // Publishes ACTION_CHANGED only when the band differs from the last one
+    void action(int action, double usage_mb);
+    void cleanup_started(double planned_mb);
+    void cleanup_finished(int files, double mb);
+
+    int       current_action();
+    FifoEvent last_delivered();
+
+    // Stop the notifier and drop every subscription
+    void stop();
+
+private:
+    struct Subscriber {
+        int               kinds;
+        FifoEventCallback cb;
+        void*             user;
+        void*             event;   // HANDLE, when subscribed by handle
+    };
+
+    void publish(int kind);   // with mutex_ held
+    void ensure_thread();     // with mutex_ held
+    void run();
+
+    std::mutex              mutex_;
+    std::condition_variable wake_;
+    std::condition_variable idle_;
+    std::map<int, Subscriber> subs_;
+    int         next_handle_ = 1;
+    FifoEvent   state_;         // latest values, kinds = pending bits
+    FifoEvent   delivered_;
+    long long   seq_ = 0;
+    bool        running_ = false;
+    bool        stopping_ = false;
+    bool        dispatching_ = false;
+    std::thread thread_;
+};
+
+EventBus& event_bus();
+
+#endif // EVENTS_H
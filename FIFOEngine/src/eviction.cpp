@@ -0,0 +1,186 @@
+#include "eviction.h"
+#include "entity_registry.h"
+#include <algorithm>
+#include <cstdlib>
+#include <ctime>
+#include <queue>
+#include <sstream>
+
+EvictionParams load_eviction_params(Database& db) {
+    EvictionParams p;
+    p.policy = db.get_config("eviction_policy", "fifo");
+    p.min_retention_hours = std::atoi(db.get_config("eviction_min_retention_hours", "24").c_str());
+    p.keep_per_entity = std::atoi(db.get_config("eviction_keep_per_entity", "5").c_str());
+    p.max_deletions = std::atoi(db.get_config("eviction_max_deletions", "500").c_str());
+    p.weight_e = std::atof(db.get_config("eviction_weight_E", "1").c_str());
+    p.weight_f = std::atof(db.get_config("eviction_weight_F", "1").c_str());
+    p.slack_days = std::atoi(db.get_config("eviction_slack_days", "1").c_str());
+    if (p.min_retention_hours < 0) p.min_retention_hours = 0;
+    if (p.keep_per_entity < 0) p.keep_per_entity = 0;
+    if (p.max_deletions <= 0) p.max_deletions = 500;
+    if (p.weight_e <= 0) p.weight_e = 1;
+    if (p.weight_f <= 0) p.weight_f = 1;
+    if (p.slack_days < 1) p.slack_days = 1;
+
+    p.cold_root = db.get_config("tier_cold_root", "");
+    p.cold_limit_mb = std::atof(db.get_config("tier_cold_limit_mb", "0").c_str());
+    p.verify_content = db.get_config("tier_verify", "size") == "content";
+
+    std::istringstream shares(db.get_config("eviction_asset_shares", ""));
+    std::string item;
+    while (std::getline(shares, item, ',')) {
+        size_t eq = item.find('=');
+        if (eq == std::string::npos || eq == 0) continue;
+        double share = std::atof(item.c_str() + eq + 1);
+        if (share > 0) p.asset_shares[item.substr(0, eq)] = share;
+    }
+    return p;
+}
+
+namespace {
+
+bool older(const ScannedFile& a, const ScannedFile& b) {
+    return a.created_time < b.created_time;
+}
+
+class FifoPolicy : public EvictionPolicy {
+public:
+    void order(std::vector<ScannedFile>& candidates, const std::vector<ScannedFile>&,
+               double) const override {
+        std::stable_sort(candidates.begin(), candidates.end(), older);
+    }
+};
+
+class CategoryWeightedPolicy : public EvictionPolicy {
+public:
+    CategoryWeightedPolicy(double weight_e, double weight_f)
+        : weight_e_(weight_e), weight_f_(weight_f) {}
+
+    void order(std::vector<ScannedFile>& candidates, const std::vector<ScannedFile>&,
+               double) const override {
+        time_t now = time(nullptr);
+        EntityRegistry& reg = entity_registry();
+        std::vector<std::pair<double, size_t>> keyed;
+        keyed.reserve(candidates.size());
+        for (size_t i = 0; i < candidates.size(); ++i) {
+            const ScannedFile& f = candidates[i];
+            double weight = reg.key(f.entity_id).category == 'E' ? weight_e_ : weight_f_;
+            keyed.push_back(std::make_pair((double)(now - f.created_time) / weight, i));
+        }
+        // Oldest effective age first
+        std::stable_sort(keyed.begin(), keyed.end(),
+                         [](const std::pair<double, size_t>& a, const std::pair<double, size_t>& b) {
+                             return a.first > b.first;
+                         });
+        std::vector<ScannedFile> ordered;
+        ordered.reserve(candidates.size());
+        for (auto& k : keyed) ordered.push_back(candidates[k.second]);
+        candidates.swap(ordered);
+    }
+
+private:
+    double weight_e_, weight_f_;
+};
+
+class FairSharePolicy : public EvictionPolicy {
+public:
+    explicit FairSharePolicy(const std::map<std::string, double>& shares) : shares_(shares) {}
+
+    void order(std::vector<ScannedFile>& candidates, const std::vector<ScannedFile>& all,
+               double amount_mb) const override {
+        EntityRegistry& reg = entity_registry();
+
+        // Per-asset usage and oldest-first candidate queues
+        std::map<std::string, size_t> index;
+        std::vector<double> usage;
+        std::vector<std::vector<ScannedFile>> queues;
+        auto slot = [&](int entity_id) {
+            const std::string& asset = reg.key(entity_id).asset;
+            auto it = index.find(asset);
+            if (it != index.end()) return it->second;
+            size_t i = usage.size();
+            index[asset] = i;
+            usage.push_back(0);
+            queues.emplace_back();
+            return i;
+        };
+        double total = 0;
+        for (auto& f : all) {
+            usage[slot(f.entity_id)] += f.size_mb;
+            total += f.size_mb;
+        }
+        for (auto& f : candidates) queues[slot(f.entity_id)].push_back(f);
+        for (auto& q : queues) std::stable_sort(q.begin(), q.end(), older);
+
+        // Each asset's quota is its share of what remains after the cleanup
+        std::vector<double> share(usage.size(), 1.0);
+        double share_sum = 0;
+        for (auto& a : index) {
+            auto s = shares_.find(a.first);
+            if (s != shares_.end()) share[a.second] = s->second;
+            share_sum += share[a.second];
+        }
+        double target = std::max(0.0, total - amount_mb);
+
+        // Repeatedly take the oldest file of the asset furthest over quota
+        typedef std::pair<double, size_t> Over;
+        std::priority_queue<Over> heap;
+        std::vector<size_t> pos(queues.size(), 0);
+        auto over = [&](size_t a) {
+            double quota = target * share[a] / share_sum;
+            return quota > 0 ? usage[a] / quota : usage[a];
+        };
+        for (size_t a = 0; a < queues.size(); ++a)
+            if (!queues[a].empty()) heap.push(Over(over(a), a));
+
+        std::vector<ScannedFile> ordered;
+        ordered.reserve(candidates.size());
+        while (!heap.empty()) {
+            size_t a = heap.top().second;
+            heap.pop();
+            const ScannedFile& f = queues[a][pos[a]++];
+            usage[a] -= f.size_mb;
+            ordered.push_back(f);
+            if (pos[a] < queues[a].size()) heap.push(Over(over(a), a));
+        }
+        candidates.swap(ordered);
+    }
+
+private:
+    std::map<std::string, double> shares_;
+};
+
+class LargestOldestPolicy : public EvictionPolicy {
+public:
+    explicit LargestOldestPolicy(int slack_days) : slack_secs_((time_t)slack_days * 86400) {}
+
+    void order(std::vector<ScannedFile>& candidates, const std::vector<ScannedFile>&,
+               double) const override {
+        if (candidates.empty()) return;
+
+        // Windows of slack_days measured from the oldest candidate
+        time_t first = std::min_element(candidates.begin(), candidates.end(), older)->created_time;
+        std::stable_sort(candidates.begin(), candidates.end(),
+                         [&](const ScannedFile& a, const ScannedFile& b) {
+                             time_t wa = (a.created_time - first) / slack_secs_;
+                             time_t wb = (b.created_time - first) / slack_secs_;
+                             if (wa != wb) return wa < wb;
+                             return a.size_mb > b.size_mb;
+                         });
+    }
+
+private:
+    time_t slack_secs_;
+};
+
+} // namespace
+
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const EvictionParams& params) {
+    if (params.policy == "category_weighted")
+        return std::unique_ptr<EvictionPolicy>(new CategoryWeightedPolicy(params.weight_e, params.weight_f));
+    if (params.policy == "fair_share")
+        return std::unique_ptr<EvictionPolicy>(new FairSharePolicy(params.asset_shares));
+    if (params.policy == "largest_oldest")
+        return std::unique_ptr<EvictionPolicy>(new LargestOldestPolicy(params.slack_days));
+    return std::unique_ptr<EvictionPolicy>(new FifoPolicy());
+}
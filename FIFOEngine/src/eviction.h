@@ -0,0 +1,55 @@
+#ifndef EVICTION_H
+#define EVICTION_H
+
+#include "database.h"
+#include "scanner.h"
+#include <map>
+#include <memory>
+#include <string>
+#include <vector>
+
+// Cleanup limits and policy selection, read from the configuration table
+struct EvictionParams {
+    std::string policy = "fifo";          // eviction_policy
+    int    min_retention_hours = 24;      // eviction_min_retention_hours
+    int    keep_per_entity = 5;           // eviction_keep_per_entity
+    int    max_deletions = 500;           // eviction_max_deletions
+    double weight_e = 1;                  // eviction_weight_E
+    double weight_f = 1;                  // eviction_weight_F
+    int    slack_days = 1;                // eviction_slack_days
+    std::map<std::string, double> asset_shares;  // eviction_asset_shares, "A=2,B=1"
+
+    // Tiering: evicted files move under cold_root instead of being deleted
+    std::string cold_root;                // tier_cold_root, empty = delete
+    double cold_limit_mb = 0;             // tier_cold_limit_mb, 0 = unbounded
+    bool   verify_content = false;        // tier_verify "content" (default "size")
+};
+
+EvictionParams load_eviction_params(Database& db);
+
+// Orders cleanup candidates. The caller has already dropped files inside
+// the retention period and applies the per-entity minimum and the
+// deletion cap while walking the result front to back.
+class EvictionPolicy {
+public:
+    virtual ~EvictionPolicy() {}
+
+    // candidates: files that may be deleted; all: every scanned file, for
+    // policies that weigh current usage; amount_mb: what must be freed
+    virtual void order(std::vector<ScannedFile>& candidates,
+                       const std::vector<ScannedFile>& all,
+                       double amount_mb) const = 0;
+};
+
+// Built-ins, by eviction_policy value:
+//   fifo               oldest created_time first
+//   category_weighted  age divided by the E/F weight, so a heavier
+//                      category is kept proportionally longer
+//   fair_share         evict from whichever asset is furthest over its
+//                      share of the post-cleanup total, oldest first
+//   largest_oldest     oldest slack_days window first, largest files first
+//                      within a window: the same age frontier in fewer unlinks
+// Unknown names fall back to fifo.
+std::unique_ptr<EvictionPolicy> make_eviction_policy(const EvictionParams& params);
+
+#endif // EVICTION_H
@@ -1,50 +1,215 @@
 #include "fifo_api.h"
 #include "database.h"
+#include "db_manager.h"
 #include "scanner.h"
 #include "forecast.h"
 #include "cleanup.h"
 #include "datagen.h"
 #include "scheduler.h"
+#include "pipeline.h"
+#include "entity_registry.h"
+#include "tsstore.h"
+#include "estimate.h"
+#include "forecast_state.h"
+#include "lease.h"
+#include "journal.h"
+#include "io_budget.h"
+#include "tiering.h"
+#include "log_export.h"
+#include "snapshot.h"
+#include "intraday.h"
+#include "events.h"
+#include "admission.h"
+#include "emergency.h"
+#include "trace.h"
+#include <algorithm>
+#include <atomic>
+#include <map>
 #include <mutex>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
+#include <chrono>
+#include <ctime>
+#include <fcntl.h>
+#include <io.h>
+#include <sys/stat.h>
 
 // Global state
-static Database g_db;
+static Database* g_db = nullptr;   // the db_manager() connection while an ApiLock holds it
 static Scheduler g_scheduler;
 static std::mutex g_mutex;
 static ScanResult g_last_scan;
 static ForecastData g_last_forecast;
 static std::string g_db_path;
+static std::string g_last_run;  // mirrors the last_run config key
+static int g_granularity = FIFO_GRAN_ASSET_IDX_CAT;  // level the UI last asked for
+static std::atomic<bool> g_scheduler_warm{false};     // set by resident hosts only
+
+// Open deletion-log cursors by handle; each remembers the last key it returned
+struct LogCursor {
+    DeletionQuery query;
+    DeletionKey   last;
+    bool          started = false;
+    bool          done = false;
+    int           page_size = 100;
+};
+static std::map<int, LogCursor> g_log_cursors;
+static int g_next_log_handle = 1;
+
+// Flat copy of g_last_scan for bulk views, built on the first view after
+// each scan; open views keep their snapshot alive through the shared_ptr
+static long long g_scan_id = 0;
+static std::shared_ptr<const ScanSnapshot> g_snapshot;
+static std::map<int, std::shared_ptr<const void>> g_views;
+static int g_next_view_handle = 1;
+
+// Cycle counters for fifo_get_metrics, under their own mutex so a host can
+// read them while a cycle holds g_mutex
+static std::mutex g_metrics_mutex;
+static EngineMetrics g_metrics;
+static time_t g_started_at = 0;
+
+// g_mutex plus the db_manager() connection, which the scheduler thread
+// shares, for the length of an entry point; g_db points at it meanwhile.
+// g_db stays null before fifo_init and when the database cannot be opened.
+class ApiLock {
+public:
+    ApiLock() : lock_(g_mutex) { attach(); }
+    ~ApiLock() { g_db = nullptr; }
+
+    // Take the connection for the current g_db_path
+    void attach() {
+        g_db = nullptr;
+        session_ = DbManager::Session();
+        if (g_db_path.empty()) return;
+        session_ = db_manager().acquire(g_db_path);
+        if (session_) g_db = &*session_;
+    }
+
+private:
+    std::lock_guard<std::mutex> lock_;
+    DbManager::Session session_;
+};
+
+// Call whenever g_last_scan is replaced
+static void scan_replaced() {
+    g_scan_id++;
+    g_snapshot.reset();
+
+    std::lock_guard<std::mutex> lock(g_metrics_mutex);
+    g_metrics.scan_id = g_scan_id;
+    g_metrics.scan_files = g_last_scan.total_files;
+    g_metrics.scan_mb = g_last_scan.total_mb;
+}
+
+// Scans and deletions need the root's lease. Without it this process only
+// serves what the owner stored in the shared database.
+static int take_lease(const std::string& root) {
+    int stale = std::atoi(g_db->get_config("lease_stale_secs", "90").c_str());
+    return root_lease().acquire(root, stale);
+}
+
+static bool lease_for_resume(const std::string& root) {
+    return take_lease(root) == 0;
+}
+
+// Usage the last exact scan stored, by whichever process owns the root
+static double stored_usage_mb() {
+    UsageSample usage{0, 0};
+    g_db->get_latest_usage(usage);
+    return usage.total_mb;
+}
+
+static void load_cached_results() {
+    g_last_scan = ScanResult{};
+    g_last_scan.total_mb = stored_usage_mb();
+    scan_replaced();
+    g_last_forecast = ForecastData{};
+    g_last_forecast.current_mb = g_last_scan.total_mb;
+    g_last_forecast.predicted_mb = g_db->get_latest_forecast();
+}
+
+static void apply_size_accounting(const std::string& mode) {
+    set_size_accounting(mode == "allocated" ? SIZE_ALLOCATED : SIZE_LOGICAL);
+}
+
+static void apply_scan_memory(Database& db) {
+    double mb = std::atof(db.get_config("scan_memory_mb", "0").c_str());
+    size_t bytes = mb > 0 ? (size_t)(mb * 1024 * 1024) : 0;
+    set_scan_memory_budget(bytes, db.get_config("scan_spill_dir", ""));
+}
 
 FIFO_API int fifo_init(const char* db_path) {
-    std::lock_guard<std::mutex> lock(g_mutex);
+    ApiLock lock;
     g_db_path = db_path;
-    return g_db.open(db_path);
+    lock.attach();
+    if (!g_db) return FIFO_ERR_DB;
+    {
+        std::lock_guard<std::mutex> mlock(g_metrics_mutex);
+        g_metrics = EngineMetrics{};
+        g_metrics.last_action = -1;
+        g_started_at = time(nullptr);
+    }
+    if (entity_registry().load(*g_db) != 0) return FIFO_ERR_DB;
+    apply_size_accounting(g_db->get_config("size_accounting", "logical"));
+    apply_scan_memory(*g_db);
+    load_io_budget(*g_db);
+
+    // Finish cleanup batches a crash interrupted, before anything rescans
+    {
+        BackgroundIoScope background;
+        resume_cleanup_batches(*g_db, lease_for_resume);
+    }
+
+    g_last_run = g_db->get_config("last_run", "");
+
+    std::string trace_path = g_db->get_config("trace_path", "");
+    if (!trace_path.empty()) trace_recorder().start(trace_path);
+
+    // Long-horizon history lives next to the database; seed it on first use
+    int ts = ts_store().open(g_db_path + ".ts");
+    if (ts == 1) ts_backfill(*g_db, ts_store());
+    return FIFO_OK;
 }
 
 FIFO_API void fifo_shutdown() {
     g_scheduler.stop();
+    event_bus().stop();
+    admission().close();
+    trace_recorder().stop();
+    root_lease().release();
     std::lock_guard<std::mutex> lock(g_mutex);
-    g_db.close();
+    ts_store().close();
+    db_manager().close();
+    g_db_path.clear();
 }
 
 FIFO_API int fifo_scan(const char* root_path, int granularity) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    BackgroundIoScope background;
+
+    g_granularity = granularity;
+    if (take_lease(root_path) != 0) {
+        load_cached_results();
+        return FIFO_ERR_LEASED;
+    }
     g_last_scan = scan_directory(root_path, granularity);
+    scan_replaced();
     if (g_last_scan.total_files == 0) return FIFO_ERR_NODATA;
 
-    return store_scan_results(g_db, g_last_scan);
+    int rc = store_scan(*g_db, g_last_scan);
+    scan_replaced();
+    return rc;
 }
 
 FIFO_API int fifo_forecast(ForecastResult* out) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
 
-    g_last_forecast = compute_forecast(g_db, g_last_scan.total_mb);
-    store_forecast(g_db, g_last_forecast);
+    g_last_forecast = compute_forecast(*g_db, g_last_scan.total_mb, g_granularity);
+    store_forecast(*g_db, g_last_forecast);
 
     if (out) {
         out->current_mb = g_last_forecast.current_mb;
@@ -55,10 +220,50 @@ FIFO_API int fifo_forecast(ForecastResult* out) {
     return FIFO_OK;
 }
 
+FIFO_API int fifo_forecast_entity(const char* asset, int index_val, char category,
+                                  ForecastResult* out) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+
+    int id = entity_registry().find(asset, index_val, category);
+    if (id < 0) return FIFO_ERR_NODATA;
+
+    double current_mb = 0;
+    for (auto& e : g_last_scan.entries) {
+        if (e.entity_id == id) { current_mb = e.size_mb; break; }
+    }
+
+    ForecastData fd{};
+    if (forecast_state().ensure(*g_db) != 0) return FIFO_ERR_FORECAST;
+    if (!forecast_state().forecast(id, current_mb, fd)) return FIFO_ERR_NODATA;
+
+    if (out) {
+        out->current_mb = fd.current_mb;
+        out->predicted_mb = fd.predicted_mb;
+        out->growth_rate_mb_per_day = fd.growth_rate;
+        out->history_days_available = fd.days_available;
+    }
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_rebuild_forecast_state() {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    return forecast_state().rebuild(*g_db) == 0 ? FIFO_OK : FIFO_ERR_DB;
+}
+
 FIFO_API int fifo_evaluate(double limit_mb, EvalResult* out) {
-    std::lock_guard<std::mutex> lock(g_mutex);
+    ApiLock lock;
     double amount = 0;
     int action = evaluate_threshold(g_last_forecast.predicted_mb, limit_mb, &amount);
+    if (g_db) {
+        double eta_amount = 0;
+        int eta_action = evaluate_intraday(*g_db, g_last_scan.total_mb, limit_mb, &eta_amount);
+        if (eta_action > action) {
+            action = eta_action;
+            amount = eta_amount;
+        }
+    }
     if (out) {
         out->action = action;
         out->projected_pct = (limit_mb > 0) ? (g_last_forecast.predicted_mb / limit_mb * 100.0) : 0;
@@ -68,17 +273,20 @@ FIFO_API int fifo_evaluate(double limit_mb, EvalResult* out) {
 }
 
 FIFO_API int fifo_cleanup(double limit_mb, double target_pct, CleanupResult* out) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    BackgroundIoScope background;
+    // The lease must cover the root the files were scanned from, not just any root
+    if (!root_lease().owns(g_last_scan.root_path)) return FIFO_ERR_LEASED;
 
-    double target_mb = limit_mb * target_pct;
+    double target_mb = limit_mb * target_fraction(target_pct);
     double amount = g_last_scan.total_mb - target_mb;
     if (amount <= 0) {
         if (out) { out->files_deleted = 0; out->mb_freed = 0; out->new_usage_mb = g_last_scan.total_mb; out->new_usage_pct = (limit_mb > 0) ? (g_last_scan.total_mb / limit_mb * 100.0) : 0; }
         return FIFO_OK;
     }
 
-    auto stats = execute_cleanup(g_db, g_last_scan.all_files, amount);
+    auto stats = cleanup_scan(*g_db, g_last_scan, amount, load_eviction_params(*g_db));
 
     if (out) {
         out->files_deleted = stats.files_deleted;
@@ -89,32 +297,117 @@ FIFO_API int fifo_cleanup(double limit_mb, double target_pct, CleanupResult* out
     return FIFO_OK;
 }
 
-FIFO_API int fifo_execute_full(const char* root, int granularity, double limit_mb,
-                               double target_pct, FullResult* out) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
+FIFO_API int fifo_estimate(const char* root_path, double limit_mb, EstimateResult* out) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    BackgroundIoScope background;
 
-    // Phase 1: Scan
-    g_last_scan = scan_directory(root, granularity);
-    store_scan_results(g_db, g_last_scan);
+    auto est = estimate_usage(*g_db, root_path);
+    if (est.manifest_folders + est.listed_folders + est.sampled_folders == 0)
+        return FIFO_ERR_NODATA;
 
-    // Phase 2: Forecast
-    g_last_forecast = compute_forecast(g_db, g_last_scan.total_mb);
-    store_forecast(g_db, g_last_forecast);
+    double predicted_low = 0, predicted_high = 0;
+    int action = evaluate_estimate(*g_db, est, g_granularity, limit_mb,
+                                   &predicted_low, &predicted_high);
+    if (out) {
+        out->total_mb = est.total_mb;
+        out->low_mb = est.low_mb;
+        out->high_mb = est.high_mb;
+        out->predicted_low_mb = predicted_low;
+        out->predicted_high_mb = predicted_high;
+        out->action = action;
+        out->needs_exact_scan = (action < 0 || action == FIFO_ACTION_CLEANUP) ? 1 : 0;
+        out->manifest_folders = est.manifest_folders;
+        out->listed_folders = est.listed_folders;
+        out->sampled_folders = est.sampled_folders;
+        out->estimated_folders = est.estimated_folders;
+    }
+    return FIFO_OK;
+}
 
-    // Phase 3: Evaluate
-    double amount = 0;
-    int action = evaluate_threshold(g_last_forecast.predicted_mb, limit_mb, &amount);
+static int execute_full_locked(const char* root, int granularity, double limit_mb,
+                               double target_pct, FullResult* out) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    BackgroundIoScope background;
+
+    g_granularity = granularity;
+    if (take_lease(root) != 0) {
+        load_cached_results();
+        if (out) {
+            *out = FullResult{};
+            out->current_mb = g_last_scan.total_mb;
+            out->predicted_mb = g_last_forecast.predicted_mb;
+            out->limit_mb = limit_mb;
+            out->usage_pct = (limit_mb > 0) ? (g_last_scan.total_mb / limit_mb * 100.0) : 0;
+            out->action = evaluate_threshold(g_last_forecast.predicted_mb, limit_mb, nullptr);
+            out->first_free_secs = -1;
+        }
+        return FIFO_ERR_LEASED;
+    }
 
+    int action = FIFO_ACTION_SAFE;
     int files_deleted = 0;
     double mb_freed = 0;
-
-    // Phase 4: Cleanup if needed
-    if (action == FIFO_ACTION_CLEANUP && amount > 0) {
-        auto stats = execute_cleanup(g_db, g_last_scan.all_files, amount);
-        files_deleted = stats.files_deleted;
-        mb_freed = stats.mb_freed;
+    int early_files = 0;
+    double early_mb = 0;
+    double first_free_secs = -1;
+    double current_mb = 0;
+
+    EvictionParams eviction = load_eviction_params(*g_db);
+    // Past the hard watermark: free space first, scan and forecast next cycle
+    EmergencyStats emergency = run_emergency(*g_db, root, eviction);
+    if (emergency.triggered) {
+        action = FIFO_ACTION_CLEANUP;
+        files_deleted = emergency.files_deleted;
+        mb_freed = emergency.mb_freed;
+        // No scan ran: the last measured usage less what was just freed
+        current_mb = std::max(stored_usage_mb() - mb_freed, 0.0);
+    } else if (g_db->get_config("execute_mode", "sequential") == "pipelined") {
+        // Scan and cleanup overlap; forecast/evaluate reconcile at the end
+        auto run = execute_pipelined(*g_db, root, granularity, limit_mb, target_pct, eviction);
+        g_last_scan = std::move(run.scan);
+        scan_replaced();
+        g_last_forecast = run.forecast;
+        action = run.action;
+        files_deleted = run.cleanup.files_deleted;
+        mb_freed = run.cleanup.mb_freed;
+        early_files = run.early_files_deleted;
+        early_mb = run.early_mb_freed;
+        first_free_secs = run.first_free_secs;
+    } else {
+        // Phase 1: Scan
+        g_last_scan = scan_directory(root, granularity);
+        store_scan(*g_db, g_last_scan);
+        scan_replaced();
+
+        // Phase 2: Forecast
+        g_last_forecast = compute_forecast(*g_db, g_last_scan.total_mb, granularity);
+        store_forecast(*g_db, g_last_forecast);
+
+        // Phase 3: Evaluate, escalating when an intraday burst crosses a band first
+        double amount = 0;
+        action = evaluate_threshold(g_last_forecast.predicted_mb, limit_mb, &amount, target_pct);
+        double eta_amount = 0;
+        int eta_action = evaluate_intraday(*g_db, g_last_scan.total_mb, limit_mb, &eta_amount,
+                                           target_pct);
+        if (eta_action > action) {
+            action = eta_action;
+            amount = eta_amount;
+        }
+
+        // Phase 4: Cleanup if needed
+        if (action == FIFO_ACTION_CLEANUP && amount > 0) {
+            auto stats = cleanup_scan(*g_db, g_last_scan, amount, eviction);
+            files_deleted = stats.files_deleted;
+            mb_freed = stats.mb_freed;
+        }
     }
+    if (!emergency.triggered) current_mb = g_last_scan.total_mb;
+    event_bus().action(action, current_mb);
+
+    // Tiered data is FIFO'd on the cold root against its own limit
+    if (!emergency.triggered) enforce_cold_limit(*g_db, eviction, target_pct);
 
     // Record run
     time_t now = time(nullptr);
@@ -124,39 +417,124 @@ FIFO_API int fifo_execute_full(const char* root, int granularity, double limit_m
     snprintf(ts, sizeof(ts), "%04d-%02d-%02d %02d:%02d:%02d",
              lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
              lt.tm_hour, lt.tm_min, lt.tm_sec);
-    g_db.set_config("last_run", ts);
+    g_db->set_config("last_run", ts);
+    g_last_run = ts;
 
     if (out) {
-        out->current_mb = g_last_scan.total_mb;
+        out->current_mb = current_mb;
         out->predicted_mb = g_last_forecast.predicted_mb;
         out->growth_rate = g_last_forecast.growth_rate;
         out->limit_mb = limit_mb;
-        out->usage_pct = (limit_mb > 0) ? (g_last_scan.total_mb / limit_mb * 100.0) : 0;
+        out->usage_pct = (limit_mb > 0) ? (current_mb / limit_mb * 100.0) : 0;
         out->action = action;
         out->files_deleted = files_deleted;
         out->mb_freed = mb_freed;
         out->history_days = g_last_forecast.days_available;
+        out->early_files_deleted = early_files;
+        out->early_mb_freed = early_mb;
+        out->first_free_secs = first_free_secs;
+    }
+    return FIFO_OK;
+}
+
+static void cycle_started() {
+    std::lock_guard<std::mutex> lock(g_metrics_mutex);
+    g_metrics.in_cycle = 1;
+}
+
+// result is null when the cycle ran on its own connection and reported no detail
+static void cycle_finished(int rc, const FullResult* result, double ms) {
+    if (trace_recorder().active()) {
+        trace_recorder().run_finished(rc, result ? result->action : event_bus().current_action(),
+                                      result ? result->files_deleted : 0,
+                                      result ? result->mb_freed : 0, ms);
+    }
+    std::lock_guard<std::mutex> lock(g_metrics_mutex);
+    g_metrics.in_cycle = 0;
+    g_metrics.cycles++;
+    if (rc != FIFO_OK) g_metrics.failed_cycles++;
+    g_metrics.last_rc = rc;
+    g_metrics.last_action = result ? result->action : -1;
+    g_metrics.last_cycle_ms = ms;
+    if (result && rc == FIFO_OK) {
+        g_metrics.files_deleted += result->files_deleted;
+        g_metrics.mb_freed += result->mb_freed;
+    }
+}
+
+static double ms_since(std::chrono::steady_clock::time_point t0) {
+    return std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - t0).count();
+}
+
+FIFO_API int fifo_execute_full(const char* root, int granularity, double limit_mb,
+                               double target_pct, FullResult* out) {
+    FullResult result = {};
+    cycle_started();
+    auto t0 = std::chrono::steady_clock::now();
+    int rc = execute_full_locked(root, granularity, limit_mb, target_pct, &result);
+    cycle_finished(rc, &result, ms_since(t0));
+    if (out) *out = result;
+    return rc;
+}
+
+// Scheduled cycles. In warm mode they go through fifo_execute_full and keep
+// the in-memory scan current, which is what a resident host wants;
+// otherwise execute_once runs the cycle and leaves the in-memory scan
+// alone. Both use the API's connection and hold g_mutex: the cycle
+// shares the lease, admission, forecast state and time-series store with
+// the API, so it must not overlap fifo_execute_full, fifo_cleanup or a
+// second cycle. Metrics and events stay readable meanwhile.
+static int scheduled_cycle(const SchedulerConfig& cfg) {
+    bool warm;
+    {
+        ApiLock lock;
+        warm = g_db && g_scheduler_warm.load();
+    }
+    if (warm) {
+        return fifo_execute_full(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                                 cfg.target_pct, nullptr);
+    }
+    cycle_started();
+    auto t0 = std::chrono::steady_clock::now();
+    int rc;
+    {
+        ApiLock lock;
+        rc = g_db ? Scheduler::execute_once(*g_db, cfg) : FIFO_ERR_DB;
+        if (g_db) g_last_run = g_db->get_config("last_run", "");
     }
+    cycle_finished(rc, nullptr, ms_since(t0));
+    return rc;
+}
+
+FIFO_API int fifo_set_scheduler_warm(int enabled) {
+    g_scheduler_warm.store(enabled != 0);
     return FIFO_OK;
 }
 
 FIFO_API int fifo_generate_test_data(const char* root_path, double size_gb, ProgressCallback cb) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-    return generate_test_data(g_db, root_path, size_gb, cb);
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    return generate_test_data(*g_db, root_path, size_gb, cb);
 }
 
 FIFO_API int fifo_generate_one_day(const char* root_path, double day_size_mb,
                                    int day_offset, ProgressCallback cb) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-    return generate_one_day(g_db, root_path, day_size_mb, day_offset, cb);
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    return generate_one_day(*g_db, root_path, day_size_mb, day_offset, cb);
 }
 
 FIFO_API int fifo_get_weights(WeightInfo* buf, int buf_size, int* out_count) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-    auto weights = g_db.get_average_weights(14);
+    int granularity;
+    {
+        ApiLock lock;
+        granularity = g_granularity;
+    }
+    return fifo_get_weights_at(granularity, buf, buf_size, out_count);
+}
+
+static void copy_weights(const std::vector<WeightRecord>& weights, WeightInfo* buf,
+                         int buf_size, int* out_count) {
     int count = (int)weights.size();
     if (count > buf_size) count = buf_size;
     for (int i = 0; i < count; ++i) {
@@ -169,13 +547,145 @@ FIFO_API int fifo_get_weights(WeightInfo* buf, int buf_size, int* out_count) {
         buf[i].day_count = weights[i].day_count;
     }
     if (out_count) *out_count = count;
+}
+
+FIFO_API int fifo_get_weights_at(int granularity, WeightInfo* buf, int buf_size, int* out_count) {
+    return fifo_get_weights_span(14, granularity, buf, buf_size, out_count);
+}
+
+FIFO_API int fifo_get_weights_span(int days, int granularity, WeightInfo* buf, int buf_size,
+                                   int* out_count) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (days > TS_MIN_SPAN_DAYS && ts_store().is_open())
+        copy_weights(ts_average_weights(ts_store(), days, granularity), buf, buf_size, out_count);
+    else
+        copy_weights(g_db->get_average_weights(days, granularity), buf, buf_size, out_count);
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_view_open(int kind, int granularity, int days, FifoView* out) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (!out) return FIFO_ERR_ARG;
+    std::memset(out, 0, sizeof(*out));
+    out->kind = kind;
+    out->snapshot_id = g_scan_id;
+
+    std::shared_ptr<const void> pinned;
+    if (kind == FIFO_VIEW_ENTRIES || kind == FIFO_VIEW_FILES) {
+        if (!g_snapshot) g_snapshot = build_scan_snapshot(g_last_scan, g_scan_id);
+        const ScanSnapshot& snap = *g_snapshot;
+        if (kind == FIFO_VIEW_ENTRIES) {
+            size_t begin = 0, end = snap.entries.size();
+            if (granularity >= FIFO_GRAN_ASSET && granularity <= FIFO_GRAN_ASSET_IDX_CAT) {
+                begin = snap.level_begin[granularity];
+                end = snap.level_begin[granularity + 1];
+            }
+            out->rows = snap.entries.data() + begin;
+            out->count = (long long)(end - begin);
+            out->stride = (int)sizeof(ScanEntryRow);
+        } else {
+            out->rows = snap.files.data();
+            out->count = (long long)snap.files.size();
+            out->stride = (int)sizeof(ScanFileRow);
+        }
+        out->strings = snap.strings.data();
+        out->strings_size = snap.strings.size();
+        pinned = g_snapshot;
+    } else if (kind == FIFO_VIEW_WEIGHTS) {
+        if (days <= 0) days = 14;
+        if (granularity < FIFO_GRAN_ASSET || granularity > FIFO_GRAN_ASSET_IDX_CAT)
+            granularity = g_granularity;
+        auto weights = (days > TS_MIN_SPAN_DAYS && ts_store().is_open())
+                           ? ts_average_weights(ts_store(), days, granularity)
+                           : g_db->get_average_weights(days, granularity);
+        auto snap = build_weight_snapshot(weights);
+        out->rows = snap->rows.data();
+        out->count = (long long)snap->rows.size();
+        out->stride = (int)sizeof(WeightRow);
+        out->strings = snap->strings.data();
+        out->strings_size = snap->strings.size();
+        pinned = snap;
+    } else {
+        return FIFO_ERR_ARG;
+    }
+
+    out->handle = g_next_view_handle++;
+    g_views[out->handle] = pinned;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_view_release(int handle) {
+    std::shared_ptr<const void> pinned;
+    {
+        ApiLock lock;
+        auto it = g_views.find(handle);
+        if (it == g_views.end()) return FIFO_ERR_NODATA;
+        pinned.swap(it->second);
+        g_views.erase(it);
+    }
+    // A large snapshot is freed here, outside the lock
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_time_to_full(double limit_mb, TimeToFull* out) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (!out || limit_mb <= 0) return FIFO_ERR_ARG;
+    std::memset(out, 0, sizeof(*out));
+
+    time_t now = time(nullptr);
+    IntradayModel model = load_intraday_model(*g_db, now);
+    auto latest = g_db->get_usage_samples((long long)now - 60LL * 86400);
+    if (latest.empty() || model.intervals() == 0) return FIFO_ERR_NODATA;
+
+    // Project from the last exact scan and count from now
+    const UsageSample& last = latest.back();
+    double since = (double)(now - (time_t)last.sampled_at) / 3600.0;
+    double horizon = INTRADAY_HORIZON_HOURS + since;
+    out->current_mb = model.project(last.total_mb, (time_t)last.sampled_at, since, 0);
+    out->rate_mb_per_hour = model.project(out->current_mb, now, 1.0, 0) - out->current_mb;
+    out->intervals = model.intervals();
+    out->hours_covered = model.hours_covered();
+
+    const double edges[4] = {band_edge_mb(FIFO_ACTION_MONITOR, limit_mb),
+                             band_edge_mb(FIFO_ACTION_CAUTION, limit_mb),
+                             band_edge_mb(FIFO_ACTION_CLEANUP, limit_mb), limit_mb};
+    const double zs[3] = {0, INTRADAY_Z, -INTRADAY_Z};
+    double* rows[3] = {out->eta_hours, out->eta_early_hours, out->eta_late_hours};
+    for (int k = 0; k < 3; ++k) {
+        for (int i = 0; i < 4; ++i) {
+            double h = model.hours_to(last.total_mb, edges[i], (time_t)last.sampled_at, zs[k], horizon);
+            rows[k][i] = h < 0 ? -1 : std::max(0.0, h - since);
+        }
+    }
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_get_usage_series(int days, double* buf, int buf_size, int* out_count) {
+    if (!buf || buf_size <= 0 || days < 0) return FIFO_ERR_ARG;
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (!ts_store().is_open()) return FIFO_ERR_NODATA;
+
+    // One slot per calendar day ending today; -1 where nothing was measured
+    int count = days + 1;
+    if (count > buf_size) count = buf_size;
+    for (int i = 0; i < count; ++i) buf[i] = -1;
+    int first_day = (int)date_ordinal(today_date()) - (count - 1);
+    for (auto& p : ts_daily_totals(ts_store(), TS_USAGE, count - 1)) {
+        int slot = p.day - first_day;
+        if (slot >= 0 && slot < count) buf[slot] = p.size_mb;
+    }
+    if (out_count) *out_count = count;
     return FIFO_OK;
 }
 
 FIFO_API int fifo_get_history_day_count() {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return 0;
-    return g_db.get_history_day_count();
+    ApiLock lock;
+    if (!g_db) return 0;
+    return g_db->get_history_day_count();
 }
 
 FIFO_API int fifo_schedule_start(const char* root, int granularity,
@@ -192,6 +702,7 @@ FIFO_API int fifo_schedule_start(const char* root, int granularity,
     cfg.minute = minute;
     cfg.interval_minutes = 0;
 
+    g_scheduler.set_runner(scheduled_cycle);
     g_scheduler.start(cfg, g_db_path);
     return FIFO_OK;
 }
@@ -215,21 +726,60 @@ FIFO_API int fifo_schedule_start_interval(const char* root, int granularity,
     cfg.minute = 0;
     cfg.interval_minutes = interval_minutes;
 
+    g_scheduler.set_runner(scheduled_cycle);
+    g_scheduler.start(cfg, g_db_path);
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_schedule_start_adaptive(const char* root, int granularity,
+                                          double limit_mb, double target_pct,
+                                          int min_interval_minutes, int max_interval_minutes) {
+    if (g_scheduler.is_running()) return FIFO_ERR_BUSY;
+    if (min_interval_minutes < 1 || max_interval_minutes < min_interval_minutes)
+        return FIFO_ERR_ARG;
+
+    SchedulerConfig cfg;
+    cfg.root_path = root;
+    cfg.granularity = granularity;
+    cfg.limit_mb = limit_mb;
+    cfg.target_pct = target_pct;
+    cfg.hour = 0;
+    cfg.minute = 0;
+    cfg.interval_minutes = 0;
+    cfg.adaptive = true;
+    cfg.min_interval_minutes = min_interval_minutes;
+    cfg.max_interval_minutes = max_interval_minutes;
+    {
+        ApiLock lock;
+        if (g_db) {
+            double safety = std::atof(g_db->get_config("schedule_safety", "0.5").c_str());
+            double jitter = std::atof(g_db->get_config("schedule_jitter_pct", "10").c_str());
+            if (safety > 0 && safety <= 1) cfg.safety = safety;
+            if (jitter >= 0 && jitter < 50) cfg.jitter_pct = jitter;
+        }
+    }
+
+    g_scheduler.set_runner(scheduled_cycle);
     g_scheduler.start(cfg, g_db_path);
     return FIFO_OK;
 }
 
 FIFO_API int fifo_get_status(StatusInfo* out) {
     if (!out) return FIFO_ERR_DB;
-    std::lock_guard<std::mutex> lock(g_mutex);
+    ApiLock lock;
 
     out->is_scheduled = g_scheduler.is_running() ? 1 : 0;
     out->current_mb = g_last_scan.total_mb;
     out->predicted_mb = g_last_forecast.predicted_mb;
-    out->last_action = 0;
+    if (!root_lease().held() && g_db) {
+        // Another process may own the root: report what it last stored
+        out->current_mb = stored_usage_mb();
+        out->predicted_mb = g_db->get_latest_forecast();
+    }
+    int action = event_bus().current_action();
+    out->last_action = action < 0 ? FIFO_ACTION_SAFE : action;
 
-    std::string lr = g_db.is_open() ? g_db.get_config("last_run", "") : "";
-    strncpy(out->last_run, lr.c_str(), 31);
+    strncpy(out->last_run, g_last_run.c_str(), 31);
     out->last_run[31] = 0;
 
     std::string nr = g_scheduler.next_run();
@@ -239,16 +789,208 @@ FIFO_API int fifo_get_status(StatusInfo* out) {
     return FIFO_OK;
 }
 
+FIFO_API int fifo_get_metrics(EngineMetrics* out) {
+    if (!out) return FIFO_ERR_DB;
+    std::lock_guard<std::mutex> lock(g_metrics_mutex);
+    *out = g_metrics;
+    out->uptime_secs = g_started_at ? (long long)(time(nullptr) - g_started_at) : 0;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_get_lease(const char* root_path, LeaseInfo* out) {
+    if (!out || !root_path) return FIFO_ERR_ARG;
+    LeaseOwner owner;
+    RootLease::read_owner(root_path, owner);
+
+    std::memset(out, 0, sizeof(*out));
+    out->held_by_me = root_lease().owns(root_path) ? 1 : 0;
+    out->owner_pid = owner.pid;
+    strncpy(out->owner_host, owner.host.c_str(), sizeof(out->owner_host) - 1);
+    out->heartbeat_age_secs = owner.pid ? (long long)time(nullptr) - owner.heartbeat : 0;
+    return FIFO_OK;
+}
+
+static DeletionQuery make_log_query(const char* from, const char* to, const char* asset) {
+    DeletionQuery q;
+    if (from) q.from = from;
+    if (to) q.to = to;
+    if (asset) q.asset = asset;
+    return q;
+}
+
+FIFO_API int fifo_log_query(const char* from, const char* to, const char* asset,
+                            int page_size, int* out_handle) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (!out_handle) return FIFO_ERR_ARG;
+
+    LogCursor cur;
+    cur.query = make_log_query(from, to, asset);
+    cur.page_size = page_size > 0 ? page_size : 100;
+    int handle = g_next_log_handle++;
+    g_log_cursors[handle] = cur;
+    *out_handle = handle;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_log_next(int handle, DeletionLogEntry* buf, int buf_size, int* out_count) {
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (out_count) *out_count = 0;
+    auto it = g_log_cursors.find(handle);
+    if (it == g_log_cursors.end()) return FIFO_ERR_NODATA;
+    LogCursor& cur = it->second;
+    if (cur.done || !buf || buf_size <= 0) return FIFO_OK;
+
+    int limit = buf_size < cur.page_size ? buf_size : cur.page_size;
+    std::vector<DeletionRecord> rows;
+    if (g_db->get_deletion_page(cur.query, cur.started ? &cur.last : nullptr, limit, rows) != 0)
+        return FIFO_ERR_DB;
+
+    for (size_t i = 0; i < rows.size(); ++i) {
+        const DeletionRecord& r = rows[i];
+        DeletionLogEntry& e = buf[i];
+        std::memset(&e, 0, sizeof(e));
+        e.id = r.id;
+        strncpy(e.deleted_at, r.timestamp.c_str(), sizeof(e.deleted_at) - 1);
+        strncpy(e.asset, r.asset.c_str(), sizeof(e.asset) - 1);
+        strncpy(e.file_path, r.file_path.c_str(), sizeof(e.file_path) - 1);
+        e.size_mb = r.size_mb;
+        strncpy(e.reason, r.reason.c_str(), sizeof(e.reason) - 1);
+    }
+    if (!rows.empty()) {
+        cur.last.deleted_at = rows.back().timestamp;
+        cur.last.id = rows.back().id;
+        cur.started = true;
+    }
+    if ((int)rows.size() < limit) cur.done = true;
+    if (out_count) *out_count = (int)rows.size();
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_log_close(int handle) {
+    ApiLock lock;
+    return g_log_cursors.erase(handle) ? FIFO_OK : FIFO_ERR_NODATA;
+}
+
+FIFO_API int fifo_log_export(const char* from, const char* to, const char* asset,
+                             int format, int fd, long long* out_rows) {
+    std::string db_path;
+    {
+        ApiLock lock;
+        if (!g_db) return FIFO_ERR_DB;
+        db_path = g_db_path;
+    }
+    if (out_rows) *out_rows = 0;
+    if (fd < 0) return FIFO_ERR_PATH;
+
+    // A private connection: WAL readers do not block the API or the scheduler
+    Database db;
+    if (db.open(db_path) != 0) return FIFO_ERR_DB;
+    ExportFormat fmt = format == FIFO_EXPORT_NDJSON ? EXPORT_NDJSON : EXPORT_CSV;
+    DeletionQuery q = make_log_query(from, to, asset);
+    q.newest_first = false;
+    int rc = export_deletions(db, q, fmt, fd, out_rows);
+    db.close();
+    if (rc == -1) return FIFO_ERR_DB;
+    if (rc == -2) return FIFO_ERR_PATH;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_log_export_file(const char* from, const char* to, const char* asset,
+                                  int format, const char* path, long long* out_rows) {
+    if (!path) return FIFO_ERR_PATH;
+    int fd = _open(path, _O_WRONLY | _O_CREAT | _O_TRUNC | _O_BINARY, _S_IREAD | _S_IWRITE);
+    if (fd < 0) return FIFO_ERR_PATH;
+    int rc = fifo_log_export(from, to, asset, format, fd, out_rows);
+    _close(fd);
+    return rc;
+}
+
+FIFO_API int fifo_admission_start(const char* root_path, double limit_mb) {
+    if (!root_path || limit_mb <= 0) return FIFO_ERR_ARG;
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    double usage = g_last_scan.root_path == root_path ? g_last_scan.total_mb
+                                                      : stored_usage_mb();
+    admission().configure(g_db_path, root_path, limit_mb, usage);
+    return FIFO_OK;
+}
+
+// No engine lock: producers call these on their write path
+FIFO_API int fifo_reserve(long long bytes) {
+    return admission().reserve(bytes);
+}
+
+FIFO_API int fifo_release(long long reserved_bytes, long long written_bytes) {
+    admission().release(reserved_bytes, written_bytes);
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_get_admission(AdmissionInfo* out) {
+    if (!out) return FIFO_ERR_ARG;
+    Admission& a = admission();
+    out->usage_mb = a.usage_mb();
+    out->reserved_mb = a.reserved_mb();
+    out->limit_mb = a.limit_mb();
+    out->evicted_mb = a.evicted_mb();
+    out->evictions = a.evictions();
+    out->denied = a.denied();
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_trace_start(const char* path) {
+    if (!path || !*path) return FIFO_ERR_PATH;
+    return trace_recorder().start(path) == 0 ? FIFO_OK : FIFO_ERR_PATH;
+}
+
+FIFO_API int fifo_trace_stop() {
+    trace_recorder().stop();
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_subscribe(int kinds, FifoEventCallback cb, void* user, int* out_handle) {
+    int handle = event_bus().subscribe(kinds, cb, user);
+    if (handle < 0) return FIFO_ERR_PATH;
+    if (out_handle) *out_handle = handle;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_subscribe_handle(int kinds, void** out_event, int* out_handle) {
+    int handle = event_bus().subscribe_handle(kinds, out_event);
+    if (handle < 0) return FIFO_ERR_PATH;
+    if (out_handle) *out_handle = handle;
+    return FIFO_OK;
+}
+
+FIFO_API int fifo_unsubscribe(int handle) {
+    return event_bus().unsubscribe(handle) == 0 ? FIFO_OK : FIFO_ERR_NODATA;
+}
+
+FIFO_API int fifo_get_last_event(FifoEvent* out) {
+    if (!out) return FIFO_ERR_ARG;
+    *out = event_bus().last_delivered();
+    return FIFO_OK;
+}
+
 FIFO_API int fifo_set_config(const char* key, const char* value) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-    return g_db.set_config(key, value);
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    if (std::strcmp(key, "size_accounting") == 0) apply_size_accounting(value);
+    int rc = g_db->set_config(key, value);
+    if (std::strncmp(key, "io_", 3) == 0) load_io_budget(*g_db);
+    if (std::strcmp(key, "scan_memory_mb") == 0 || std::strcmp(key, "scan_spill_dir") == 0)
+        apply_scan_memory(*g_db);
+    if (std::strncmp(key, "sqlite_", 7) == 0) g_db->apply_profile();
+    if (std::strcmp(key, "forecast_history_days") == 0 || std::strcmp(key, "forecast_model") == 0)
+        forecast_state().invalidate();
+    return rc;
 }
 
 FIFO_API int fifo_get_config(const char* key, char* value_buf, int buf_size) {
-    std::lock_guard<std::mutex> lock(g_mutex);
-    if (!g_db.is_open()) return FIFO_ERR_DB;
-    std::string val = g_db.get_config(key, "");
+    ApiLock lock;
+    if (!g_db) return FIFO_ERR_DB;
+    std::string val = g_db->get_config(key, "");
     strncpy(value_buf, val.c_str(), buf_size - 1);
     value_buf[buf_size - 1] = 0;
     return FIFO_OK;
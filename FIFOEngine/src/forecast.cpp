@@ -1,16 +1,26 @@
 #include "forecast.h"
+#include "scanner.h"
+#include "forecast_state.h"
 #include <algorithm>
 #include <numeric>
 #include <ctime>
 #include <cstdio>
 #include <map>
+#include <cstdlib>
 
-ForecastData compute_forecast(Database& db, double current_total_mb) {
+ForecastData compute_forecast(Database& db, double current_total_mb, int granularity) {
     ForecastData fd{};
     fd.current_mb = current_total_mb;
 
+    // Ingest model, answered from the incremental state without a history query
+    ForecastState& state = forecast_state();
+    if (current_total_mb > 0 && state.ensure(db) == 0 && state.forecast(-1, current_total_mb, fd))
+        return fd;
+
+    // Fallback: snapshot totals when no per-day ingest is recorded yet
+
     // Get last 14 days of history, aggregated by date
-    auto history = db.get_history(14);
+    auto history = db.get_history(14, "", -1, '*', granularity);
 
     // Aggregate per date (sum all entities for each day)
     std::map<std::string, double> daily_totals;
@@ -68,5 +78,5 @@ int store_forecast(Database& db, const ForecastData& data) {
     localtime_s(&lt, &tomorrow);
     char date[16];
     snprintf(date, sizeof(date), "%04d-%02d-%02d", lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
-    return db.insert_forecast(date, data.predicted_mb);
+    return db.insert_forecast(date, data.predicted_mb, data.growth_rate);
 }
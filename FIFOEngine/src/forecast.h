@@ -11,8 +11,9 @@ struct ForecastData {
     int    days_available;
 };
 
-// Calculate moving average forecast for tomorrow
-ForecastData compute_forecast(Database& db, double current_total_mb);
+// Calculate moving average forecast for tomorrow from the history stored
+// at one FIFO_GRAN_* level (totals per date are the same at every level)
+ForecastData compute_forecast(Database& db, double current_total_mb, int granularity = 2);
 
 // Store forecast result in database
 int store_forecast(Database& db, const ForecastData& data);
@@ -0,0 +1,336 @@
+#include "forecast_state.h"
+#include "scanner.h"
+#include <algorithm>
+#include <cstdio>
+#include <cstdlib>
+#include <sstream>
+
+// Holt-Winters smoothing factors for level, trend and weekday indices
+static const double ALPHA = 0.3;
+static const double BETA  = 0.1;
+static const double GAMMA = 0.1;
+
+static int weekday(long day) {
+    // 1970-01-01 was a Thursday
+    long w = (day + 4) % 7;
+    return (int)(w < 0 ? w + 7 : w);
+}
+
+void ForecastSeries::add_delta(long day, long today, double delta_mb) {
+    dirty = true;
+    if (last_day >= 0 && day <= last_day) {
+        // Late files in a closed day: correct the ring and sums in place
+        long first_in_ring = last_day - (long)ring.size() + 1;
+        if (day < first_in_ring) return;
+        ring[day - first_in_ring] += delta_mb;
+        sum_y += delta_mb;
+        sum_xy += (double)(day - first_day) * delta_mb;
+        return;
+    }
+    if (day == today) {
+        if (open_day != today) {
+            // Yesterday's open value closes before today's starts
+            if (open_day >= 0) pending[open_day] += open_mb;
+            open_day = today;
+            open_mb = 0;
+        }
+        open_mb += delta_mb;
+        return;
+    }
+    if (day < today) pending[day] += delta_mb;
+}
+
+void ForecastSeries::push(long day, double value) {
+    if ((int)ring.size() >= window_days) {
+        double x0 = (double)(last_day - (long)ring.size() + 1 - first_day);
+        double y0 = ring.front();
+        sum_x -= x0;
+        sum_xx -= x0 * x0;
+        sum_y -= y0;
+        sum_xy -= x0 * y0;
+        ring.pop_front();
+    }
+    double x = (double)(day - first_day);
+    ring.push_back(value);
+    sum_x += x;
+    sum_xx += x * x;
+    sum_y += value;
+    sum_xy += x * value;
+
+    int dow = weekday(day);
+    if (day == first_day) {
+        level = value;
+        trend = 0;
+    } else {
+        double s = season[dow];
+        double prev_level = level;
+        level = ALPHA * (s > 0 ? value / s : value) + (1 - ALPHA) * (level + trend);
+        trend = BETA * (level - prev_level) + (1 - BETA) * trend;
+        if (level > 0) season[dow] = GAMMA * (value / level) + (1 - GAMMA) * s;
+    }
+    last_day = day;
+}
+
+void ForecastSeries::close_through(long day) {
+    if (open_day >= 0 && open_day <= day) {
+        pending[open_day] += open_mb;
+        open_day = -1;
+        open_mb = 0;
+        dirty = true;
+    }
+    if (last_day < 0) {
+        if (pending.empty() || pending.begin()->first > day) return;
+        first_day = pending.begin()->first;
+        last_day = first_day - 1;
+    }
+    if (last_day >= day) return;
+
+    for (long d = last_day + 1; d <= day; ++d) {
+        auto it = pending.find(d);
+        push(d, it != pending.end() ? it->second : 0.0);
+    }
+    pending.erase(pending.begin(), pending.upper_bound(day));
+    dirty = true;
+}
+
+bool ForecastSeries::expected(int ahead, const std::string& model, double* out) const {
+    int n = (int)ring.size();
+    if (n < 2) return false;
+
+    if (model == "holt_winters") {
+        double v = (level + trend * ahead) * season[weekday(last_day + ahead)];
+        *out = std::max(0.0, v);
+        return true;
+    }
+
+    // 7-day moving average of daily ingest, trend over the whole window
+    int window = std::min(7, n);
+    double avg = 0;
+    for (int i = n - window; i < n; ++i) avg += ring[i];
+    avg /= window;
+
+    double denom = n * sum_xx - sum_x * sum_x;
+    double slope = denom > 0 ? (n * sum_xy - sum_x * sum_y) / denom : 0;
+
+    // The average sits mid-window, `ahead` days before the target
+    double center = (window - 1) / 2.0;
+    *out = std::max(0.0, avg + slope * (center + ahead));
+    return true;
+}
+
+static std::string join_values(const double* values, size_t count) {
+    std::string out;
+    char buf[32];
+    for (size_t i = 0; i < count; ++i) {
+        snprintf(buf, sizeof(buf), i ? " %.17g" : "%.17g", values[i]);
+        out += buf;
+    }
+    return out;
+}
+
+static std::vector<double> split_values(const std::string& text) {
+    std::vector<double> values;
+    std::istringstream in(text);
+    double v;
+    while (in >> v) values.push_back(v);
+    return values;
+}
+
+static ForecastStateRecord to_record(int entity_id, const ForecastSeries& s) {
+    ForecastStateRecord rec;
+    rec.entity_id = entity_id;
+    rec.window_days = s.window_days;
+    rec.first_day = s.first_day;
+    rec.last_day = s.last_day;
+    rec.open_day = s.open_day;
+    rec.open_mb = s.open_mb;
+    std::vector<double> ring(s.ring.begin(), s.ring.end());
+    rec.ring = join_values(ring.data(), ring.size());
+    rec.level = s.level;
+    rec.trend = s.trend;
+    rec.season = join_values(s.season, 7);
+    return rec;
+}
+
+static void from_record(const ForecastStateRecord& rec, ForecastSeries& s) {
+    s = ForecastSeries();
+    s.window_days = rec.window_days;
+    s.first_day = rec.first_day;
+    s.last_day = rec.last_day;
+    s.open_day = rec.open_day;
+    s.open_mb = rec.open_mb;
+    s.level = rec.level;
+    s.trend = rec.trend;
+    auto season = split_values(rec.season);
+    for (size_t i = 0; i < 7 && i < season.size(); ++i) s.season[i] = season[i];
+
+    // Running sums are recomputed from the ring so they never drift across restarts
+    auto ring = split_values(rec.ring);
+    long day = s.last_day - (long)ring.size() + 1;
+    for (double y : ring) {
+        double x = (double)(day - s.first_day);
+        s.ring.push_back(y);
+        s.sum_x += x;
+        s.sum_xx += x * x;
+        s.sum_y += y;
+        s.sum_xy += x * y;
+        day++;
+    }
+}
+
+ForecastSeries& ForecastState::series_in(ForecastSeries& total,
+                                         std::vector<ForecastSeries>& entities,
+                                         int window, int entity_id) {
+    if (entity_id < 0) return total;
+    if (entity_id >= (int)entities.size()) {
+        ForecastSeries blank;
+        blank.window_days = window;
+        entities.resize(entity_id + 1, blank);
+    }
+    return entities[entity_id];
+}
+
+int ForecastState::persist_series(Database& db, ForecastSeries& total,
+                                  std::vector<ForecastSeries>& entities, bool all) {
+    if (all || total.dirty) {
+        if (db.upsert_forecast_state(to_record(-1, total)) != 0) return -1;
+        total.dirty = false;
+    }
+    for (int id = 0; id < (int)entities.size(); ++id) {
+        ForecastSeries& s = entities[id];
+        if (s.first_day < 0 && s.open_day < 0 && s.pending.empty()) continue;
+        if (!all && !s.dirty) continue;
+        if (db.upsert_forecast_state(to_record(id, s)) != 0) return -1;
+        s.dirty = false;
+    }
+    return 0;
+}
+
+int ForecastState::ensure(Database& db) {
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        if (loaded_) return 0;
+
+        int window = std::atoi(db.get_config("forecast_history_days", "14").c_str());
+        if (window < 2) window = 14;
+        window_ = window;
+        model_ = db.get_config("forecast_model", "regression");
+
+        auto rows = db.get_forecast_states();
+        bool usable = !stale_ && !rows.empty();
+        for (auto& r : rows) {
+            if (r.window_days != window_) usable = false;
+        }
+        if (usable) {
+            total_ = ForecastSeries();
+            total_.window_days = window_;
+            entities_.clear();
+            for (auto& r : rows) from_record(r, series(r.entity_id));
+            loaded_ = true;
+            return 0;
+        }
+    }
+    return rebuild(db);
+}
+
+int ForecastState::rebuild(Database& db) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    int window = std::atoi(db.get_config("forecast_history_days", "14").c_str());
+    window_ = window < 2 ? 14 : window;
+    model_ = db.get_config("forecast_model", "regression");
+
+    total_ = ForecastSeries();
+    total_.window_days = window_;
+    entities_.clear();
+
+    long today = date_ordinal(today_date());
+    for (auto& r : db.get_ingest(-1)) {
+        long day = date_ordinal(r.date);
+        series(r.entity_id).add_delta(day, today, r.size_mb);
+        total_.add_delta(day, today, r.size_mb);
+    }
+    total_.close_through(today - 1);
+    for (auto& s : entities_) s.close_through(today - 1);
+
+    // Stored state stays as it was; the next ensure() tries again
+    if (db.begin() != 0) {
+        loaded_ = false;
+        stale_ = true;
+        return -1;
+    }
+    if (db.clear_forecast_states() != 0 || persist(db, true) != 0) {
+        db.rollback();
+        loaded_ = false;
+        stale_ = true;
+        return -1;
+    }
+    loaded_ = true;
+    stale_ = false;
+    return db.commit();
+}
+
+void ForecastState::invalidate() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    loaded_ = false;
+    stale_ = true;
+}
+
+int ForecastState::apply(Database& db, const std::vector<IngestDelta>& deltas) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    staged_ = false;
+    if (!loaded_) return 0;  // rebuilt from daily_ingest on the next ensure()
+
+    staged_total_ = total_;
+    staged_entities_ = entities_;
+    long today = date_ordinal(today_date());
+    for (auto& d : deltas) {
+        series_in(staged_total_, staged_entities_, window_, d.entity_id)
+            .add_delta(d.day, today, d.delta_mb);
+        staged_total_.add_delta(d.day, today, d.delta_mb);
+    }
+    staged_total_.close_through(today - 1);
+    for (auto& s : staged_entities_) s.close_through(today - 1);
+    staged_ = true;
+    return persist_series(db, staged_total_, staged_entities_, false);
+}
+
+void ForecastState::finish_apply(bool committed) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (staged_ && committed) {
+        total_ = std::move(staged_total_);
+        entities_ = std::move(staged_entities_);
+    }
+    staged_ = false;
+    staged_total_ = ForecastSeries();
+    staged_entities_.clear();
+}
+
+bool ForecastState::forecast(int entity_id, double current_mb, ForecastData& fd) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!loaded_) return false;
+    if (entity_id >= (int)entities_.size()) return false;
+
+    ForecastSeries& s = series(entity_id);
+    long today = date_ordinal(today_date());
+    s.close_through(today - 1);  // days may have closed without a scan
+
+    // last_day is yesterday once any closed day is known
+    long ahead = today - s.last_day;
+    double expected_today = 0, expected_tomorrow = 0;
+    if (!s.expected((int)ahead, model_, &expected_today)) return false;
+    s.expected((int)ahead + 1, model_, &expected_tomorrow);
+
+    double today_mb = (s.open_day == today) ? s.open_mb : 0;
+    double remaining_today = std::max(0.0, expected_today - today_mb);
+
+    fd.current_mb = current_mb;
+    fd.days_available = (int)s.ring.size();
+    fd.growth_rate = expected_tomorrow;
+    fd.predicted_mb = current_mb + remaining_today + expected_tomorrow;
+    return true;
+}
+
+ForecastState& forecast_state() {
+    static ForecastState state;
+    return state;
+}
@@ -0,0 +1,96 @@
+#ifndef FORECAST_STATE_H
+#define FORECAST_STATE_H
+
+#include "database.h"
+#include "forecast.h"
+#include <deque>
+#include <map>
+#include <mutex>
+#include <string>
+#include <vector>
+
+// One change to daily_ingest: the row for (entity, day) moved by delta_mb
+struct IngestDelta {
+    int    entity_id;
+    long   day;       // days since 1970-01-01
+    double delta_mb;  // new size minus the previously stored size
+};
+
+// Running state of one ingest series (an entity, or the total over all
+// entities). The last window_days closed days sit in a ring with running
+// least-squares sums; Holt level/trend and day-of-week indices are folded
+// in as each day closes. Updates cost O(1) in the length of the history.
+struct ForecastSeries {
+    int    window_days = 14;
+    long   first_day = -1;   // first day with ingest, -1 while empty
+    long   last_day = -1;    // newest closed day folded in
+    long   open_day = -1;    // today while it is still filling
+    double open_mb = 0;
+    std::deque<double> ring; // closed days last_day-size+1 .. last_day
+    double sum_x = 0, sum_xx = 0, sum_y = 0, sum_xy = 0;  // x = day - first_day
+    double level = 0, trend = 0;
+    double season[7] = {1, 1, 1, 1, 1, 1, 1};  // indexed by weekday, Sunday = 0
+    std::map<long, double> pending;  // days after last_day that have not closed yet
+    bool   dirty = false;
+
+    void add_delta(long day, long today, double delta_mb);
+    void close_through(long day);
+
+    // Expected ingest `ahead` days after last_day under the given model
+    // ("regression" or "holt_winters"); false with fewer than two closed days
+    bool expected(int ahead, const std::string& model, double* out) const;
+
+private:
+    void push(long day, double value);
+};
+
+// Incremental forecast state per entity plus the total, persisted in the
+// forecast_state table. store_scan_results feeds it the ingest rows it
+// changed, so compute_forecast never queries history. The state is rebuilt
+// from daily_ingest only on demand: when none is stored, when
+// forecast_history_days changes, or through fifo_rebuild_forecast_state.
+class ForecastState {
+public:
+    // Load the stored state, rebuilding it when missing or stale. Call
+    // outside a transaction; cheap once loaded.
+    int ensure(Database& db);
+
+    // Replay all of daily_ingest into fresh state and store it
+    int rebuild(Database& db);
+
+    // Mark the state stale so the next ensure() rebuilds it
+    void invalidate();
+
+    // Fold changed ingest rows into a staged copy and store its touched
+    // series, inside the caller's transaction; finish_apply() then makes
+    // the copy current if that transaction committed, or drops it
+    int apply(Database& db, const std::vector<IngestDelta>& deltas);
+    void finish_apply(bool committed);
+
+    // Forecast for one entity, or the total with entity_id -1
+    bool forecast(int entity_id, double current_mb, ForecastData& fd);
+
+private:
+    static ForecastSeries& series_in(ForecastSeries& total, std::vector<ForecastSeries>& entities,
+                                     int window, int entity_id);
+    static int persist_series(Database& db, ForecastSeries& total,
+                              std::vector<ForecastSeries>& entities, bool all);
+    ForecastSeries& series(int entity_id) { return series_in(total_, entities_, window_, entity_id); }
+    int persist(Database& db, bool all) { return persist_series(db, total_, entities_, all); }
+
+    std::mutex  mutex_;
+    bool        loaded_ = false;
+    bool        stale_ = false;
+    int         window_ = 14;
+    std::string model_ = "regression";
+    ForecastSeries total_;
+    std::vector<ForecastSeries> entities_;  // indexed by entity id
+    bool staged_ = false;                   // apply() ran, finish_apply() has not
+    ForecastSeries staged_total_;
+    std::vector<ForecastSeries> staged_entities_;
+};
+
+// Process-wide state shared by the API, scheduler and pipeline
+ForecastState& forecast_state();
+
+#endif // FORECAST_STATE_H
@@ -0,0 +1,112 @@
+#include "intraday.h"
+#include "cleanup.h"
+#include "fifo_api.h"
+#include <algorithm>
+#include <cmath>
+#include <cstdlib>
+
+// Intervals longer than this are daily scans that carry no intraday shape
+static const long long MAX_INTERVAL_SECS = 26 * 3600;
+
+// Projection step
+static const double STEP_HOURS = 0.25;
+
+static int local_hour(time_t t) {
+    struct tm lt;
+    localtime_s(&lt, &t);
+    return lt.tm_hour;
+}
+
+void IntradayModel::fit(const std::vector<UsageSample>& samples, time_t now, int days) {
+    double w[24] = {}, sum[24] = {}, sumsq[24] = {};
+    double all_w = 0, all_sum = 0, all_sumsq = 0;
+    long long since = (long long)now - (long long)days * 86400;
+    intervals_ = 0;
+
+    for (size_t i = 1; i < samples.size(); ++i) {
+        const UsageSample& a = samples[i - 1];
+        const UsageSample& b = samples[i];
+        long long dt = b.sampled_at - a.sampled_at;
+        if (a.sampled_at < since || dt <= 0 || dt > MAX_INTERVAL_SECS) continue;
+        double delta = b.total_mb - a.total_mb;
+        if (delta < 0) continue;
+        double rate = delta * 3600.0 / (double)dt;
+        intervals_++;
+
+        // Weight each local hour by how much of the interval fell in it
+        long long t = a.sampled_at;
+        while (t < b.sampled_at) {
+            long long next = std::min(b.sampled_at, t - t % 3600 + 3600);
+            double hours = (double)(next - t) / 3600.0;
+            int h = local_hour((time_t)t);
+            w[h] += hours;
+            sum[h] += rate * hours;
+            sumsq[h] += rate * rate * hours;
+            t = next;
+        }
+        all_w += dt / 3600.0;
+        all_sum += rate * dt / 3600.0;
+        all_sumsq += rate * rate * dt / 3600.0;
+    }
+
+    all_mean_ = all_w > 0 ? all_sum / all_w : 0;
+    all_spread_ = all_w > 0 ? std::sqrt(std::max(0.0, all_sumsq / all_w - all_mean_ * all_mean_)) : 0;
+    hours_covered_ = 0;
+    for (int h = 0; h < 24; ++h) {
+        seen_[h] = w[h] > 0;
+        if (!seen_[h]) continue;
+        hours_covered_++;
+        mean_[h] = sum[h] / w[h];
+        spread_[h] = std::sqrt(std::max(0.0, sumsq[h] / w[h] - mean_[h] * mean_[h]));
+    }
+}
+
+double IntradayModel::rate(int hour, double z) const {
+    double m = seen_[hour] ? mean_[hour] : all_mean_;
+    double s = seen_[hour] ? spread_[hour] : all_spread_;
+    return std::max(0.0, m + z * s);
+}
+
+double IntradayModel::project(double start_mb, time_t from, double hours, double z) const {
+    double usage = start_mb;
+    for (double done = 0; done < hours; done += STEP_HOURS) {
+        double step = std::min(STEP_HOURS, hours - done);
+        time_t t = from + (time_t)(done * 3600.0);
+        usage += rate(local_hour(t), z) * step;
+    }
+    return usage;
+}
+
+double IntradayModel::hours_to(double start_mb, double target_mb, time_t from, double z,
+                               double horizon_hours) const {
+    if (start_mb >= target_mb) return 0;
+    double usage = start_mb;
+    for (double done = 0; done < horizon_hours; done += STEP_HOURS) {
+        time_t t = from + (time_t)(done * 3600.0);
+        double r = rate(local_hour(t), z);
+        double next = usage + r * STEP_HOURS;
+        if (next >= target_mb) return done + (target_mb - usage) / r;
+        usage = next;
+    }
+    return -1;
+}
+
+IntradayModel load_intraday_model(Database& db, time_t now) {
+    int days = std::atoi(db.get_config("intraday_days", "14").c_str());
+    if (days < 1) days = 14;
+    IntradayModel model;
+    model.fit(db.get_usage_samples((long long)now - (long long)days * 86400), now, days);
+    return model;
+}
+
+int evaluate_intraday(Database& db, double current_mb, double limit_mb, double* amount_to_delete,
+                      double target_pct) {
+    double window = std::atof(db.get_config("cleanup_eta_hours", "0").c_str());
+    if (window <= 0 || limit_mb <= 0) return -1;
+
+    time_t now = time(nullptr);
+    IntradayModel model = load_intraday_model(db, now);
+    if (!model.usable()) return -1;
+    double projected = model.project(current_mb, now, window, INTRADAY_Z);
+    return evaluate_threshold(projected, limit_mb, amount_to_delete, target_pct);
+}
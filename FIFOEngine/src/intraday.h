@@ -0,0 +1,62 @@
+#ifndef INTRADAY_H
+#define INTRADAY_H
+
+#include "database.h"
+#include "cleanup.h"
+#include <ctime>
+#include <vector>
+
+// Hour-of-day ingest profile fitted from the usage samples that every exact
+// scan records. Each pair of consecutive samples gives an average rate over
+// its interval, spread over the local hours it covers; per hour the mean
+// and spread of those rates form the profile. Intervals where usage fell
+// (a cleanup, or files removed by hand) say nothing about ingest and are
+// skipped. Hours never covered fall back to the all-day rate.
+class IntradayModel {
+public:
+    // Fit from samples (oldest first) within the last `days` days of now
+    void fit(const std::vector<UsageSample>& samples, time_t now, int days);
+
+    // Enough coverage to say more than the daily forecast does
+    bool usable() const { return hours_covered_ >= 6; }
+    int  hours_covered() const { return hours_covered_; }
+    int  intervals() const { return intervals_; }
+
+    // MB/hour expected at local hour `hour`, at mean + z * spread (never < 0)
+    double rate(int hour, double z) const;
+
+    // Usage `hours` after `from`, starting at start_mb
+    double project(double start_mb, time_t from, double hours, double z) const;
+
+    // Hours after `from` until usage starting at start_mb reaches target_mb;
+    // 0 when already there, -1 when not within horizon_hours
+    double hours_to(double start_mb, double target_mb, time_t from, double z,
+                    double horizon_hours) const;
+
+private:
+    double mean_[24] = {};
+    double spread_[24] = {};
+    bool   seen_[24] = {};
+    double all_mean_ = 0;
+    double all_spread_ = 0;
+    int    hours_covered_ = 0;
+    int    intervals_ = 0;
+};
+
+// z for the 80% band reported by fifo_time_to_full
+static const double INTRADAY_Z = 1.2816;
+
+// ETAs further out than this are reported as -1
+static const double INTRADAY_HORIZON_HOURS = 14 * 24;
+
+// Fit the model from the database (intraday_days config key, default 14)
+IntradayModel load_intraday_model(Database& db, time_t now);
+
+// Threshold action for usage projected cleanup_eta_hours ahead on the fast
+// edge of the intraday band, so a burst that will cross the cleanup band
+// later today triggers cleanup now. -1 when cleanup_eta_hours is 0 (off)
+// or the model has too little data.
+int evaluate_intraday(Database& db, double current_mb, double limit_mb, double* amount_to_delete,
+                      double target_pct = DEFAULT_TARGET_PCT);
+
+#endif // INTRADAY_H
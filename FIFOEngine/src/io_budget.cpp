@@ -0,0 +1,122 @@
+#include "io_budget.h"
+#include <algorithm>
+#include <atomic>
+#include <cstdlib>
+#include <thread>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+// Backoff tuning: cut the rate when latency exceeds BACKOFF_RATIO times
+// the baseline, restore it below RECOVER_RATIO; at most one step per second
+static const double EWMA_WEIGHT = 0.2;
+static const double BACKOFF_RATIO = 3.0;
+static const double RECOVER_RATIO = 1.5;
+static const double BACKOFF_STEP = 0.7;
+static const double RECOVER_STEP = 0.1;
+static const double MIN_SCALE = 0.1;
+
+static std::atomic<bool> g_background(false);
+
+IoBudget::IoBudget() {
+    clock::time_point now = clock::now();
+    for (auto& b : buckets_) {
+        b.refilled = now;
+        b.adjusted = now;
+    }
+}
+
+void IoBudget::configure(double list_per_sec, double stat_per_sec, double unlink_per_sec,
+                         bool adaptive) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    double rates[3] = {list_per_sec, stat_per_sec, unlink_per_sec};
+    for (int i = 0; i < 3; ++i) {
+        Bucket& b = buckets_[i];
+        b.rate = rates[i] > 0 ? rates[i] : 0;
+        b.tokens = std::min(b.tokens, b.rate);
+        if (!adaptive) b.scale = 1;
+    }
+    adaptive_ = adaptive;
+}
+
+void IoBudget::acquire(IoKind kind, double n) {
+    for (;;) {
+        double wait_secs;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            Bucket& b = buckets_[kind];
+            if (b.rate <= 0) return;
+
+            double rate = b.rate * b.scale;
+            clock::time_point now = clock::now();
+            double elapsed = std::chrono::duration<double>(now - b.refilled).count();
+            b.tokens = std::min(rate, b.tokens + elapsed * rate);
+            b.refilled = now;
+
+            // Requests larger than the burst run into debt instead of waiting forever
+            if (b.tokens >= 0) {
+                b.tokens -= n;
+                return;
+            }
+            wait_secs = -b.tokens / rate;
+        }
+        std::this_thread::sleep_for(std::chrono::duration<double>(std::min(wait_secs, 1.0)));
+    }
+}
+
+void IoBudget::observe(IoKind kind, double secs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!adaptive_) return;
+    Bucket& b = buckets_[kind];
+
+    b.latency = b.latency > 0 ? EWMA_WEIGHT * secs + (1 - EWMA_WEIGHT) * b.latency : secs;
+    if (b.baseline <= 0 || b.latency < b.baseline) {
+        b.baseline = b.latency;
+    } else {
+        b.baseline *= 1.0005;  // a volume that is slower for good re-baselines
+    }
+    if (b.rate <= 0) return;
+
+    clock::time_point now = clock::now();
+    if (now - b.adjusted < std::chrono::seconds(1)) return;
+    if (b.latency > BACKOFF_RATIO * b.baseline && b.scale > MIN_SCALE) {
+        b.scale = std::max(MIN_SCALE, b.scale * BACKOFF_STEP);
+        b.adjusted = now;
+    } else if (b.latency < RECOVER_RATIO * b.baseline && b.scale < 1) {
+        b.scale = std::min(1.0, b.scale + RECOVER_STEP);
+        b.adjusted = now;
+    }
+}
+
+double IoBudget::effective_rate(IoKind kind) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return buckets_[kind].rate * buckets_[kind].scale;
+}
+
+IoBudget& io_budget() {
+    static IoBudget budget;
+    return budget;
+}
+
+void load_io_budget(Database& db) {
+    double list = std::atof(db.get_config("io_list_per_sec", "0").c_str());
+    double stat = std::atof(db.get_config("io_stat_per_sec", "0").c_str());
+    double unlink = std::atof(db.get_config("io_unlink_per_sec", "0").c_str());
+    bool adaptive = db.get_config("io_adaptive", "1") != "0";
+    io_budget().configure(list, stat, unlink, adaptive);
+    g_background.store(db.get_config("io_background", "0") == "1");
+}
+
+BackgroundIoScope::BackgroundIoScope() : entered_(false) {
+    if (g_background.load())
+        entered_ = SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_BEGIN) != 0;
+}
+
+BackgroundIoScope::~BackgroundIoScope() {
+    if (entered_) SetThreadPriority(GetCurrentThread(), THREAD_MODE_BACKGROUND_END);
+}
@@ -0,0 +1,75 @@
+#ifndef IO_BUDGET_H
+#define IO_BUDGET_H
+
+#include "database.h"
+#include <chrono>
+#include <mutex>
+
+// Kinds of filesystem operation the engine meters
+enum IoKind {
+    IO_LIST = 0,    // one directory listing (FindFirstFile / handle enumeration)
+    IO_STAT = 1,    // one metadata record: a listed entry or an attribute query
+    IO_UNLINK = 2   // one DeleteFileA
+};
+
+// Token-bucket budgets for the engine's filesystem traffic, so scans and
+// cleanups cannot crowd out the producers writing into today's folders.
+// Each kind refills at its configured rate (0 = unlimited) with one second
+// of burst. With adaptive backoff on, the measured latency of each kind is
+// tracked against its own baseline: when it climbs well above, the rate
+// is cut until latency recovers, then restored step by step.
+class IoBudget {
+public:
+    IoBudget();
+
+    // Rates in operations per second, 0 for unlimited
+    void configure(double list_per_sec, double stat_per_sec, double unlink_per_sec,
+                   bool adaptive);
+
+    // Block until n operations of this kind fit the budget
+    void acquire(IoKind kind, double n = 1);
+
+    // Latency of one completed operation, for the adaptive backoff
+    void observe(IoKind kind, double secs);
+
+    // Current rate after backoff, 0 when unlimited
+    double effective_rate(IoKind kind);
+
+private:
+    typedef std::chrono::steady_clock clock;
+
+    struct Bucket {
+        double rate = 0;
+        double scale = 1;          // backoff multiplier, 0.1 .. 1
+        double tokens = 0;
+        clock::time_point refilled;
+        double latency = 0;        // EWMA of observed latency
+        double baseline = 0;       // lowest EWMA seen, drifts up slowly
+        clock::time_point adjusted;
+    };
+
+    std::mutex mutex_;
+    Bucket     buckets_[3];
+    bool       adaptive_ = true;
+};
+
+// Process-wide budget shared by every scan, estimate and cleanup phase
+IoBudget& io_budget();
+
+// Apply the io_* config keys: io_list_per_sec, io_stat_per_sec,
+// io_unlink_per_sec, io_adaptive ("1"/"0") and io_background ("1"/"0")
+void load_io_budget(Database& db);
+
+// Background I/O priority for the calling thread while in scope, when
+// io_background is on: the thread's disk requests then queue behind the
+// producers' at the storage stack
+class BackgroundIoScope {
+public:
+    BackgroundIoScope();
+    ~BackgroundIoScope();
+
+private:
+    bool entered_;
+};
+
+#endif // IO_BUDGET_H
@@ -0,0 +1,302 @@
+#include "journal.h"
+#include "events.h"
+#include "admission.h"
+#include "trace.h"
+#include "entity_registry.h"
+#include "io_budget.h"
+#include "tiering.h"
+#include "lease.h"
+#include <chrono>
+#include <cstdlib>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// Marks per transaction: bounds both the fsync rate and the work that has
+// to be reconciled after a crash
+static const int MARK_BATCH = 32;
+
+// DeleteFileA under the unlink budget, feeding its latency to the backoff
+static bool budgeted_unlink(const char* path) {
+    IoBudget& budget = io_budget();
+    budget.acquire(IO_UNLINK);
+    auto start = std::chrono::steady_clock::now();
+    bool ok = DeleteFileA(path) != 0;
+    budget.observe(IO_UNLINK, std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count());
+    return ok;
+}
+
+static bool exists(const std::string& path) {
+    io_budget().acquire(IO_STAT);
+    return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+// Marks and log rows for finished intents, in one transaction
+static int commit_finished(Database& db, long long batch_id, std::vector<FinishedIntent>& done) {
+    if (done.empty()) return 0;
+    if (db.begin() != 0) return -1;
+    for (auto& d : done) {
+        if (!d.log_as.empty() && d.dest.empty()) {
+            DeletionRecord dr;
+            dr.file_path = d.path;
+            dr.asset = entity_registry().key(d.entity_id).asset;
+            dr.size_mb = d.size_mb;
+            dr.reason = d.log_as;
+            db.log_deletion(dr);
+        } else if (!d.log_as.empty()) {
+            TieringRecord tr;
+            tr.source_path = d.path;
+            tr.dest_path = d.dest;
+            tr.asset = entity_registry().key(d.entity_id).asset;
+            tr.size_mb = d.size_mb;
+            tr.method = d.log_as;
+            db.log_tiering(tr);
+        }
+        db.mark_cleanup_intent(batch_id, d.seq, d.state);
+    }
+    done.clear();
+    return db.commit();
+}
+
+static FinishedIntent finished_intent(int seq, int state, const std::string& path,
+                                      int entity_id, double size_mb) {
+    FinishedIntent d;
+    d.seq = seq;
+    d.state = state;
+    d.path = path;
+    d.entity_id = entity_id;
+    d.size_mb = size_mb;
+    return d;
+}
+
+// Day folder of ASSET\Index\E|F\Year\Month\Day\file as YYYYMMDD, 0 if
+// the path does not end that way
+static int path_day(const std::string& path) {
+    int parts[3];
+    size_t end = path.find_last_of("\\/");
+    for (int i = 2; i >= 0; --i) {
+        if (end == std::string::npos || end == 0) return 0;
+        size_t start = path.find_last_of("\\/", end - 1);
+        size_t from = start == std::string::npos ? 0 : start + 1;
+        parts[i] = std::atoi(path.substr(from, end - from).c_str());
+        end = start;
+    }
+    return parts[0] * 10000 + parts[1] * 100 + parts[2];
+}
+
+static const char* method_name(TierMethod m) {
+    return m == TIER_RENAME ? "RENAME" : "COPY";
+}
+
+CleanupJournal::CleanupJournal(Database& db, const std::string& root_path, const char* reason,
+                               const std::string& cold_root, bool verify_content)
+    : db_(db), root_(root_path), reason_(reason), cold_root_(cold_root),
+      verify_content_(verify_content) {
+    lease_root_ = root_lease().owns(root_path) ? root_path : root_lease().root();
+}
+
+bool CleanupJournal::leased() {
+    if (!lost_ && (lease_root_.empty() || !root_lease().owns(lease_root_))) lost_ = true;
+    return !lost_;
+}
+
+CleanupJournal::~CleanupJournal() { close(); }
+
+int CleanupJournal::plan(const std::vector<ScannedFile>& files) {
+    if (files.empty()) return next_seq_;
+    flush();
+    if (!leased()) return -1;
+
+    if (db_.begin() != 0) return -1;
+    bool opening = batch_id_ < 0;
+    if (opening) batch_id_ = db_.open_cleanup_batch(root_, reason_, cold_root_, lease_root_);
+    bool ok = batch_id_ >= 0;
+    int first = next_seq_;
+    std::map<int, std::string> dests;
+    for (size_t i = 0; ok && i < files.size(); ++i) {
+        const ScannedFile& f = files[i];
+        // The move never replaces, so a cold path taken now stays taken
+        std::string dst;
+        if (!cold_root_.empty()) {
+            dst = free_cold_path(cold_path_for(root_, cold_root_, f.full_path));
+            if (dst.empty()) continue;   // stays unplanned; remove() skips it
+            dests[first + (int)i] = dst;
+        }
+        ok = db_.add_cleanup_intent(batch_id_, first + (int)i, f.full_path,
+                                    f.entity_id, f.size_mb, dst) == 0;
+    }
+    if (!ok || db_.commit() != 0) {
+        db_.rollback();
+        if (next_seq_ == 0) batch_id_ = -1;  // the batch row was rolled back too
+        return -1;
+    }
+    dests_.insert(dests.begin(), dests.end());
+    next_seq_ = first + (int)files.size();
+    if (opening) {
+        opened_ = std::chrono::steady_clock::now();
+        double planned_mb = 0;
+        for (auto& f : files) planned_mb += f.size_mb;
+        event_bus().cleanup_started(planned_mb);
+    }
+    return first;
+}
+
+void CleanupJournal::finished(const FinishedIntent& done) {
+    pending_.push_back(done);
+    if ((int)pending_.size() >= MARK_BATCH) flush();
+}
+
+void CleanupJournal::flush() {
+    // A failed commit leaves the files reconciled by the next resume
+    if (commit_finished(db_, batch_id_, pending_) != 0) {
+        db_.rollback();
+        pending_.clear();
+    }
+}
+
+bool CleanupJournal::remove(const ScannedFile& f, int seq) {
+    if (batch_id_ < 0 || !leased()) return false;
+    FinishedIntent done = finished_intent(seq, INTENT_SKIPPED, f.full_path,
+                                          f.entity_id, f.size_mb);
+
+    if (!cold_root_.empty()) {
+        auto planned = dests_.find(seq);
+        if (planned == dests_.end()) return false;   // no free cold path, never planned
+        std::string dst = planned->second;
+        dests_.erase(planned);
+        TierMethod m = tier_file(f.full_path, dst, verify_content_);
+        if (m == TIER_FAILED) {
+            finished(done);
+            return false;
+        }
+        size_t slash = f.full_path.find_last_of("\\/");
+        if (slash != std::string::npos) vacated_.insert(f.full_path.substr(0, slash));
+        done.dest = dst;
+        done.log_as = method_name(m);
+    } else {
+        if (!budgeted_unlink(f.full_path.c_str())) {
+            finished(done);
+            return false;
+        }
+        done.log_as = reason_;
+    }
+
+    done.state = INTENT_DELETED;
+    finished(done);
+    removed_++;
+    removed_mb_ += f.size_mb;
+    admission().on_freed(root_, f.size_mb);
+    trace_recorder().removed(f);
+    return true;
+}
+
+void CleanupJournal::close() {
+    flush();
+
+    // Tiered day folders that are now empty go too; non-empty ones stay
+    for (auto& dir : vacated_) RemoveDirectoryA(dir.c_str());
+    vacated_.clear();
+
+    if (batch_id_ < 0) return;
+    db_.close_cleanup_batch(batch_id_);
+    batch_id_ = -1;
+    next_seq_ = 0;
+    dests_.clear();
+    event_bus().cleanup_finished(removed_, removed_mb_);
+    trace_recorder().cleanup_finished(removed_, removed_mb_,
+        std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - opened_).count());
+    removed_ = 0;
+    removed_mb_ = 0;
+}
+
+// Finish one planned intent: the file operation only, the mark and log
+// row are returned for the caller's next transaction
+static FinishedIntent resume_intent(const CleanupBatchRecord& batch,
+                                    const CleanupIntentRecord& intent, bool verify_content,
+                                    ResumeStats& stats) {
+    const std::string& src = intent.file_path;
+    FinishedIntent done = finished_intent(intent.seq, INTENT_SKIPPED, src,
+                                          intent.entity_id, intent.size_mb);
+
+    if (!batch.cold_root.empty()) {
+        // Intents from before dest_path was stored were moved to the plain path
+        bool chosen = !intent.dest_path.empty();
+        std::string dst = chosen ? intent.dest_path
+                                 : cold_path_for(batch.root_path, batch.cold_root, src);
+        if (!exists(src)) {
+            // Moved before the crash, but its mark never committed
+            if (!exists(dst)) return done;
+            done.log_as = "RESUMED";
+            stats.files_reconciled++;
+        } else {
+            // The chosen path was free when planned, so a file there is
+            // this batch's own interrupted copy
+            if (chosen && exists(dst)) budgeted_unlink(dst.c_str());
+            TierMethod m = tier_file(src, dst, verify_content);
+            if (m == TIER_FAILED) return done;
+            done.log_as = method_name(m);
+            stats.files_deleted++;
+        }
+        done.dest = dst;
+    } else if (!exists(src)) {
+        // Unlinked before the crash, but its mark never committed
+        done.log_as = "RESUMED_CLEANUP";
+        stats.files_reconciled++;
+    } else {
+        if (!budgeted_unlink(src.c_str())) return done;
+        done.log_as = batch.reason;
+        stats.files_deleted++;
+    }
+    done.state = INTENT_DELETED;
+    stats.mb_freed += intent.size_mb;
+
+    ScannedFile f{};
+    f.full_path = src;
+    f.size_mb = intent.size_mb;
+    f.entity_id = intent.entity_id;
+    f.day = path_day(src);
+    admission().on_freed(batch.root_path, intent.size_mb);
+    trace_recorder().removed(f);
+    return done;
+}
+
+ResumeStats resume_cleanup_batches(Database& db, bool (*can_delete)(const std::string& root)) {
+    ResumeStats stats{};
+    bool verify_content = db.get_config("tier_verify", "size") == "content";
+    for (auto& batch : db.get_open_cleanup_batches()) {
+        // A cold-tier batch is covered by the lease of the root it serves;
+        // batches from before lease_root was recorded name only their own
+        const std::string& lease = batch.lease_root.empty() ? batch.root_path : batch.lease_root;
+        if (can_delete && !can_delete(lease)) continue;
+        stats.batches++;
+
+        std::vector<CleanupIntentRecord> intents = db.get_planned_intents(batch.id);
+        double planned_mb = 0;
+        for (auto& intent : intents) planned_mb += intent.size_mb;
+        event_bus().cleanup_started(planned_mb);
+        auto opened = std::chrono::steady_clock::now();
+        int files_before = stats.files_deleted + stats.files_reconciled;
+        double mb_before = stats.mb_freed;
+
+        // File operations run outside the transactions, as in CleanupJournal
+        std::vector<FinishedIntent> done;
+        for (auto& intent : intents) {
+            done.push_back(resume_intent(batch, intent, verify_content, stats));
+            if ((int)done.size() >= MARK_BATCH && commit_finished(db, batch.id, done) != 0)
+                db.rollback();
+        }
+        bool closed = commit_finished(db, batch.id, done) == 0;
+        if (!closed) db.rollback();   // left open: the next resume reconciles it
+        else db.close_cleanup_batch(batch.id);
+
+        int files = stats.files_deleted + stats.files_reconciled - files_before;
+        double mb = stats.mb_freed - mb_before;
+        event_bus().cleanup_finished(files, mb);
+        trace_recorder().cleanup_finished(files, mb,
+            std::chrono::duration<double, std::milli>(std::chrono::steady_clock::now() - opened).count());
+    }
+    return stats;
+}
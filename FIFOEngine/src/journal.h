@@ -0,0 +1,99 @@
+#ifndef JOURNAL_H
+#define JOURNAL_H
+
+#include "database.h"
+#include "scanner.h"
+#include <chrono>
+#include <map>
+#include <set>
+#include <string>
+#include <vector>
+
+// A removed or skipped intent waiting to be marked, with the deletion_log
+// or tiering_log row that goes in the same transaction
+struct FinishedIntent {
+    int         seq;
+    int         state;        // INTENT_DELETED or INTENT_SKIPPED
+    std::string path;
+    std::string dest;         // cold-root path when tiered, else empty
+    std::string log_as;       // deletion reason or tiering method; empty = no row
+    int         entity_id;
+    double      size_mb;
+};
+
+// Write-ahead intent journal for cleanup. Every file a cleanup pass is
+// about to delete is stored in cleanup_intent (one committed transaction)
+// before the first unlink; each unlink is then marked together with its
+// deletion_log row. The marks are buffered and committed in small
+// transactions between unlinks, so no write transaction is held across
+// the (budgeted, possibly slow) file operations. A crash leaves the
+// batch open with a precise list of what may still be pending, which
+// resume_cleanup_batches() finishes at the next fifo_init without a scan.
+// With a cold root the files are moved there instead (see tier_file) and
+// logged to tiering_log; the batch records the cold root and each intent
+// the free cold path chosen for it, so a resume finds the same file.
+// Nothing is planned or removed once the process no longer holds the lease
+// it had when the journal was created (the root's own, or for a cold root
+// the lease of the root it serves): the new owner may already be deleting.
+class CleanupJournal {
+public:
+    // reason is the deletion_log reason for every file removed by the batch
+    CleanupJournal(Database& db, const std::string& root_path, const char* reason,
+                   const std::string& cold_root = "", bool verify_content = false);
+    ~CleanupJournal();
+
+    // Persist the planned deletions; returns the seq of files[0] (the rest
+    // follow consecutively), or -1 if the plan could not be stored, in
+    // which case nothing must be deleted.
+    int plan(const std::vector<ScannedFile>& files);
+
+    // Delete (or tier) one planned file and mark its intent; false if it
+    // could not be removed from the root (the intent is marked skipped) or
+    // the lease was lost (the intent stays planned)
+    bool remove(const ScannedFile& f, int seq);
+
+    // The lease was lost during the batch
+    bool lease_lost() const { return lost_; }
+
+    // Commit outstanding marks and close the batch
+    void close();
+
+private:
+    bool leased();
+    void finished(const FinishedIntent& done);
+    void flush();
+
+    Database&   db_;
+    std::string root_;
+    std::string reason_;
+    std::string cold_root_;
+    std::string lease_root_;        // root whose lease guards the batch
+    bool        lost_ = false;
+    bool        verify_content_;
+    std::set<std::string> vacated_;  // day folders files were tiered out of
+    std::map<int, std::string> dests_;  // seq -> cold path stored with the intent
+    long long   batch_id_ = -1;
+    int         next_seq_ = 0;
+    std::chrono::steady_clock::time_point opened_;
+    int         removed_ = 0;       // files removed since the batch opened
+    double      removed_mb_ = 0;
+    std::vector<FinishedIntent> pending_;   // not yet committed
+};
+
+struct ResumeStats {
+    int    batches;
+    int    files_deleted;   // removed by the resume pass
+    int    files_reconciled; // already gone: unlinked before the crash, now logged
+    double mb_freed;
+};
+
+// Finish every open batch whose root this process may delete from:
+// can_delete(root) is asked once per batch with the root whose lease
+// covered it (for a cold-tier batch, the root it serves) and should take
+// that root's lease. Files still present are deleted (or tiered), files already gone
+// are logged with reason RESUMED_CLEANUP (or method RESUMED), and the
+// batch is closed. Admission, events and the trace hear about every file
+// freed, as for a live batch.
+ResumeStats resume_cleanup_batches(Database& db, bool (*can_delete)(const std::string& root));
+
+#endif // JOURNAL_H
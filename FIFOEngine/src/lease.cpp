@@ -0,0 +1,251 @@
+#include "lease.h"
+#include "scanner.h"
+#include "fifo_api.h"
+#include <chrono>
+#include <cstdio>
+#include <ctime>
+#include <random>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// The lock byte sits far past the record so readers are never blocked by it
+static const DWORD LOCK_OFFSET = 0x80000000;
+
+static HANDLE open_lease_file(const std::string& path) {
+    return CreateFileA(path.c_str(), GENERIC_READ | GENERIC_WRITE,
+                       FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                       NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_HIDDEN, NULL);
+}
+
+static bool lock_record(HANDLE h) {
+    // Holders only keep the lock for one read-modify-write; give up after ~2 s
+    for (int i = 0; i < 200; ++i) {
+        OVERLAPPED ov = {};
+        ov.Offset = LOCK_OFFSET;
+        if (LockFileEx(h, LOCKFILE_EXCLUSIVE_LOCK | LOCKFILE_FAIL_IMMEDIATELY, 0, 1, 0, &ov))
+            return true;
+        Sleep(10);
+    }
+    return false;
+}
+
+static void unlock_record(HANDLE h) {
+    OVERLAPPED ov = {};
+    ov.Offset = LOCK_OFFSET;
+    UnlockFileEx(h, 0, 1, 0, &ov);
+}
+
+static bool read_record(HANDLE h, LeaseOwner& owner) {
+    owner = LeaseOwner();
+
+    LARGE_INTEGER zero;
+    zero.QuadPart = 0;
+    if (!SetFilePointerEx(h, zero, NULL, FILE_BEGIN)) return false;
+    char buf[256];
+    DWORD n = 0;
+    if (!ReadFile(h, buf, sizeof(buf) - 1, &n, NULL)) return false;
+    buf[n] = 0;
+
+    int pid = 0;
+    char host[128] = {0};
+    unsigned long long token = 0;
+    long long heartbeat = 0;
+    if (sscanf(buf, "%d %127s %llu %lld", &pid, host, &token, &heartbeat) == 4) {
+        owner.pid = pid;
+        owner.host = host;
+        owner.token = token;
+        owner.heartbeat = heartbeat;
+    }
+    return true;
+}
+
+// An empty owner (pid 0) truncates the file, marking the root unowned
+static bool write_record(HANDLE h, const LeaseOwner& owner) {
+    char buf[256];
+    int len = 0;
+    if (owner.pid != 0) {
+        len = snprintf(buf, sizeof(buf), "%d %s %llu %lld\n", owner.pid, owner.host.c_str(),
+                       owner.token, owner.heartbeat);
+    }
+    LARGE_INTEGER zero;
+    zero.QuadPart = 0;
+    if (!SetFilePointerEx(h, zero, NULL, FILE_BEGIN)) return false;
+    DWORD written = 0;
+    if (len > 0 && !WriteFile(h, buf, (DWORD)len, &written, NULL)) return false;
+    if (!SetEndOfFile(h)) return false;
+    FlushFileBuffers(h);
+    return true;
+}
+
+static std::string host_name() {
+    char name[256];
+    DWORD size = sizeof(name);
+    if (!GetComputerNameA(name, &size)) return "unknown";
+    return name;
+}
+
+static bool process_alive(int pid) {
+    HANDLE p = OpenProcess(PROCESS_QUERY_LIMITED_INFORMATION, FALSE, (DWORD)pid);
+    if (!p) return GetLastError() == ERROR_ACCESS_DENIED;  // exists, other user
+    DWORD code = 0;
+    BOOL ok = GetExitCodeProcess(p, &code);
+    CloseHandle(p);
+    return ok && code == STILL_ACTIVE;
+}
+
+RootLease::RootLease() {}
+
+RootLease::~RootLease() { release(); }
+
+int RootLease::acquire(const std::string& root_path, int stale_secs) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (held_.load() && root_path == root_) return 0;
+
+    if (held_.load()) {
+        // Switching roots: hand the old one back first
+        HANDLE old = open_lease_file(path_);
+        if (old != INVALID_HANDLE_VALUE) {
+            LeaseOwner owner;
+            if (lock_record(old)) {
+                if (read_record(old, owner) && owner.token == token_) write_record(old, LeaseOwner());
+                unlock_record(old);
+            }
+            CloseHandle(old);
+        }
+        held_.store(false);
+    }
+
+    std::string path = path_join(root_path, ".fifo.lease");
+    HANDLE h = open_lease_file(path);
+    if (h == INVALID_HANDLE_VALUE) return FIFO_ERR_PATH;
+    if (!lock_record(h)) {
+        CloseHandle(h);
+        return FIFO_ERR_LEASED;
+    }
+
+    LeaseOwner owner;
+    read_record(h, owner);
+    int my_pid = (int)GetCurrentProcessId();
+    std::string my_host = host_name();
+    long long now = (long long)time(nullptr);
+
+    bool available = owner.pid == 0 ||
+                     (owner.pid == my_pid && owner.host == my_host) ||
+                     now - owner.heartbeat > stale_secs ||
+                     (owner.host == my_host && !process_alive(owner.pid));
+    if (!available) {
+        unlock_record(h);
+        CloseHandle(h);
+        return FIFO_ERR_LEASED;
+    }
+
+    std::mt19937_64 rng((unsigned long long)now ^ ((unsigned long long)my_pid << 32) ^
+                        (unsigned long long)std::random_device()());
+    LeaseOwner me;
+    me.pid = my_pid;
+    me.host = my_host;
+    me.token = rng() | 1;
+    me.heartbeat = now;
+    bool ok = write_record(h, me);
+    unlock_record(h);
+    CloseHandle(h);
+    if (!ok) return FIFO_ERR_PATH;
+
+    root_ = root_path;
+    path_ = path;
+    token_ = me.token;
+    stale_secs_ = stale_secs > 3 ? stale_secs : 3;
+    held_.store(true);
+
+    if (!running_.load()) {
+        if (thread_.joinable()) thread_.join();
+        running_.store(true);
+        thread_ = std::thread(&RootLease::heartbeat_loop, this);
+    }
+    return 0;
+}
+
+bool RootLease::renew() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!held_.load()) return false;
+
+    HANDLE h = open_lease_file(path_);
+    if (h == INVALID_HANDLE_VALUE) return true;  // share unreachable: retry next beat
+    if (!lock_record(h)) {
+        CloseHandle(h);
+        return true;
+    }
+
+    LeaseOwner owner;
+    bool still_ours = read_record(h, owner) && owner.token == token_ &&
+                      owner.pid == (int)GetCurrentProcessId();
+    if (still_ours) {
+        owner.heartbeat = (long long)time(nullptr);
+        write_record(h, owner);
+    }
+    unlock_record(h);
+    CloseHandle(h);
+    return still_ours;
+}
+
+void RootLease::heartbeat_loop() {
+    while (running_.load()) {
+        // Renew three times per stale period; sleep in 1-second steps for release()
+        int interval = stale_secs_ / 3;
+        for (int i = 0; i < interval && running_.load(); ++i) {
+            std::this_thread::sleep_for(std::chrono::seconds(1));
+        }
+        if (!running_.load()) break;
+        if (held_.load() && !renew()) held_.store(false);
+    }
+}
+
+void RootLease::release() {
+    running_.store(false);
+    if (thread_.joinable()) thread_.join();
+
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!held_.load()) return;
+    HANDLE h = open_lease_file(path_);
+    if (h != INVALID_HANDLE_VALUE) {
+        if (lock_record(h)) {
+            LeaseOwner owner;
+            if (read_record(h, owner) && owner.token == token_) write_record(h, LeaseOwner());
+            unlock_record(h);
+        }
+        CloseHandle(h);
+    }
+    held_.store(false);
+}
+
+bool RootLease::owns(const std::string& root_path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return held_.load() && root_path == root_;
+}
+
+std::string RootLease::root() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    return held_.load() ? root_ : std::string();
+}
+
+bool RootLease::read_owner(const std::string& root_path, LeaseOwner& owner) {
+    std::string path = path_join(root_path, ".fifo.lease");
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_READ,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) {
+        owner = LeaseOwner();
+        return false;
+    }
+    bool ok = read_record(h, owner);
+    CloseHandle(h);
+    return ok;
+}
+
+RootLease& root_lease() {
+    static RootLease lease;
+    return lease;
+}
@@ -0,0 +1,61 @@
+#ifndef LEASE_H
+#define LEASE_H
+
+#include <atomic>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct LeaseOwner {
+    int         pid = 0;            // 0 when the root is unowned
+    std::string host;
+    unsigned long long token = 0;   // random per acquisition, guards against PID reuse
+    long long   heartbeat = 0;      // unix time of the last renewal
+};
+
+// Cross-process lease on a storage root, kept in <root>\.fifo.lease.
+// The file holds the owner's PID, host, token and heartbeat; every read-
+// modify-write of it happens under a short byte-range lock, so two engines
+// (the WPF app and a service, or two hosts on a share) never both own the
+// root. The owner renews the heartbeat from a background thread; a lease
+// whose heartbeat is older than lease_stale_secs, or whose owner process
+// is gone on this host, is taken over. An owner that finds its record
+// replaced on renewal has lost the lease and stops scanning and deleting.
+class RootLease {
+public:
+    RootLease();
+    ~RootLease();
+
+    // 0 when this process holds the lease on root_path (acquiring it if
+    // free or stale), FIFO_ERR_LEASED when another live owner holds it.
+    // Switching roots releases the previous one.
+    int acquire(const std::string& root_path, int stale_secs = 90);
+
+    void release();
+    bool held() const { return held_.load(); }
+    bool owns(const std::string& root_path);
+
+    // The leased root, empty when none is held
+    std::string root();
+
+    // Current record in root_path's lease file, false if there is none
+    static bool read_owner(const std::string& root_path, LeaseOwner& owner);
+
+private:
+    void heartbeat_loop();
+    bool renew();
+
+    std::mutex         mutex_;
+    std::string        root_;
+    std::string        path_;
+    unsigned long long token_ = 0;
+    int                stale_secs_ = 90;
+    std::atomic<bool>  held_{false};
+    std::atomic<bool>  running_{false};
+    std::thread        thread_;
+};
+
+// Process-wide lease shared by the API and the scheduler thread
+RootLease& root_lease();
+
+#endif // LEASE_H
@@ -0,0 +1,140 @@
+#include "log_export.h"
+#include <cstdio>
+#include <cstring>
+#include <memory>
+#include <io.h>
+
+namespace {
+
+class FdWriter {
+public:
+    explicit FdWriter(int fd) : fd_(fd) {}
+
+    void put(const char* data, size_t len) {
+        if (len_ + len > sizeof(buf_)) flush();
+        if (len > sizeof(buf_)) {
+            write_all(data, len);
+            return;
+        }
+        std::memcpy(buf_ + len_, data, len);
+        len_ += len;
+    }
+    void put(const std::string& s) { put(s.data(), s.size()); }
+    void put(char c) { put(&c, 1); }
+
+    void flush() {
+        write_all(buf_, len_);
+        len_ = 0;
+    }
+
+    bool failed() const { return failed_; }
+
+private:
+    void write_all(const char* data, size_t len) {
+        while (len > 0 && !failed_) {
+            int n = _write(fd_, data, (unsigned int)len);
+            if (n <= 0) {
+                failed_ = true;
+                break;
+            }
+            data += n;
+            len -= (size_t)n;
+        }
+    }
+
+    int    fd_;
+    char   buf_[64 * 1024];
+    size_t len_ = 0;
+    bool   failed_ = false;
+};
+
+void put_csv_field(FdWriter& out, const std::string& s) {
+    if (s.find_first_of(",\"\r\n") == std::string::npos) {
+        out.put(s);
+        return;
+    }
+    out.put('"');
+    for (char c : s) {
+        if (c == '"') out.put('"');
+        out.put(c);
+    }
+    out.put('"');
+}
+
+void put_json_string(FdWriter& out, const std::string& s) {
+    out.put('"');
+    for (char c : s) {
+        switch (c) {
+        case '"':  out.put("\\\"", 2); break;
+        case '\\': out.put("\\\\", 2); break;
+        case '\n': out.put("\\n", 2); break;
+        case '\r': out.put("\\r", 2); break;
+        case '\t': out.put("\\t", 2); break;
+        default:
+            if ((unsigned char)c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", (unsigned char)c);
+                out.put(esc, 6);
+            } else {
+                out.put(c);
+            }
+        }
+    }
+    out.put('"');
+}
+
+struct ExportState {
+    FdWriter*    out;
+    ExportFormat format;
+    long long    rows;
+};
+
+bool write_row(const DeletionRecord& r, void* ctx) {
+    ExportState& st = *(ExportState*)ctx;
+    FdWriter& out = *st.out;
+    char num[64];
+
+    if (st.format == EXPORT_NDJSON) {
+        snprintf(num, sizeof(num), "{\"id\":%lld,\"deleted_at\":", r.id);
+        out.put(num, std::strlen(num));
+        put_json_string(out, r.timestamp);
+        out.put(",\"asset\":", 9);
+        put_json_string(out, r.asset);
+        out.put(",\"file_path\":", 13);
+        put_json_string(out, r.file_path);
+        snprintf(num, sizeof(num), ",\"size_mb\":%.6f,\"reason\":", r.size_mb);
+        out.put(num, std::strlen(num));
+        put_json_string(out, r.reason);
+        out.put("}\n", 2);
+    } else {
+        snprintf(num, sizeof(num), "%lld,", r.id);
+        out.put(num, std::strlen(num));
+        put_csv_field(out, r.timestamp);
+        out.put(',');
+        put_csv_field(out, r.asset);
+        out.put(',');
+        put_csv_field(out, r.file_path);
+        snprintf(num, sizeof(num), ",%.6f,", r.size_mb);
+        out.put(num, std::strlen(num));
+        put_csv_field(out, r.reason);
+        out.put("\r\n", 2);
+    }
+    st.rows++;
+    return !out.failed();
+}
+
+} // namespace
+
+int export_deletions(Database& db, const DeletionQuery& q, ExportFormat format, int fd,
+                     long long* rows_written) {
+    // The 64 KB buffer stays off the caller's stack
+    std::unique_ptr<FdWriter> out(new FdWriter(fd));
+    if (format == EXPORT_CSV) out->put(std::string("id,deleted_at,asset,file_path,size_mb,reason\r\n"));
+
+    ExportState st{out.get(), format, 0};
+    int rc = db.stream_deletions(q, write_row, &st);
+    out->flush();
+    if (rows_written) *rows_written = st.rows;
+    if (rc != 0) return -1;
+    return out->failed() ? -2 : 0;
+}
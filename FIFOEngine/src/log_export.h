@@ -0,0 +1,17 @@
+#ifndef LOG_EXPORT_H
+#define LOG_EXPORT_H
+
+#include "database.h"
+
+enum ExportFormat {
+    EXPORT_CSV    = 0,   // header row, RFC 4180 quoting
+    EXPORT_NDJSON = 1    // one JSON object per line
+};
+
+// Stream the matching deletion_log rows to a CRT file descriptor through a
+// fixed 64 KB buffer: memory use does not grow with the row count. Returns
+// 0, -1 on a query error, -2 when the descriptor stops accepting writes.
+int export_deletions(Database& db, const DeletionQuery& q, ExportFormat format, int fd,
+                     long long* rows_written);
+
+#endif // LOG_EXPORT_H
@@ -0,0 +1,117 @@
+#include "oldest_first.h"
+#include "entity_registry.h"
+#include <algorithm>
+
+static std::vector<DirEntry> list_date_dirs(const std::string& dir, size_t width) {
+    std::vector<DirEntry> dirs;
+    for (auto& e : list_dir(dir)) {
+        if (!e.is_dir || !is_number(e.name) || e.name.size() != width) continue;
+        dirs.push_back(e);
+    }
+    std::sort(dirs.begin(), dirs.end(), [](const DirEntry& a, const DirEntry& b) {
+        return a.name < b.name;
+    });
+    return dirs;
+}
+
+std::vector<ScannedFile> list_day_files(const DayFolder& folder, LinkSet* links) {
+    std::vector<ScannedFile> files;
+    for (auto& file_e : list_dir(folder.path)) {
+        if (file_e.is_dir) continue;
+        ScannedFile sf;
+        sf.full_path = path_join(folder.path, file_e.name);
+        sf.size_mb = links ? links->charge_mb(file_e) : (double)file_e.size / (1024.0 * 1024.0);
+        sf.created_time = file_e.write_time;
+        sf.entity_id = folder.entity_id;
+        sf.day = folder.day;
+        files.push_back(sf);
+    }
+    std::sort(files.begin(), files.end(), [](const ScannedFile& a, const ScannedFile& b) {
+        return a.created_time < b.created_time;
+    });
+    return files;
+}
+
+bool OldestFirstIterator::EntityCursor::advance() {
+    for (;;) {
+        if (day_pos < days.size()) {
+            const std::string& year = years[year_pos - 1].name;
+            const std::string& month = months[month_pos - 1].name;
+            const DirEntry& day = days[day_pos];
+            current.path = path_join(path_join(path_join(cat_path, year), month), day.name);
+            current.entity_id = entity_id;
+            current.date = year + "-" + month + "-" + day.name;
+            current.day = std::stoi(year) * 10000 + std::stoi(month) * 100 + std::stoi(day.name);
+            current.write_time = day.write_time;
+            day_pos++;
+            return true;
+        }
+        if (month_pos < months.size()) {
+            const std::string& year = years[year_pos - 1].name;
+            days = list_date_dirs(path_join(path_join(cat_path, year), months[month_pos].name), 2);
+            day_pos = 0;
+            month_pos++;
+            continue;
+        }
+        if (year_pos < years.size()) {
+            months = list_date_dirs(path_join(cat_path, years[year_pos].name), 2);
+            month_pos = 0;
+            days.clear();
+            day_pos = 0;
+            year_pos++;
+            continue;
+        }
+        return false;
+    }
+}
+
+OldestFirstIterator::OldestFirstIterator(const std::string& root_path) : root_(root_path) {
+    for (auto& asset_e : list_dir(root_path)) {
+        if (!asset_e.is_dir) continue;
+        std::string asset_path = path_join(root_path, asset_e.name);
+
+        for (auto& idx_e : list_dir(asset_path)) {
+            if (!idx_e.is_dir || !is_number(idx_e.name)) continue;
+            std::string idx_path = path_join(asset_path, idx_e.name);
+
+            for (auto& cat_e : list_dir(idx_path)) {
+                if (!cat_e.is_dir) continue;
+                if (cat_e.name != "E" && cat_e.name != "F") continue;
+
+                EntityCursor ec;
+                ec.entity_id = entity_registry().intern(asset_e.name, std::stoi(idx_e.name),
+                                                        cat_e.name[0]);
+                ec.cat_path = path_join(idx_path, cat_e.name);
+                ec.years = list_date_dirs(ec.cat_path, 4);
+                if (ec.advance()) entities_.push_back(ec);
+            }
+        }
+    }
+
+    for (size_t i = 0; i < entities_.size(); ++i)
+        heap_.push({entities_[i].current.date, i});
+}
+
+bool OldestFirstIterator::next_folder(DayFolder& out) {
+    if (heap_.empty()) return false;
+    HeapItem top = heap_.top();
+    heap_.pop();
+
+    EntityCursor& ec = entities_[top.entity];
+    out = ec.current;
+    // Look one folder ahead so callers can protect each entity's newest day
+    out.has_newer = ec.advance();
+    if (out.has_newer) heap_.push({ec.current.date, top.entity});
+    return true;
+}
+
+bool OldestFirstIterator::next(ScannedFile& out) {
+    while (pending_pos_ >= pending_.size()) {
+        DayFolder folder;
+        if (!next_folder(folder)) return false;
+        pending_ = list_day_files(folder);
+        pending_pos_ = 0;
+    }
+    out = pending_[pending_pos_++];
+    return true;
+}
@@ -0,0 +1,69 @@
+#ifndef OLDEST_FIRST_H
+#define OLDEST_FIRST_H
+
+#include "scanner.h"
+#include <functional>
+#include <queue>
+#include <string>
+#include <vector>
+
+struct DayFolder {
+    std::string path;
+    int         entity_id;
+    std::string date;       // YYYY-MM-DD
+    int         day;        // same date as YYYYMMDD
+    time_t      write_time; // folder write time from the Month listing
+    bool        has_newer;  // entity has at least one newer day folder
+};
+
+// List the files of one day folder, oldest created_time first. With a
+// LinkSet, hard links already charged by the walk are sized at 0 MB.
+std::vector<ScannedFile> list_day_files(const DayFolder& folder, LinkSet* links = nullptr);
+
+// Lazy oldest-first walk over ASSET\Index\E|F\Year\Month\Day.
+// Year/Month/Day names are fixed width, so sorting directory names gives
+// chronological order without reading any file metadata. Each entity keeps
+// a cursor over its sorted date folders and the entities are k-way merged
+// by date; Month and Day levels are only listed when the cursor reaches
+// them, and files only for the folders actually consumed.
+class OldestFirstIterator {
+public:
+    explicit OldestFirstIterator(const std::string& root_path);
+
+    // Next day folder across all entities, without listing its files
+    bool next_folder(DayFolder& out);
+
+    // Next file in oldest-first order, listing day folders as they are reached
+    bool next(ScannedFile& out);
+
+    const std::string& root() const { return root_; }
+
+private:
+    struct EntityCursor {
+        int         entity_id;
+        std::string cat_path;
+        std::vector<DirEntry> years, months, days;
+        size_t year_pos = 0, month_pos = 0, day_pos = 0;
+        DayFolder current;
+
+        // Move to the next day folder; false once the entity is exhausted
+        bool advance();
+    };
+
+    struct HeapItem {
+        std::string date;
+        size_t      entity;
+        bool operator>(const HeapItem& o) const {
+            if (date != o.date) return date > o.date;
+            return entity > o.entity;
+        }
+    };
+
+    std::string root_;
+    std::vector<EntityCursor> entities_;
+    std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap_;
+    std::vector<ScannedFile> pending_;
+    size_t pending_pos_ = 0;
+};
+
+#endif // OLDEST_FIRST_H
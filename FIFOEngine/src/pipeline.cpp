@@ -0,0 +1,239 @@
+#include "pipeline.h"
+#include "journal.h"
+#include "io_budget.h"
+#include "intraday.h"
+#include "fifo_api.h"
+#include <algorithm>
+#include <chrono>
+#include <condition_variable>
+#include <ctime>
+#include <deque>
+#include <mutex>
+#include <thread>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+namespace {
+
+// Background deleter fed with batches of files while the walk continues;
+// with a cold root configured it tiers them instead
+class StreamingDeleter {
+public:
+    StreamingDeleter(Database& db, const std::string& root_path, const EvictionParams& params,
+                     std::chrono::steady_clock::time_point start)
+        : journal_(db, root_path, "PIPELINED_CLEANUP", params.cold_root, params.verify_content),
+          start_(start),
+          thread_(&StreamingDeleter::run, this) {}
+
+    ~StreamingDeleter() { finish(); }
+
+    void push(std::vector<ScannedFile>&& batch) {
+        if (batch.empty()) return;
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            queue_.push_back(std::move(batch));
+        }
+        cv_.notify_one();
+    }
+
+    // Drain the queue and stop the worker
+    void finish() {
+        {
+            std::lock_guard<std::mutex> lock(mutex_);
+            closed_ = true;
+        }
+        cv_.notify_one();
+        if (thread_.joinable()) thread_.join();
+    }
+
+    int    files_deleted() const { return (int)removed_.size(); }
+    double mb_freed() const { return mb_freed_; }
+    const std::vector<ScannedFile>& removed() const { return removed_; }
+    // Files handed over but still on disk: their batch could not be
+    // journaled, or the unlink (or move) failed
+    std::vector<ScannedFile>& returned() { return returned_; }
+    double first_free_secs() const { return first_free_secs_; }
+
+private:
+    void run() {
+        BackgroundIoScope background;
+        for (;;) {
+            std::vector<ScannedFile> batch;
+            {
+                std::unique_lock<std::mutex> lock(mutex_);
+                cv_.wait(lock, [this] { return closed_ || !queue_.empty(); });
+                if (queue_.empty()) {
+                    journal_.close();
+                    return;
+                }
+                batch = std::move(queue_.front());
+                queue_.pop_front();
+            }
+
+            // The batch is journaled before its first unlink
+            int seq = journal_.plan(batch);
+            if (seq < 0) {
+                for (auto& f : batch) returned_.push_back(std::move(f));
+                continue;
+            }
+            for (auto& f : batch) {
+                if (!journal_.remove(f, seq++)) {
+                    returned_.push_back(std::move(f));
+                    continue;
+                }
+
+                if (first_free_secs_ < 0) {
+                    first_free_secs_ = std::chrono::duration<double>(
+                        std::chrono::steady_clock::now() - start_).count();
+                }
+
+                removed_.push_back(f);
+                mb_freed_ += f.size_mb;
+            }
+        }
+    }
+
+    CleanupJournal journal_;
+    std::chrono::steady_clock::time_point start_;
+    std::mutex mutex_;
+    std::condition_variable cv_;
+    std::deque<std::vector<ScannedFile>> queue_;
+    bool closed_ = false;
+    std::vector<ScannedFile> removed_;
+    std::vector<ScannedFile> returned_;
+    double mb_freed_ = 0;
+    double first_free_secs_ = -1;
+    std::thread thread_;
+};
+
+} // namespace
+
+PipelineResult execute_pipelined(Database& db, const std::string& root_path,
+                                 int granularity, double limit_mb, double target_pct,
+                                 const EvictionParams& params) {
+    PipelineResult result{};
+    result.first_free_secs = -1;
+    auto start = std::chrono::steady_clock::now();
+
+    // Early budget from the previous run's forecast, less what that run (or
+    // anything since) already freed, as the forecast is stored before its
+    // cleanup; grows with the running total once the scanned bytes alone
+    // cross the cleanup band.
+    double prev_amount = 0;
+    double prev_mb = db.get_latest_forecast() - db.get_freed_since_forecast(root_path);
+    evaluate_threshold(std::max(prev_mb, 0.0), limit_mb, &prev_amount, target_pct);
+
+    int max_deletions = params.max_deletions;
+    bool streaming = params.policy == "fifo";
+    time_t cutoff = time(nullptr) - (params.min_retention_hours * 3600);
+    double queued_mb = 0;
+    int queued_files = 0;
+
+    ScanAggregator agg;
+    ScanResult& scan = result.scan;
+    scan.root_path = root_path;
+    scan.total_mb = 0;
+    scan.total_files = 0;
+    scan.granularity = granularity;
+
+    {
+        StreamingDeleter deleter(db, root_path, params, start);
+
+        OldestFirstIterator oldest(root_path);
+        LinkSet links;
+        FileSink kept(scan);
+        DayFolder folder;
+        while (oldest.next_folder(folder)) {
+            std::vector<ScannedFile> files = list_day_files(folder, &links);
+            DayIngest ingest{folder.entity_id, folder.day, 0, 0, folder.write_time};
+            for (auto& sf : files) {
+                agg.add(sf);
+                scan.total_mb += sf.size_mb;
+                scan.total_files++;
+                ingest.size_mb += sf.size_mb;
+                ingest.file_count++;
+            }
+            scan.daily.push_back(ingest);
+
+            double running_amount = 0;
+            evaluate_threshold(scan.total_mb, limit_mb, &running_amount, target_pct);
+            double need = std::max(prev_amount, running_amount);
+
+            // Never stream an entity's newest day folder; the reconcile pass
+            // applies the regular keep-minimum rule to whatever is left.
+            std::vector<ScannedFile> batch;
+            for (auto& f : files) {
+                bool eligible = streaming && folder.has_newer &&
+                                queued_mb < need &&
+                                queued_files < max_deletions &&
+                                f.created_time <= cutoff;
+                if (eligible) {
+                    queued_mb += f.size_mb;
+                    queued_files++;
+                    batch.push_back(f);
+                } else {
+                    kept.add(f);
+                }
+            }
+            deleter.push(std::move(batch));
+        }
+        // What the deleter could not remove is still there for the reconcile
+        deleter.finish();
+        for (auto& f : deleter.returned()) kept.add(f);
+        kept.finish();
+
+        result.early_files_deleted = deleter.files_deleted();
+        result.early_mb_freed = deleter.mb_freed();
+        result.first_free_secs = deleter.first_free_secs();
+
+        // Stored usage is what is left; the day folders' ingest keeps them,
+        // as it does when a sequential cleanup runs after the scan
+        for (auto& f : deleter.removed()) agg.remove(f);
+        scan.total_mb -= result.early_mb_freed;
+        scan.total_files -= result.early_files_deleted;
+    }
+
+    scan.entries = agg.all_entries(today_date());
+    store_scan_results(db, scan);
+
+    result.forecast = compute_forecast(db, scan.total_mb, granularity);
+    store_forecast(db, result.forecast);
+
+    // Reconcile against the final totals, escalating when an intraday burst
+    // crosses a band first, as the sequential cycle does
+    double amount = 0;
+    result.action = evaluate_threshold(result.forecast.predicted_mb, limit_mb, &amount, target_pct);
+    double eta_amount = 0;
+    int eta_action = evaluate_intraday(db, scan.total_mb, limit_mb, &eta_amount, target_pct);
+    if (eta_action > result.action) {
+        result.action = eta_action;
+        amount = eta_amount;
+    }
+
+    result.cleanup.files_deleted = result.early_files_deleted;
+    result.cleanup.mb_freed = result.early_mb_freed;
+
+    // The totals are already net of the early deletions, so amount is
+    // what is still over the target
+    int remaining_deletions = max_deletions - result.early_files_deleted;
+    if (result.action == FIFO_ACTION_CLEANUP && amount > 0 && remaining_deletions > 0) {
+        EvictionParams rest = params;
+        rest.max_deletions = remaining_deletions;
+        auto stats = cleanup_scan(db, scan, amount, rest);
+        result.cleanup.files_deleted += stats.files_deleted;
+        result.cleanup.mb_freed += stats.mb_freed;
+        if (result.first_free_secs < 0 && stats.files_deleted > 0) {
+            result.first_free_secs = std::chrono::duration<double>(
+                std::chrono::steady_clock::now() - start).count();
+        }
+    }
+    result.cleanup.new_usage_mb = scan.total_mb - (result.cleanup.mb_freed - result.early_mb_freed);
+
+    return result;
+}
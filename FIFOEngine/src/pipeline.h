@@ -0,0 +1,33 @@
+#ifndef PIPELINE_H
+#define PIPELINE_H
+
+#include "database.h"
+#include "scanner.h"
+#include "forecast.h"
+#include "cleanup.h"
+#include "oldest_first.h"
+#include <string>
+
+struct PipelineResult {
+    ScanResult   scan;
+    ForecastData forecast;
+    int          action;
+    CleanupStats cleanup;          // early + reconcile deletions combined
+    int          early_files_deleted;
+    double       early_mb_freed;
+    double       first_free_secs;  // seconds until the first byte was freed, -1 if none
+};
+
+// Pipelined scan + cleanup: walks day folders oldest-first across all
+// entities and streams eligible files to a deleter thread while newer
+// folders are still being listed. The early budget comes from the previous
+// stored forecast and the running scan total; once the walk completes the
+// regular forecast/evaluate runs (with the intraday escalation) and any
+// remaining amount is deleted from the files that were kept. Streaming is strict oldest-first, so it only
+// happens under the fifo policy; other policies need the full file set and
+// do all their deleting in the reconcile step.
+PipelineResult execute_pipelined(Database& db, const std::string& root_path,
+                                 int granularity, double limit_mb, double target_pct,
+                                 const EvictionParams& params);
+
+#endif // PIPELINE_H
@@ -1,34 +1,104 @@
 #include "scanner.h"
+#include "entity_registry.h"
+#include "fifo_api.h"
+#include "tsstore.h"
+#include "forecast_state.h"
+#include "io_budget.h"
+#include "events.h"
+#include "admission.h"
+#include "trace.h"
+#include "spill.h"
 #include <algorithm>
-#include <map>
+#include <atomic>
+#include <chrono>
+#include <mutex>
 #include <ctime>
 #include <cstring>
 #include <cstdio>
+#include <cstdlib>
 
 #ifndef WIN32_LEAN_AND_MEAN
 #define WIN32_LEAN_AND_MEAN
 #endif
 #include <windows.h>
 
-static bool is_number(const std::string& s) {
+bool is_number(const std::string& s) {
     return !s.empty() && std::all_of(s.begin(), s.end(), ::isdigit);
 }
 
-static std::string path_join(const std::string& a, const std::string& b) {
+std::string path_join(const std::string& a, const std::string& b) {
     if (a.empty()) return b;
     char last = a.back();
     if (last == '\\' || last == '/') return a + b;
     return a + "\\" + b;
 }
 
-struct DirEntry {
-    std::string name;
-    bool is_dir;
-    ULONGLONG size;
-    FILETIME ft_write;
-};
+static time_t filetime_to_time_t(const FILETIME& ft) {
+    ULARGE_INTEGER ull;
+    ull.LowPart = ft.dwLowDateTime;
+    ull.HighPart = ft.dwHighDateTime;
+    return (time_t)((ull.QuadPart - 116444736000000000ULL) / 10000000ULL);
+}
+
+static std::atomic<int> g_accounting(SIZE_LOGICAL);
+
+void set_size_accounting(SizeAccounting mode) {
+    g_accounting.store(mode);
+}
+
+SizeAccounting size_accounting() {
+    return (SizeAccounting)g_accounting.load();
+}
+
+static std::atomic<size_t> g_scan_budget(0);
+static std::mutex  g_spill_dir_mutex;
+static std::string g_spill_dir;
+
+void set_scan_memory_budget(size_t bytes, const std::string& spill_dir) {
+    std::lock_guard<std::mutex> lock(g_spill_dir_mutex);
+    g_spill_dir = spill_dir;
+    g_scan_budget.store(bytes);
+}
+
+FileSink::FileSink(ScanResult& result) : result_(result), budget_(g_scan_budget.load()) {}
+
+void FileSink::add(ScannedFile& f) {
+    if (result_.spill) {
+        result_.spill->add(f);
+        return;
+    }
+    held_ += sizeof(ScannedFile) + f.full_path.capacity();
+    result_.all_files.push_back(std::move(f));
+    if (budget_ > 0 && held_ > budget_ / 2) spill();
+}
+
+void FileSink::finish() {
+    if (result_.spill) result_.spill->finish();
+}
+
+void FileSink::spill() {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(g_spill_dir_mutex);
+        dir = g_spill_dir;
+    }
+    if (dir.empty()) {
+        char tmp[MAX_PATH];
+        DWORD n = GetTempPathA(MAX_PATH, tmp);
+        dir = (n > 0 && n < MAX_PATH) ? tmp : ".";
+    }
+
+    auto spill = std::make_shared<FileSpill>(dir, budget_ / 2);
+    if (!spill->ok()) {
+        budget_ = 0;  // no temporary space: carry on in memory
+        return;
+    }
+    for (auto& f : result_.all_files) spill->add(f);
+    std::vector<ScannedFile>().swap(result_.all_files);
+    result_.spill = spill;
+}
 
-static std::vector<DirEntry> list_dir(const std::string& dir) {
+static std::vector<DirEntry> list_dir_logical(const std::string& dir) {
     std::vector<DirEntry> entries;
     WIN32_FIND_DATAA fd;
     std::string pattern = path_join(dir, "*");
@@ -41,36 +111,217 @@ static std::vector<DirEntry> list_dir(const std::string& dir) {
         e.name = fd.cFileName;
         e.is_dir = (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
         e.size = ((ULONGLONG)fd.nFileSizeHigh << 32) | fd.nFileSizeLow;
-        e.ft_write = fd.ftLastWriteTime;
+        e.write_time = filetime_to_time_t(fd.ftLastWriteTime);
+        e.file_id = 0;
         entries.push_back(e);
     } while (FindNextFileA(h, &fd));
     FindClose(h);
     return entries;
 }
 
-static time_t filetime_to_time_t(const FILETIME& ft) {
-    ULARGE_INTEGER ull;
-    ull.LowPart = ft.dwLowDateTime;
-    ull.HighPart = ft.dwHighDateTime;
-    return (time_t)((ull.QuadPart - 116444736000000000ULL) / 10000000ULL);
+// Batched directory read: each GetFileInformationByHandleEx call returns
+// as many FILE_ID_BOTH_DIR_INFO records as fit in the buffer, carrying the
+// allocation size and file id, so no file is opened individually.
+static bool list_dir_allocated(const std::string& dir, std::vector<DirEntry>& entries) {
+    HANDLE h = CreateFileA(dir.c_str(), FILE_LIST_DIRECTORY,
+                           FILE_SHARE_READ | FILE_SHARE_WRITE | FILE_SHARE_DELETE,
+                           NULL, OPEN_EXISTING, FILE_FLAG_BACKUP_SEMANTICS, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+
+    std::vector<unsigned long long> buf(64 * 1024 / sizeof(unsigned long long));
+    FILE_INFO_BY_HANDLE_CLASS cls = FileIdBothDirectoryRestartInfo;
+    bool ok = true;
+    for (;;) {
+        if (!GetFileInformationByHandleEx(h, cls, buf.data(),
+                                          (DWORD)(buf.size() * sizeof(unsigned long long)))) {
+            ok = (GetLastError() == ERROR_NO_MORE_FILES);
+            break;
+        }
+        cls = FileIdBothDirectoryInfo;
+
+        const char* p = (const char*)buf.data();
+        for (;;) {
+            const FILE_ID_BOTH_DIR_INFO* info = (const FILE_ID_BOTH_DIR_INFO*)p;
+            int wlen = (int)(info->FileNameLength / sizeof(WCHAR));
+            char name[MAX_PATH * 2];
+            int len = WideCharToMultiByte(CP_ACP, 0, info->FileName, wlen,
+                                          name, sizeof(name) - 1, NULL, NULL);
+            name[len > 0 ? len : 0] = 0;
+
+            if (len > 0 && !(name[0] == '.' && (name[1] == 0 ||
+                (name[1] == '.' && name[2] == 0)))) {
+                FILETIME ft;
+                ft.dwLowDateTime = (DWORD)info->LastWriteTime.LowPart;
+                ft.dwHighDateTime = (DWORD)info->LastWriteTime.HighPart;
+
+                DirEntry e;
+                e.name = name;
+                e.is_dir = (info->FileAttributes & FILE_ATTRIBUTE_DIRECTORY) != 0;
+                e.size = (unsigned long long)info->AllocationSize.QuadPart;
+                e.write_time = filetime_to_time_t(ft);
+                e.file_id = (unsigned long long)info->FileId.QuadPart;
+                entries.push_back(e);
+            }
+            if (info->NextEntryOffset == 0) break;
+            p += info->NextEntryOffset;
+        }
+    }
+    CloseHandle(h);
+    return ok;
+}
+
+static std::vector<DirEntry> list_dir_any(const std::string& dir) {
+    if (size_accounting() == SIZE_ALLOCATED) {
+        std::vector<DirEntry> entries;
+        if (list_dir_allocated(dir, entries)) return entries;
+        // Volumes without file ids (FAT, some network shares): logical sizes
+    }
+    return list_dir_logical(dir);
+}
+
+std::vector<DirEntry> list_dir(const std::string& dir) {
+    IoBudget& budget = io_budget();
+    budget.acquire(IO_LIST);
+    auto start = std::chrono::steady_clock::now();
+    std::vector<DirEntry> entries = list_dir_any(dir);
+    budget.observe(IO_LIST, std::chrono::duration<double>(
+        std::chrono::steady_clock::now() - start).count());
+
+    // Every listed entry is a metadata record read from the volume
+    if (!entries.empty()) budget.acquire(IO_STAT, (double)entries.size());
+    return entries;
+}
+
+double LinkSet::charge_mb(const DirEntry& e) {
+    if (e.file_id != 0 && !seen_.insert(e.file_id).second) return 0;
+    return (double)e.size / (1024.0 * 1024.0);
+}
+
+void ScanAggregator::add(const ScannedFile& f) {
+    if (f.entity_id >= (int)fine_.size()) fine_.resize(f.entity_id + 1);
+    ScanEntry& e = fine_[f.entity_id];
+    if (e.file_count == 0) {
+        const EntityKey& k = entity_registry().key(f.entity_id);
+        e.entity_id = f.entity_id;
+        e.granularity = FIFO_GRAN_ASSET_IDX_CAT;
+        e.asset = k.asset;
+        e.index_val = k.index_val;
+        e.category = k.category;
+    }
+    e.size_mb += f.size_mb;
+    e.file_count++;
+}
+
+void ScanAggregator::remove(const ScannedFile& f) {
+    if (f.entity_id < 0 || f.entity_id >= (int)fine_.size()) return;
+    ScanEntry& e = fine_[f.entity_id];
+    if (e.file_count == 0) return;
+    e.size_mb -= f.size_mb;
+    e.file_count--;
+}
+
+std::vector<ScanEntry> ScanAggregator::entries(int granularity, const std::string& date) const {
+    EntityRegistry& reg = entity_registry();
+    std::vector<ScanEntry> rolled;
+
+    for (auto& fine : fine_) {
+        if (fine.file_count == 0) continue;
+        int id = fine.entity_id;
+        if (granularity < FIFO_GRAN_ASSET_IDX_CAT) {
+            id = reg.intern(fine.asset,
+                            (granularity >= FIFO_GRAN_ASSET_INDEX) ? fine.index_val : -1,
+                            '*');
+        }
+        if (id >= (int)rolled.size()) rolled.resize(id + 1);
+        ScanEntry& e = rolled[id];
+        if (e.file_count == 0) {
+            const EntityKey& k = reg.key(id);
+            e.entity_id = id;
+            e.granularity = granularity;
+            e.asset = k.asset;
+            e.index_val = k.index_val;
+            e.category = k.category;
+            e.date = date;
+        }
+        e.size_mb += fine.size_mb;
+        e.file_count += fine.file_count;
+    }
+
+    std::vector<ScanEntry> result;
+    for (auto& e : rolled) {
+        if (e.file_count > 0) result.push_back(e);
+    }
+    std::sort(result.begin(), result.end(), [](const ScanEntry& a, const ScanEntry& b) {
+        if (a.asset != b.asset) return a.asset < b.asset;
+        if (a.index_val != b.index_val) return a.index_val < b.index_val;
+        return a.category < b.category;
+    });
+    return result;
+}
+
+std::vector<ScanEntry> ScanAggregator::all_entries(const std::string& date) const {
+    std::vector<ScanEntry> result;
+    for (int g = FIFO_GRAN_ASSET; g <= FIFO_GRAN_ASSET_IDX_CAT; ++g) {
+        auto level = entries(g, date);
+        result.insert(result.end(), level.begin(), level.end());
+    }
+    return result;
+}
+
+std::string today_date() {
+    time_t now = time(nullptr);
+    struct tm lt;
+    localtime_s(&lt, &now);
+    char today[16];
+    snprintf(today, sizeof(today), "%04d-%02d-%02d", lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
+    return today;
+}
+
+std::string day_to_date(int day) {
+    char date[16];
+    snprintf(date, sizeof(date), "%04d-%02d-%02d", day / 10000, (day / 100) % 100, day % 100);
+    return date;
+}
+
+long date_ordinal(const std::string& date) {
+    if (date.size() < 10) return 0;
+    int y = std::atoi(date.substr(0, 4).c_str());
+    int m = std::atoi(date.substr(5, 2).c_str());
+    int d = std::atoi(date.substr(8, 2).c_str());
+    y -= m <= 2;
+    long era = (y >= 0 ? y : y - 399) / 400;
+    long yoe = y - era * 400;
+    long doy = (153 * (m + (m > 2 ? -3 : 9)) + 2) / 5 + d - 1;
+    long doe = yoe * 365 + yoe / 4 - yoe / 100 + doy;
+    return era * 146097 + doe - 719468;
+}
+
+std::string ordinal_date(long ordinal) {
+    long z = ordinal + 719468;
+    long era = (z >= 0 ? z : z - 146096) / 146097;
+    long doe = z - era * 146097;
+    long yoe = (doe - doe / 1460 + doe / 36524 - doe / 146096) / 365;
+    long doy = doe - (365 * yoe + yoe / 4 - yoe / 100);
+    long mp = (5 * doy + 2) / 153;
+    int d = (int)(doy - (153 * mp + 2) / 5 + 1);
+    int m = (int)(mp < 10 ? mp + 3 : mp - 9);
+    int y = (int)(yoe + era * 400 + (m <= 2));
+    char date[16];
+    snprintf(date, sizeof(date), "%04d-%02d-%02d", y, m, d);
+    return date;
 }
 
 ScanResult scan_directory(const std::string& root_path, int granularity) {
     ScanResult result{};
+    result.root_path = root_path;
     result.total_mb = 0;
     result.total_files = 0;
+    result.granularity = granularity;
 
-    struct AggKey {
-        std::string asset;
-        int index_val;
-        char category;
-        bool operator<(const AggKey& o) const {
-            if (asset != o.asset) return asset < o.asset;
-            if (index_val != o.index_val) return index_val < o.index_val;
-            return category < o.category;
-        }
-    };
-    std::map<AggKey, ScanEntry> agg;
+    EntityRegistry& reg = entity_registry();
+    ScanAggregator agg;
+    LinkSet links;
+    FileSink sink(result);
 
     // Level 1: ASSET folders
     for (auto& asset_e : list_dir(root_path)) {
@@ -88,6 +339,7 @@ ScanResult scan_directory(const std::string& root_path, int granularity) {
                 if (!cat_e.is_dir) continue;
                 if (cat_e.name != "E" && cat_e.name != "F") continue;
                 char cat = cat_e.name[0];
+                int entity_id = reg.intern(asset_e.name, idx_val, cat);
                 std::string cat_path = path_join(idx_path, cat_e.name);
 
                 // Level 4: Year
@@ -104,38 +356,31 @@ ScanResult scan_directory(const std::string& root_path, int granularity) {
                         for (auto& day_e : list_dir(month_path)) {
                             if (!day_e.is_dir || !is_number(day_e.name) || day_e.name.size() != 2) continue;
                             std::string day_path = path_join(month_path, day_e.name);
-                            std::string date = year_e.name + "-" + month_e.name + "-" + day_e.name;
+                            int day = std::stoi(year_e.name) * 10000 +
+                                      std::stoi(month_e.name) * 100 + std::stoi(day_e.name);
+
+                            DayIngest ingest{entity_id, day, 0, 0, day_e.write_time};
 
                             // Files in day folder
                             for (auto& file_e : list_dir(day_path)) {
                                 if (file_e.is_dir) continue;
-                                double size = (double)file_e.size / (1024.0 * 1024.0);
+                                double size = links.charge_mb(file_e);
 
                                 ScannedFile sf;
                                 sf.full_path = path_join(day_path, file_e.name);
                                 sf.size_mb = size;
-                                sf.created_time = filetime_to_time_t(file_e.ft_write);
-                                sf.asset = asset_e.name;
-                                sf.index_val = idx_val;
-                                sf.category = cat;
-                                sf.date = date;
-                                result.all_files.push_back(sf);
+                                sf.created_time = file_e.write_time;
+                                sf.entity_id = entity_id;
+                                sf.day = day;
+                                agg.add(sf);
+                                sink.add(sf);
 
                                 result.total_mb += size;
                                 result.total_files++;
-
-                                AggKey key;
-                                key.asset = asset_e.name;
-                                key.index_val = (granularity >= 1) ? idx_val : -1;
-                                key.category = (granularity >= 2) ? cat : '*';
-
-                                auto& e = agg[key];
-                                e.asset = key.asset;
-                                e.index_val = key.index_val;
-                                e.category = key.category;
-                                e.size_mb += size;
-                                e.file_count++;
+                                ingest.size_mb += size;
+                                ingest.file_count++;
                             }
+                            result.daily.push_back(ingest);
                         }
                     }
                 }
@@ -143,31 +388,102 @@ ScanResult scan_directory(const std::string& root_path, int granularity) {
         }
     }
 
-    time_t now = time(nullptr);
-    struct tm lt;
-    localtime_s(&lt, &now);
-    char today[16];
-    snprintf(today, sizeof(today), "%04d-%02d-%02d", lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
+    sink.finish();
+    result.entries = agg.all_entries(today_date());
+    return result;
+}
 
-    for (auto& kv : agg) {
-        ScanEntry e = kv.second;
-        e.date = today;
-        result.entries.push_back(e);
-    }
+// A time-series point held back until the scan's transaction commits, so
+// the store never gets ahead of SQLite
+struct PendingPoint {
+    TsKind    kind;
+    int       entity_id;
+    int       day;
+    double    size_mb;
+    long long file_count;
+};
 
-    return result;
+static int store_daily_ingest(Database& db, const ScanResult& result,
+                              std::vector<IngestDelta>& deltas,
+                              std::vector<PendingPoint>& points) {
+    // Closed day folders rarely change: only rows whose folder was touched
+    // are rewritten. A shrinking folder means eviction, not ingest: its
+    // ingest stays, and only the write time and what is left are recorded,
+    // so the estimate can trust the folder again.
+    for (auto& d : result.daily) {
+        IngestRecord rec;
+        rec.entity_id = d.entity_id;
+        rec.date = day_to_date(d.day);
+        rec.size_mb = d.size_mb;
+        rec.file_count = d.file_count;
+        rec.dir_mtime = (long long)d.dir_mtime;
+
+        double old_mb = 0;
+        IngestRecord old;
+        if (db.get_ingest_day(rec.entity_id, rec.date, old)) {
+            if (old.dir_mtime == rec.dir_mtime) continue;
+            if (rec.size_mb < old.size_mb) {
+                old.held_mb = rec.size_mb;
+                old.dir_mtime = rec.dir_mtime;
+                if (db.upsert_ingest(old) != 0) return -1;
+                continue;
+            }
+            old_mb = old.size_mb;
+        }
+        if (db.upsert_ingest(rec) != 0) return -1;
+        deltas.push_back({rec.entity_id, date_ordinal(rec.date), rec.size_mb - old_mb});
+        points.push_back({TS_INGEST, rec.entity_id, (int)date_ordinal(rec.date),
+                          rec.size_mb, rec.file_count});
+    }
+    return 0;
 }
 
 int store_scan_results(Database& db, const ScanResult& result) {
+    int ids = entity_registry().persist(db);
+    if (ids != 0) return ids;
+    forecast_state().ensure(db);
+
+    std::vector<PendingPoint> points;
+    if (db.begin() != 0) return -1;
     for (auto& e : result.entries) {
         StorageRecord rec;
+        rec.entity_id = e.entity_id;
+        rec.granularity = e.granularity;
         rec.asset = e.asset;
         rec.index_val = e.index_val;
         rec.category = e.category;
         rec.date = e.date;
         rec.size_mb = e.size_mb;
         rec.file_count = e.file_count;
-        if (db.insert_snapshot(rec) != 0) return -1;
+        if (db.insert_snapshot(rec) != 0) { db.rollback(); return -1; }
+        if (e.granularity == FIFO_GRAN_ASSET_IDX_CAT) {
+            points.push_back({TS_USAGE, e.entity_id, (int)date_ordinal(e.date),
+                              e.size_mb, e.file_count});
+        }
     }
+    std::vector<IngestDelta> deltas;
+    if (store_daily_ingest(db, result, deltas, points) != 0) { db.rollback(); return -1; }
+    bool ok = forecast_state().apply(db, deltas) == 0 &&
+              db.add_usage_sample((long long)time(nullptr), result.total_mb) == 0;
+    // Interval checks trust the manifest only once it has been refreshed today
+    if (ok) db.set_config("last_exact_scan", today_date());
+    if (!ok) db.rollback();
+    else ok = db.commit() == 0;
+    forecast_state().finish_apply(ok);
+    if (!ok) return -1;
+    for (auto& p : points)
+        ts_store().append(p.kind, p.entity_id, p.day, p.size_mb, p.file_count);
+    admission().on_scan(result.root_path, result.total_mb);
+    trace_recorder().scanned(result);
+    event_bus().scan_done(result.total_mb);
     return 0;
 }
+
+int store_scan(Database& db, ScanResult& scan) {
+    int rc = store_scan_results(db, scan);
+    if (rc == ENTITY_IDS_CHANGED) {
+        scan = scan_directory(scan.root_path, scan.granularity);
+        rc = store_scan_results(db, scan);
+    }
+    return rc == 0 ? 0 : -1;
+}
@@ -2,10 +2,16 @@
 #define SCANNER_H
 
 #include "database.h"
+#include <memory>
 #include <string>
+#include <unordered_set>
 #include <vector>
 
+class FileSpill;
+
 struct ScanEntry {
+    int         entity_id;
+    int         granularity;  // FIFO_GRAN_* level of this row
     std::string asset;
     int         index_val;
     char        category; // 'E' or 'F'
@@ -18,24 +24,130 @@ struct ScannedFile {
     std::string full_path;
     double      size_mb;
     time_t      created_time;
-    std::string asset;
-    int         index_val;
-    char        category;
-    std::string date;
+    int         entity_id;  // EntityRegistry id of ASSET\Index\E|F
+    int         day;        // day folder as YYYYMMDD
+};
+
+// Bytes and files found in one entity's day folder (finest level)
+struct DayIngest {
+    int    entity_id;
+    int    day;        // YYYYMMDD from the Year/Month/Day folder names
+    double size_mb;
+    int    file_count;
+    time_t dir_mtime;  // day folder write time, changes when files are added
 };
 
-// Scan result aggregated by granularity
+// Scan result aggregated at every granularity
 struct ScanResult {
+    std::string root_path;
     double total_mb;
     int    total_files;
-    std::vector<ScanEntry> entries;
+    int    granularity;                  // level requested by the caller
+    std::vector<ScanEntry> entries;      // rows for all three levels
+    std::vector<DayIngest> daily;        // per-entity, per-day-folder ingest
     std::vector<ScannedFile> all_files;  // needed for cleanup
+    std::shared_ptr<FileSpill> spill;    // instead of all_files past the memory budget
+};
+
+struct DirEntry {
+    std::string name;
+    bool        is_dir;
+    unsigned long long size;     // bytes charged under the current accounting mode
+    time_t      write_time;
+    unsigned long long file_id;  // NTFS file id (allocated mode only), 0 when unknown
+};
+
+// How file sizes are charged. Logical uses the end-of-file size from the
+// directory listing; allocated uses the clusters actually held, so sparse
+// and compressed files count at their on-disk size. Set from the
+// size_accounting config key ("logical" or "allocated").
+enum SizeAccounting {
+    SIZE_LOGICAL   = 0,
+    SIZE_ALLOCATED = 1
+};
+
+void set_size_accounting(SizeAccounting mode);
+SizeAccounting size_accounting();
+
+// Memory budget for a scan's file list (scan_memory_mb, 0 = unbounded).
+// A scan that outgrows it moves the list into a FileSpill under spill_dir
+// (scan_spill_dir, default the system temp directory).
+void set_scan_memory_budget(size_t bytes, const std::string& spill_dir);
+
+// Where a walk's files go: result.all_files while they fit in half the
+// budget, then a FileSpill, whose run buffer takes the other half
+class FileSink {
+public:
+    explicit FileSink(ScanResult& result);
+
+    void add(ScannedFile& f);   // takes the file's path
+    void finish();              // after the last add()
+
+private:
+    void spill();
+
+    ScanResult& result_;
+    size_t budget_;
+    size_t held_ = 0;           // estimated bytes held by all_files
+};
+
+// Directory helpers shared by the scan, pipeline and cleanup phases
+std::string path_join(const std::string& a, const std::string& b);
+std::vector<DirEntry> list_dir(const std::string& dir);
+bool is_number(const std::string& s);
+
+// Hard links of one file share its file id. Under allocated accounting a
+// walk charges each id once and further links count as 0 MB; one set is
+// owned per walk, so concurrent walks need no locking.
+class LinkSet {
+public:
+    double charge_mb(const DirEntry& e);
+
+private:
+    std::unordered_set<unsigned long long> seen_;
 };
 
+// Accumulates per-file results at the finest level (ASSET/Index/Category)
+// and rolls them up in memory, so a single walk yields rows for every
+// granularity. Adding a file is one vector lookup by entity id.
+class ScanAggregator {
+public:
+    void add(const ScannedFile& f);
+
+    // Take back a file that was add()ed, e.g. one deleted during the walk
+    void remove(const ScannedFile& f);
+
+    // Rows at one FIFO_GRAN_* level
+    std::vector<ScanEntry> entries(int granularity, const std::string& date) const;
+
+    // Rows at all three levels, coarsest first
+    std::vector<ScanEntry> all_entries(const std::string& date) const;
+
+private:
+    std::vector<ScanEntry> fine_;  // indexed by entity id
+};
+
+// Today's date as YYYY-MM-DD (local time)
+std::string today_date();
+
+// YYYYMMDD -> YYYY-MM-DD
+std::string day_to_date(int day);
+
+// Days since 1970-01-01 for a YYYY-MM-DD date, and back
+long date_ordinal(const std::string& date);
+std::string ordinal_date(long ordinal);
+
 // Scan root following ASSET\Index\E|F\Year\Month\Day schema
 ScanResult scan_directory(const std::string& root_path, int granularity);
 
-// Store scan results as today's snapshot in database
+// Store scan results (all granularities) as today's snapshot in database,
+// plus any day folders whose ingest changed since the last scan. Returns
+// ENTITY_IDS_CHANGED, with nothing stored, when another process had
+// assigned the scan's new entity ids first: rescan and store again.
 int store_scan_results(Database& db, const ScanResult& result);
 
+// store_scan_results, rescanning scan's root once if the ids changed;
+// 0 or -1
+int store_scan(Database& db, ScanResult& scan);
+
 #endif // SCANNER_H
@@ -1,12 +1,23 @@
 #include "scheduler.h"
 #include "database.h"
+#include "db_manager.h"
 #include "scanner.h"
 #include "forecast.h"
 #include "cleanup.h"
+#include "pipeline.h"
+#include "estimate.h"
+#include "lease.h"
+#include "io_budget.h"
+#include "tiering.h"
+#include "intraday.h"
+#include "events.h"
+#include "emergency.h"
 #include "fifo_api.h"
+#include <algorithm>
 #include <chrono>
 #include <ctime>
 #include <cstdio>
+#include <cstdlib>
 
 Scheduler::Scheduler() {}
 
@@ -16,6 +27,10 @@ void Scheduler::start(const SchedulerConfig& config, const std::string& db_path)
     if (running_.load()) return;
     config_ = config;
     db_path_ = db_path;
+    last_mb_ = -1;
+    last_at_ = 0;
+    next_at_.store(0);
+    rng_.seed(std::random_device()() ^ (unsigned)time(nullptr));
     running_.store(true);
     thread_ = std::thread(&Scheduler::run_loop, this);
 }
@@ -32,7 +47,10 @@ std::string Scheduler::next_run() const {
     localtime_s(&lt, &now);
 
     time_t next_t;
-    if (config_.interval_minutes > 0) {
+    if (config_.adaptive) {
+        next_t = (time_t)next_at_.load();
+        if (next_t == 0) return "";
+    } else if (config_.interval_minutes > 0) {
         next_t = now + config_.interval_minutes * 60;
     } else {
         struct tm next = lt;
@@ -52,32 +70,7 @@ std::string Scheduler::next_run() const {
     return buf;
 }
 
-int Scheduler::execute_once(const std::string& db_path, const SchedulerConfig& config) {
-    Database db;
-    if (db.open(db_path) != 0) return FIFO_ERR_DB;
-
-    // Phase 1: Scan
-    auto scan = scan_directory(config.root_path, config.granularity);
-    if (scan.total_files == 0) {
-        db.close();
-        return FIFO_ERR_NODATA;
-    }
-    store_scan_results(db, scan);
-
-    // Phase 2: Forecast
-    auto forecast = compute_forecast(db, scan.total_mb);
-    store_forecast(db, forecast);
-
-    // Phase 3: Evaluate
-    double amount = 0;
-    int action = evaluate_threshold(forecast.predicted_mb, config.limit_mb, &amount);
-
-    // Phase 4: Cleanup if needed
-    if (action == FIFO_ACTION_CLEANUP && amount > 0) {
-        execute_cleanup(db, scan.all_files, amount);
-    }
-
-    // Store last run time
+static void store_last_run(Database& db) {
     time_t now = time(nullptr);
     struct tm lt;
     localtime_s(&lt, &now);
@@ -86,15 +79,149 @@ int Scheduler::execute_once(const std::string& db_path, const SchedulerConfig& c
              lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday,
              lt.tm_hour, lt.tm_min, lt.tm_sec);
     db.set_config("last_run", ts);
+}
 
-    db.close();
+int Scheduler::execute_once(const std::string& db_path, const SchedulerConfig& config) {
+    // The manager's connection stays open between cycles
+    DbManager::Session session = db_manager().acquire(db_path);
+    if (!session) return FIFO_ERR_DB;
+    return execute_once(*session, config);
+}
+
+int Scheduler::execute_once(Database& db, const SchedulerConfig& config) {
+    // Budgets may have been changed by another process sharing the database
+    load_io_budget(db);
+    BackgroundIoScope background;
+
+    // Another engine process owns the root: skip this run rather than
+    // duplicating its scan; the next tick tries the lease again
+    int stale = std::atoi(db.get_config("lease_stale_secs", "90").c_str());
+    if (root_lease().acquire(config.root_path, stale) != 0)
+        return FIFO_ERR_LEASED;
+
+    EvictionParams eviction = load_eviction_params(db);
+    // Past the hard watermark: free space first, scan and forecast next cycle
+    EmergencyStats emergency = run_emergency(db, config.root_path, eviction);
+    if (emergency.triggered) {
+        UsageSample usage{0, 0};
+        db.get_latest_usage(usage);
+        event_bus().action(FIFO_ACTION_CLEANUP, std::max(usage.total_mb - emergency.mb_freed, 0.0));
+        store_last_run(db);
+        return FIFO_OK;
+    }
+
+    // Interval checks: once today's exact scan has refreshed the manifest, a
+    // sampled estimate is enough to tell SAFE/MONITOR/CAUTION apart. The
+    // exact cycle still runs when the estimate straddles a band or reaches
+    // cleanup, since deletions are always sized from exact totals.
+    if ((config.interval_minutes > 0 || config.adaptive) &&
+        db.get_config("interval_estimate", "1") != "0" &&
+        db.get_config("last_exact_scan", "") == today_date()) {
+        auto est = estimate_usage(db, config.root_path);
+        int action = evaluate_estimate(db, est, config.granularity, config.limit_mb,
+                                       nullptr, nullptr);
+        if (action >= 0 && action != FIFO_ACTION_CLEANUP) {
+            event_bus().action(action, est.total_mb);
+            store_last_run(db);
+            return FIFO_OK;
+        }
+    }
+
+    if (db.get_config("execute_mode", "sequential") == "pipelined") {
+        auto run = execute_pipelined(db, config.root_path, config.granularity, config.limit_mb,
+                                     config.target_pct, eviction);
+        if (run.scan.total_files == 0)
+            return FIFO_ERR_NODATA;
+        event_bus().action(run.action, run.scan.total_mb);
+    } else {
+        // Phase 1: Scan
+        auto scan = scan_directory(config.root_path, config.granularity);
+        if (scan.total_files == 0)
+            return FIFO_ERR_NODATA;
+        store_scan(db, scan);
+
+        // Phase 2: Forecast
+        auto forecast = compute_forecast(db, scan.total_mb, config.granularity);
+        store_forecast(db, forecast);
+
+        // Phase 3: Evaluate, escalating when an intraday burst crosses a band first
+        double amount = 0;
+        int action = evaluate_threshold(forecast.predicted_mb, config.limit_mb, &amount,
+                                        config.target_pct);
+        double eta_amount = 0;
+        int eta_action = evaluate_intraday(db, scan.total_mb, config.limit_mb, &eta_amount,
+                                           config.target_pct);
+        if (eta_action > action) {
+            action = eta_action;
+            amount = eta_amount;
+        }
+        event_bus().action(action, scan.total_mb);
+
+        // Phase 4: Cleanup if needed
+        if (action == FIFO_ACTION_CLEANUP && amount > 0) {
+            cleanup_scan(db, scan, amount, eviction);
+        }
+    }
+
+    // Tiered data is FIFO'd on the cold root against its own limit
+    enforce_cold_limit(db, eviction, config.target_pct);
+
+    store_last_run(db);
     return FIFO_OK;
 }
 
+long Scheduler::adaptive_wait_secs() {
+    // Usage is the last exact scan's total; interval estimates do not
+    // store one, so the rate below only moves between exact scans
+    UsageSample usage{0, -1};
+    double growth_mb = 0;
+    if (DbManager::Session db = db_manager().acquire(db_path_)) {
+        if (!db->get_latest_usage(usage)) usage.total_mb = -1;
+        growth_mb = db->get_latest_growth();
+    }
+    double current_mb = usage.total_mb;
+
+    // Growth is the faster of the forecast's daily rate and the rate seen
+    // between the last two exact scans, so an intraday spike tightens the
+    // interval before the daily model has caught up with it. A drop
+    // (cleanup) only resets the baseline.
+    time_t at = (time_t)usage.sampled_at;
+    if (last_at_ > 0 && at > last_at_ && current_mb > last_mb_) {
+        double observed = (current_mb - last_mb_) * 86400.0 / (double)(at - last_at_);
+        growth_mb = std::max(growth_mb, observed);
+    }
+    if (at > 0) {
+        last_mb_ = current_mb;
+        last_at_ = at;
+    }
+
+    double minutes;
+    double edge = next_band_mb(current_mb, config_.limit_mb);
+    if (current_mb <= 0 || edge < 0) {
+        // Nothing measured yet, or already in the cleanup band
+        minutes = config_.min_interval_minutes;
+    } else if (growth_mb <= 0) {
+        minutes = config_.max_interval_minutes;
+    } else {
+        minutes = (edge - current_mb) / growth_mb * 1440.0 * config_.safety;
+    }
+    minutes = std::min(std::max(minutes, (double)config_.min_interval_minutes),
+                        (double)config_.max_interval_minutes);
+
+    // Spread hosts that share a configuration so their scans do not align
+    double j = config_.jitter_pct / 100.0;
+    std::uniform_real_distribution<double> spread(-j, j);
+    long secs = (long)(minutes * 60.0 * (1.0 + spread(rng_)));
+    return std::max(secs, 60L);
+}
+
 void Scheduler::run_loop() {
     while (running_.load()) {
         long wait_secs;
-        if (config_.interval_minutes > 0) {
+        if (config_.adaptive) {
+            wait_secs = adaptive_wait_secs();
+            next_at_.store((long long)time(nullptr) + wait_secs);
+        } else if (config_.interval_minutes > 0) {
             wait_secs = config_.interval_minutes * 60;
         } else {
             time_t now = time(nullptr);
@@ -117,7 +244,8 @@ void Scheduler::run_loop() {
         if (!running_.load()) break;
 
         // Execute pipeline
-        execute_once(db_path_, config_);
+        if (runner_) runner_(config_);
+        else execute_once(db_path_, config_);
 
         // Record last run
         time_t now = time(nullptr);
@@ -1,10 +1,13 @@
 #ifndef SCHEDULER_H
 #define SCHEDULER_H
 
+#include "database.h"
 #include <string>
 #include <atomic>
+#include <ctime>
 #include <thread>
 #include <functional>
+#include <random>
 
 struct SchedulerConfig {
     std::string root_path;
@@ -14,31 +17,60 @@ struct SchedulerConfig {
     int hour;
     int minute;
     int interval_minutes;  // 0 = daily mode, >0 = interval mode
+
+    // Adaptive mode: the wait after each cycle is the time usage needs to
+    // reach the next threshold band at the current growth rate, times
+    // safety, clamped to [min, max] minutes and spread by +-jitter_pct
+    bool   adaptive = false;
+    int    min_interval_minutes = 5;
+    int    max_interval_minutes = 24 * 60;
+    double safety = 0.5;
+    double jitter_pct = 10;
 };
 
+// Runs one scheduled cycle; returns a FIFO_* code
+typedef std::function<int(const SchedulerConfig&)> CycleRunner;
+
 class Scheduler {
 public:
     Scheduler();
     ~Scheduler();
 
+    // Replaces execute_once for scheduled cycles, e.g. to run them on the
+    // host's warm connection and scan state. Set before start().
+    void set_runner(CycleRunner runner) { runner_ = runner; }
+
     void start(const SchedulerConfig& config, const std::string& db_path);
     void stop();
     bool is_running() const { return running_.load(); }
 
-    // Execute one full cycle immediately
+    // Execute one full cycle immediately. It uses the process-wide lease,
+    // admission and forecast state without a lock of its own: the caller
+    // keeps it from overlapping any other cycle (the API runs it under its
+    // lock)
     static int execute_once(const std::string& db_path, const SchedulerConfig& config);
+    // The same on a connection the caller already holds
+    static int execute_once(Database& db, const SchedulerConfig& config);
 
     std::string last_run() const { return last_run_; }
     std::string next_run() const;
 
 private:
     void run_loop();
+    long adaptive_wait_secs();
 
     std::atomic<bool> running_{false};
     std::thread thread_;
     SchedulerConfig config_;
     std::string db_path_;
     std::string last_run_;
+    CycleRunner runner_;
+
+    // Adaptive mode state, touched only by the scheduler thread except next_at_
+    std::atomic<long long> next_at_{0};
+    double last_mb_ = -1;
+    time_t last_at_ = 0;
+    std::mt19937 rng_;
 };
 
 #endif // SCHEDULER_H
@@ -0,0 +1,76 @@
+#include "snapshot.h"
+#include <cstring>
+
+long long StringTable::add(const std::string& s) {
+    long long off = (long long)bytes_.size();
+    bytes_.insert(bytes_.end(), s.begin(), s.end());
+    bytes_.push_back(0);
+    return off;
+}
+
+long long StringTable::intern(const std::string& s) {
+    auto it = interned_.find(s);
+    if (it != interned_.end()) return it->second;
+    long long off = add(s);
+    interned_[s] = off;
+    return off;
+}
+
+std::shared_ptr<const ScanSnapshot> build_scan_snapshot(const ScanResult& scan, long long id) {
+    std::shared_ptr<ScanSnapshot> snap = std::make_shared<ScanSnapshot>();
+    snap->id = id;
+
+    // Counting pass so each level lands in one contiguous range
+    size_t per_level[3] = {0, 0, 0};
+    for (auto& e : scan.entries) {
+        if (e.granularity >= 0 && e.granularity < 3) per_level[e.granularity]++;
+    }
+    snap->level_begin[0] = 0;
+    for (int g = 0; g < 3; ++g) snap->level_begin[g + 1] = snap->level_begin[g] + per_level[g];
+
+    snap->entries.resize(snap->level_begin[3]);
+    size_t next[3] = {snap->level_begin[0], snap->level_begin[1], snap->level_begin[2]};
+    for (auto& e : scan.entries) {
+        if (e.granularity < 0 || e.granularity >= 3) continue;
+        ScanEntryRow& r = snap->entries[next[e.granularity]++];
+        std::memset(&r, 0, sizeof(r));
+        r.asset_off = snap->strings.intern(e.asset);
+        r.date_off = snap->strings.intern(e.date);
+        r.entity_id = e.entity_id;
+        r.granularity = e.granularity;
+        r.index_val = e.index_val;
+        r.category = e.category;
+        r.size_mb = e.size_mb;
+        r.file_count = e.file_count;
+    }
+
+    snap->files.resize(scan.all_files.size());
+    for (size_t i = 0; i < scan.all_files.size(); ++i) {
+        const ScannedFile& f = scan.all_files[i];
+        ScanFileRow& r = snap->files[i];
+        std::memset(&r, 0, sizeof(r));
+        r.path_off = snap->strings.add(f.full_path);
+        r.created_time = (long long)f.created_time;
+        r.size_mb = f.size_mb;
+        r.entity_id = f.entity_id;
+        r.day = f.day;
+    }
+    return snap;
+}
+
+std::shared_ptr<const WeightSnapshot> build_weight_snapshot(const std::vector<WeightRecord>& weights) {
+    std::shared_ptr<WeightSnapshot> snap = std::make_shared<WeightSnapshot>();
+    snap->rows.resize(weights.size());
+    for (size_t i = 0; i < weights.size(); ++i) {
+        const WeightRecord& w = weights[i];
+        WeightRow& r = snap->rows[i];
+        std::memset(&r, 0, sizeof(r));
+        r.asset_off = snap->strings.intern(w.asset);
+        r.index_val = w.index_val;
+        r.category = w.category;
+        r.avg_mb = w.avg_mb;
+        r.total_mb = w.total_mb;
+        r.day_count = w.day_count;
+    }
+    return snap;
+}
@@ -0,0 +1,49 @@
+#ifndef SNAPSHOT_H
+#define SNAPSHOT_H
+
+#include "fifo_api.h"
+#include "scanner.h"
+#include <memory>
+#include <string>
+#include <unordered_map>
+#include <vector>
+
+// NUL-terminated strings packed back to back; rows refer to them by offset
+class StringTable {
+public:
+    long long add(const std::string& s);
+    // Same offset for repeated values (asset names, dates)
+    long long intern(const std::string& s);
+
+    const char* data() const { return bytes_.data(); }
+    long long   size() const { return (long long)bytes_.size(); }
+
+private:
+    std::vector<char> bytes_;
+    std::unordered_map<std::string, long long> interned_;
+};
+
+// Immutable flat copy of one scan, laid out for fifo_view_open: entries
+// grouped by granularity so each level is one contiguous range, files in
+// scan order. Built once per scan on first use and shared by every view
+// over it; a newer scan never modifies it, so a view stays valid until
+// it is released even if the engine has rescanned meanwhile.
+struct ScanSnapshot {
+    long long id;
+    std::vector<ScanEntryRow> entries;
+    size_t level_begin[4];   // entries of level g: [level_begin[g], level_begin[g+1])
+    std::vector<ScanFileRow> files;
+    StringTable strings;
+};
+
+std::shared_ptr<const ScanSnapshot> build_scan_snapshot(const ScanResult& scan, long long id);
+
+// Weights are read from history per request, so a weights view owns its rows
+struct WeightSnapshot {
+    std::vector<WeightRow> rows;
+    StringTable strings;
+};
+
+std::shared_ptr<const WeightSnapshot> build_weight_snapshot(const std::vector<WeightRecord>& weights);
+
+#endif // SNAPSHOT_H
@@ -0,0 +1,198 @@
+#include "spill.h"
+#include <algorithm>
+#include <cstring>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+// Per-run read buffer bounds during the merge, in records
+static const size_t MIN_RUN_BUFFER = 64;
+static const size_t MAX_RUN_BUFFER = 65536;
+
+// Buffered path writes, so a path costs a memcpy rather than a write call
+static const size_t PATH_WRITE_BUFFER = 1 << 20;
+
+// Runs open at once in any merge, well under the CRT's 512 FILE streams
+static const size_t MERGE_FAN_IN = 64;
+
+FileSpill::FileSpill(const std::string& dir, size_t budget_bytes)
+    : dir_(dir), budget_bytes_(budget_bytes) {
+    run_capacity_ = std::max<size_t>(budget_bytes / sizeof(SpillRecord), MIN_RUN_BUFFER);
+    buffer_.reserve(run_capacity_);
+    ok_ = temp_file(paths_path_) && (paths_ = fopen(paths_path_.c_str(), "wb")) != nullptr;
+    if (paths_) setvbuf(paths_, nullptr, _IOFBF, PATH_WRITE_BUFFER);
+}
+
+FileSpill::~FileSpill() {
+    if (paths_) fclose(paths_);
+    if (!paths_path_.empty()) DeleteFileA(paths_path_.c_str());
+    for (auto& p : run_paths_) DeleteFileA(p.c_str());
+}
+
+bool FileSpill::temp_file(std::string& out) {
+    char path[MAX_PATH];
+    if (!GetTempFileNameA(dir_.c_str(), "fsp", 0, path)) return false;
+    out = path;
+    return true;
+}
+
+void FileSpill::add(const ScannedFile& f) {
+    if (!ok_) return;
+    if (f.entity_id >= (int)entity_counts_.size()) entity_counts_.resize(f.entity_id + 1, 0);
+    entity_counts_[f.entity_id]++;
+    files_++;
+
+    unsigned short len = (unsigned short)std::min<size_t>(f.full_path.size(), 0xFFFF);
+    if (fwrite(&len, sizeof(len), 1, paths_) != 1 ||
+        fwrite(f.full_path.data(), 1, len, paths_) != len) {
+        ok_ = false;
+        return;
+    }
+
+    SpillRecord r;
+    r.created_time = (long long)f.created_time;
+    r.size_mb = f.size_mb;
+    r.path_off = paths_off_;
+    r.entity_id = f.entity_id;
+    r.day = f.day;
+    buffer_.push_back(r);
+    paths_off_ += sizeof(len) + len;
+
+    if (buffer_.size() >= run_capacity_) write_run();
+}
+
+void FileSpill::write_run() {
+    if (buffer_.empty() || !ok_) return;
+    std::sort(buffer_.begin(), buffer_.end(), [](const SpillRecord& a, const SpillRecord& b) {
+        if (a.created_time != b.created_time) return a.created_time < b.created_time;
+        return a.path_off < b.path_off;
+    });
+
+    std::string path;
+    FILE* f = temp_file(path) ? fopen(path.c_str(), "wb") : nullptr;
+    if (!f) {
+        ok_ = false;
+        return;
+    }
+    run_paths_.push_back(path);
+    bool written = fwrite(buffer_.data(), sizeof(SpillRecord), buffer_.size(), f) == buffer_.size();
+    if (fclose(f) != 0 || !written) ok_ = false;
+    buffer_.clear();
+}
+
+void FileSpill::finish() {
+    write_run();
+    if (paths_ && fclose(paths_) != 0) ok_ = false;
+    paths_ = nullptr;
+    // The merge brings its own buffers
+    std::vector<SpillRecord>().swap(buffer_);
+
+    // Oldest runs first, so each pass merges runs of similar length
+    while (ok_ && run_paths_.size() > MERGE_FAN_IN) merge_runs(MERGE_FAN_IN);
+}
+
+void FileSpill::merge_runs(size_t count) {
+    std::unique_ptr<Reader> in = open_runs(count);
+    std::string path;
+    FILE* out = in && temp_file(path) ? fopen(path.c_str(), "wb") : nullptr;
+    if (!out) {
+        if (!path.empty()) DeleteFileA(path.c_str());
+        ok_ = false;
+        return;
+    }
+    setvbuf(out, nullptr, _IOFBF, PATH_WRITE_BUFFER);
+
+    SpillRecord r;
+    bool written = true;
+    while (written && in->next_record(r)) written = fwrite(&r, sizeof(r), 1, out) == 1;
+    in.reset();
+    if (fclose(out) != 0 || !written) {
+        DeleteFileA(path.c_str());
+        ok_ = false;
+        return;
+    }
+
+    for (size_t i = 0; i < count; ++i) DeleteFileA(run_paths_[i].c_str());
+    run_paths_.erase(run_paths_.begin(), run_paths_.begin() + count);
+    run_paths_.push_back(path);
+}
+
+std::unique_ptr<FileSpill::Reader> FileSpill::open_runs(size_t count) const {
+    std::unique_ptr<Reader> reader(new Reader());
+
+    // The read buffers share the budget
+    size_t per_run = count == 0 ? MIN_RUN_BUFFER : budget_bytes_ / sizeof(SpillRecord) / count;
+    per_run = std::min(std::max(per_run, MIN_RUN_BUFFER), MAX_RUN_BUFFER);
+
+    reader->runs_.resize(count);
+    for (size_t i = 0; i < count; ++i) {
+        Reader::Run& run = reader->runs_[i];
+        run.file = fopen(run_paths_[i].c_str(), "rb");
+        if (!run.file) return nullptr;
+        run.buf.resize(per_run);
+        if (run.refill()) reader->push(i);
+    }
+    return reader;
+}
+
+std::unique_ptr<FileSpill::Reader> FileSpill::open() const {
+    if (!ok_ || paths_) return nullptr;
+    std::unique_ptr<Reader> reader = open_runs(run_paths_.size());
+    if (!reader) return nullptr;
+    reader->paths_ = fopen(paths_path_.c_str(), "rb");
+    if (!reader->paths_) return nullptr;
+    return reader;
+}
+
+FileSpill::Reader::~Reader() {
+    for (auto& run : runs_) {
+        if (run.file) fclose(run.file);
+    }
+    if (paths_) fclose(paths_);
+}
+
+bool FileSpill::Reader::Run::refill() {
+    len = fread(buf.data(), sizeof(SpillRecord), buf.size(), file);
+    pos = 0;
+    return len > 0;
+}
+
+void FileSpill::Reader::push(size_t run) {
+    const SpillRecord& r = runs_[run].buf[runs_[run].pos];
+    heap_.push(HeapItem{r.created_time, r.path_off, run});
+}
+
+bool FileSpill::Reader::read_path(unsigned long long off, std::string& out) {
+    unsigned short len = 0;
+    if (_fseeki64(paths_, (long long)off, SEEK_SET) != 0 ||
+        fread(&len, sizeof(len), 1, paths_) != 1)
+        return false;
+    out.resize(len);
+    return len == 0 || fread(&out[0], 1, len, paths_) == len;
+}
+
+bool FileSpill::Reader::next_record(SpillRecord& out) {
+    if (heap_.empty()) return false;
+    size_t run = heap_.top().run;
+    heap_.pop();
+
+    Run& r = runs_[run];
+    out = r.buf[r.pos++];
+    if (r.pos < r.len || r.refill()) push(run);
+    return true;
+}
+
+bool FileSpill::Reader::next(ScannedFile& out) {
+    SpillRecord rec;
+    while (next_record(rec)) {
+        if (!read_path(rec.path_off, out.full_path)) continue;
+        out.size_mb = rec.size_mb;
+        out.created_time = (time_t)rec.created_time;
+        out.entity_id = rec.entity_id;
+        out.day = rec.day;
+        return true;
+    }
+    return false;
+}
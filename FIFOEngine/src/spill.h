@@ -0,0 +1,112 @@
+#ifndef SPILL_H
+#define SPILL_H
+
+#include "scanner.h"
+#include <cstdio>
+#include <memory>
+#include <queue>
+#include <string>
+#include <vector>
+
+// One file in a spilled run. The path lives in the spill's path file,
+// written in scan order, as a 2-byte length and the bytes.
+struct SpillRecord {
+    long long          created_time;
+    double             size_mb;
+    unsigned long long path_off;
+    int                entity_id;
+    int                day;
+};
+
+// Memory-bounded file list for scans of trees that do not fit in RAM.
+// Records are buffered up to the budget, sorted by created_time and
+// written out as a run; paths go straight to one append-only file. The
+// runs are read back through a k-way merge in time order, so cleanup sees
+// the same oldest-first sequence a full in-memory sort would give, with
+// peak memory fixed by the budget instead of the tree size. More runs than
+// MERGE_FAN_IN are first merged in passes, so the final merge never holds
+// more files open than that. Temporary files are removed with the spill.
+class FileSpill {
+public:
+    class Reader {
+    public:
+        ~Reader();
+
+        // Next file, oldest created_time first
+        bool next(ScannedFile& out);
+
+    private:
+        friend class FileSpill;
+
+        struct Run {
+            FILE*  file = nullptr;
+            std::vector<SpillRecord> buf;
+            size_t pos = 0;
+            size_t len = 0;
+            bool refill();
+        };
+
+        struct HeapItem {
+            long long created_time;
+            unsigned long long path_off;
+            size_t run;
+            bool operator>(const HeapItem& o) const {
+                if (created_time != o.created_time) return created_time > o.created_time;
+                return path_off > o.path_off;
+            }
+        };
+
+        void push(size_t run);
+        bool next_record(SpillRecord& out);
+        bool read_path(unsigned long long off, std::string& out);
+
+        std::vector<Run> runs_;
+        std::priority_queue<HeapItem, std::vector<HeapItem>, std::greater<HeapItem>> heap_;
+        FILE* paths_ = nullptr;
+    };
+
+    // dir: where the temporary files go; budget_bytes bounds the buffered
+    // records and, later, the merge's read buffers
+    FileSpill(const std::string& dir, size_t budget_bytes);
+    ~FileSpill();
+
+    // False once a temporary file could not be created or written; a
+    // failed spill must not drive deletions
+    bool ok() const { return ok_; }
+
+    void add(const ScannedFile& f);
+
+    // Write the last run and cascade the runs down to MERGE_FAN_IN; call
+    // once, after the last add()
+    void finish();
+
+    size_t files() const { return files_; }
+    size_t runs() const { return run_paths_.size(); }
+
+    // Files seen per entity id, for the per-entity minimum
+    const std::vector<int>& entity_counts() const { return entity_counts_; }
+
+    // Merge over every run; nullptr when the spill is not ok()
+    std::unique_ptr<Reader> open() const;
+
+private:
+    bool temp_file(std::string& out);
+    void write_run();
+    void merge_runs(size_t count);
+    std::unique_ptr<Reader> open_runs(size_t count) const;
+
+    std::string dir_;
+    size_t      budget_bytes_;
+    size_t      run_capacity_;
+    bool        ok_ = true;
+    size_t      files_ = 0;
+    std::vector<int> entity_counts_;
+
+    std::vector<SpillRecord> buffer_;
+    std::string paths_path_;
+    FILE*       paths_ = nullptr;
+    unsigned long long paths_off_ = 0;
+    std::vector<std::string> run_paths_;
+};
+
+#endif // SPILL_H
@@ -0,0 +1,151 @@
+#include "tiering.h"
+#include "io_budget.h"
+#include "oldest_first.h"
+#include "fifo_api.h"
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <vector>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+static void create_dirs_recursive(const std::string& path) {
+    // Create all directories in path
+    for (size_t i = 0; i < path.size(); ++i) {
+        if (path[i] == '\\' || path[i] == '/') {
+            std::string sub = path.substr(0, i);
+            if (!sub.empty()) CreateDirectoryA(sub.c_str(), NULL);
+        }
+    }
+    CreateDirectoryA(path.c_str(), NULL);
+}
+
+static std::string parent_dir(const std::string& path) {
+    size_t pos = path.find_last_of("\\/");
+    return pos == std::string::npos ? std::string() : path.substr(0, pos);
+}
+
+static bool same_contents(const std::string& a, const std::string& b) {
+    FILE* fa = fopen(a.c_str(), "rb");
+    FILE* fb = fopen(b.c_str(), "rb");
+    bool same = fa && fb;
+    std::vector<char> ba(1 << 20), bb(1 << 20);
+    while (same) {
+        size_t na = fread(ba.data(), 1, ba.size(), fa);
+        size_t nb = fread(bb.data(), 1, bb.size(), fb);
+        if (na != nb || std::memcmp(ba.data(), bb.data(), na) != 0) same = false;
+        if (na < ba.size()) break;
+    }
+    if (fa) fclose(fa);
+    if (fb) fclose(fb);
+    return same;
+}
+
+static bool path_exists(const std::string& path) {
+    return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+std::string free_cold_path(const std::string& dst) {
+    if (!path_exists(dst)) return dst;
+    size_t slash = dst.find_last_of("\\/");
+    size_t dot = dst.find_last_of('.');
+    if (dot == std::string::npos || (slash != std::string::npos && dot < slash)) dot = dst.size();
+    for (int n = 1; n < 1000; ++n) {
+        std::string candidate = dst.substr(0, dot) + " (" + std::to_string(n) + ")" + dst.substr(dot);
+        if (!path_exists(candidate)) return candidate;
+    }
+    return std::string();
+}
+
+std::string cold_path_for(const std::string& root_path, const std::string& cold_root,
+                          const std::string& full_path) {
+    std::string rel = full_path.compare(0, root_path.size(), root_path) == 0
+                          ? full_path.substr(root_path.size())
+                          : full_path;
+    size_t start = rel.find_first_not_of("\\/");
+    return path_join(cold_root, start == std::string::npos ? rel : rel.substr(start));
+}
+
+TierMethod tier_file(const std::string& src, const std::string& dst, bool verify_content) {
+    io_budget().acquire(IO_UNLINK);
+    create_dirs_recursive(parent_dir(dst));
+
+    // Neither call replaces a file that is already there
+    const std::string& target = dst;
+    if (MoveFileExA(src.c_str(), target.c_str(), 0)) return TIER_RENAME;
+    if (GetLastError() != ERROR_NOT_SAME_DEVICE) return TIER_FAILED;
+
+    WIN32_FILE_ATTRIBUTE_DATA before;
+    if (!GetFileAttributesExA(src.c_str(), GetFileExInfoStandard, &before)) return TIER_FAILED;
+    if (!CopyFileExA(src.c_str(), target.c_str(), NULL, NULL, NULL, COPY_FILE_FAIL_IF_EXISTS)) {
+        if (GetLastError() != ERROR_FILE_EXISTS) DeleteFileA(target.c_str());
+        return TIER_FAILED;
+    }
+
+    // CopyFileEx stamps a fresh creation time; keep the original
+    HANDLE h = CreateFileA(target.c_str(), FILE_WRITE_ATTRIBUTES, FILE_SHARE_READ, NULL,
+                           OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h != INVALID_HANDLE_VALUE) {
+        SetFileTime(h, &before.ftCreationTime, NULL, &before.ftLastWriteTime);
+        CloseHandle(h);
+    }
+
+    WIN32_FILE_ATTRIBUTE_DATA after;
+    bool ok = GetFileAttributesExA(target.c_str(), GetFileExInfoStandard, &after) &&
+              after.nFileSizeHigh == before.nFileSizeHigh &&
+              after.nFileSizeLow == before.nFileSizeLow;
+    if (ok && verify_content) ok = same_contents(src, target);
+
+    // A source that is still being written or is locked stays where it is
+    if (!ok || !DeleteFileA(src.c_str())) {
+        DeleteFileA(target.c_str());
+        return TIER_FAILED;
+    }
+    return TIER_COPY;
+}
+
+CleanupStats enforce_cold_limit(Database& db, const EvictionParams& params, double target_pct) {
+    CleanupStats stats{};
+    if (params.cold_root.empty() || params.cold_limit_mb <= 0) return stats;
+
+    long long tier_id = std::atoll(db.get_config("cold_usage_tier_id", "0").c_str());
+    long long del_id = std::atoll(db.get_config("cold_usage_del_id", "0").c_str());
+    double usage_mb = 0;
+    if (db.get_config("cold_usage_root", "") != params.cold_root ||
+        db.get_config("cold_usage_date", "") != today_date()) {
+        // Daily, and whenever the cold root changes: catches what was added
+        // or removed there outside the engine
+        db.get_cold_change(params.cold_root, &tier_id, &del_id);
+        usage_mb = scan_directory(params.cold_root, FIFO_GRAN_ASSET_IDX_CAT).total_mb;
+        db.set_config("cold_usage_root", params.cold_root);
+        db.set_config("cold_usage_date", today_date());
+    } else {
+        usage_mb = std::atof(db.get_config("cold_usage_mb", "0").c_str()) +
+                   db.get_cold_change(params.cold_root, &tier_id, &del_id);
+    }
+
+    double amount = 0;
+    if (evaluate_threshold(usage_mb, params.cold_limit_mb, &amount, target_pct) ==
+        FIFO_ACTION_CLEANUP) {
+        // The cold tier is the last stop: evict by deleting
+        EvictionParams last = params;
+        last.cold_root.clear();
+        OldestFirstIterator oldest(params.cold_root);
+        stats = execute_cleanup(db, oldest, amount, last);
+        // The deletions are in deletion_log now
+        usage_mb += db.get_cold_change(params.cold_root, &tier_id, &del_id);
+    }
+
+    if (usage_mb < 0) usage_mb = 0;
+    stats.new_usage_mb = usage_mb;
+    db.set_config("cold_usage_mb", std::to_string(usage_mb));
+    db.set_config("cold_usage_tier_id", std::to_string(tier_id));
+    db.set_config("cold_usage_del_id", std::to_string(del_id));
+    return stats;
+}
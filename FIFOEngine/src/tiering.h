@@ -0,0 +1,40 @@
+#ifndef TIERING_H
+#define TIERING_H
+
+#include "database.h"
+#include "cleanup.h"
+#include "eviction.h"
+#include <string>
+
+enum TierMethod {
+    TIER_FAILED = 0,
+    TIER_RENAME = 1,   // same volume: metadata-only move
+    TIER_COPY   = 2    // other volume: copied, verified, source unlinked
+};
+
+// Where a file under root_path lands under cold_root: the same
+// ASSET\Index\E|F\Year\Month\Day relative path
+std::string cold_path_for(const std::string& root_path, const std::string& cold_root,
+                          const std::string& full_path);
+
+// Move one file to dst, creating its folders. A rename is tried first;
+// across volumes the file is copied, its creation time carried over (the
+// cold tier is FIFO'd by it), the copy verified by size or, with
+// verify_content, byte for byte, and only then is the source unlinked.
+// On failure the source is left in place and any partial copy removed.
+// A file already at dst is never replaced: the move fails instead.
+TierMethod tier_file(const std::string& src, const std::string& dst, bool verify_content);
+
+// dst, or the first free "name (n).ext" beside it when dst is taken; empty
+// if none is. The journal stores the result with the intent before moving.
+std::string free_cold_path(const std::string& dst);
+
+// FIFO the cold tier in turn: when it is over params.cold_limit_mb, delete
+// from it oldest first (see OldestFirstIterator) under the same limits
+// until target_pct of the limit holds. The tier's usage is measured by a
+// scan once a day and kept current in between from tiering_log and
+// deletion_log, so a cycle does not walk the cold root.
+CleanupStats enforce_cold_limit(Database& db, const EvictionParams& params,
+                                double target_pct = DEFAULT_TARGET_PCT);
+
+#endif // TIERING_H
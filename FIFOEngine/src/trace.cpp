@@ -0,0 +1,151 @@
+#include "trace.h"
+#include "entity_registry.h"
+#include <chrono>
+#include <cstring>
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+TraceRecorder::TraceRecorder() {}
+
+TraceRecorder::~TraceRecorder() { stop(); }
+
+int TraceRecorder::start(const std::string& path) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (file_) fclose(file_);
+    file_ = fopen(path.c_str(), "wb");
+    if (!file_) {
+        active_ = false;
+        return -1;
+    }
+    fwrite(TRACE_MAGIC, 1, sizeof(TRACE_MAGIC), file_);
+    baseline_ = true;
+    defined_.clear();
+    seen_.clear();
+    active_ = true;
+    return 0;
+}
+
+void TraceRecorder::stop() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    active_ = false;
+    if (file_) fclose(file_);
+    file_ = nullptr;
+}
+
+void TraceRecorder::define_entity(int id) {
+    if (id < 0) return;
+    if ((size_t)id >= defined_.size()) defined_.resize(id + 1, false);
+    if (defined_[id]) return;
+    defined_[id] = true;
+
+    const EntityKey& key = entity_registry().key(id);
+    TraceRecord r;
+    std::memset(&r, 0, sizeof(r));
+    r.kind = TRACE_ENTITY;
+    r.category = key.category;
+    r.index_val = (int16_t)key.index_val;
+    r.entity = id;
+    r.at_ms = now_ms();
+    r.day = (int32_t)key.asset.size();
+    write(r);
+    fwrite(key.asset.data(), 1, key.asset.size(), file_);
+}
+
+void TraceRecorder::write(const TraceRecord& r) {
+    fwrite(&r, sizeof(r), 1, file_);
+}
+
+void TraceRecorder::scanned(const ScanResult& scan) {
+    if (!active_.load()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+
+    // Only growth is ingest; a folder that shrank without a logged removal
+    // was cleaned up by something else and is just re-based
+    int64_t at = now_ms();
+    for (auto& d : scan.daily) {
+        DayCount& prev = seen_[DayKey(d.entity_id, d.day)];
+        int files = d.file_count - prev.files;
+        double mb = d.size_mb - prev.mb;
+        prev.files = d.file_count;
+        prev.mb = d.size_mb;
+        if (files <= 0 && mb <= 0) continue;
+
+        define_entity(d.entity_id);
+        TraceRecord r;
+        std::memset(&r, 0, sizeof(r));
+        r.kind = baseline_ ? TRACE_BASELINE : TRACE_CREATE;
+        r.entity = d.entity_id;
+        r.at_ms = at;
+        r.day = d.day;
+        r.count = files > 0 ? files : 0;
+        r.mb = mb > 0 ? mb : 0;
+        write(r);
+    }
+    baseline_ = false;
+    fflush(file_);
+}
+
+void TraceRecorder::removed(const ScannedFile& f) {
+    if (!active_.load()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+
+    // Keeps the next scan's comparison net of this removal
+    auto it = seen_.find(DayKey(f.entity_id, f.day));
+    if (it != seen_.end()) {
+        it->second.files--;
+        it->second.mb -= f.size_mb;
+    }
+
+    define_entity(f.entity_id);
+    TraceRecord r;
+    std::memset(&r, 0, sizeof(r));
+    r.kind = TRACE_DELETE;
+    r.entity = f.entity_id;
+    r.at_ms = now_ms();
+    r.day = f.day;
+    r.count = 1;
+    r.mb = f.size_mb;
+    write(r);
+}
+
+void TraceRecorder::cleanup_finished(int files, double mb, double ms) {
+    if (!active_.load()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+    TraceRecord r;
+    std::memset(&r, 0, sizeof(r));
+    r.kind = TRACE_CLEANUP;
+    r.at_ms = now_ms();
+    r.count = files;
+    r.mb = mb;
+    r.ms = ms;
+    write(r);
+    fflush(file_);
+}
+
+void TraceRecorder::run_finished(int rc, int action, int files, double mb, double ms) {
+    if (!active_.load()) return;
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (!file_) return;
+    TraceRecord r;
+    std::memset(&r, 0, sizeof(r));
+    r.kind = TRACE_RUN;
+    r.entity = rc;
+    r.at_ms = now_ms();
+    r.day = action;
+    r.count = files;
+    r.mb = mb;
+    r.ms = ms;
+    write(r);
+    fflush(file_);
+}
+
+TraceRecorder& trace_recorder() {
+    static TraceRecorder instance;
+    return instance;
+}
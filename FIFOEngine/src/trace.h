@@ -0,0 +1,59 @@
+#ifndef TRACE_H
+#define TRACE_H
+
+#include "scanner.h"
+#include "trace_format.h"
+#include <atomic>
+#include <cstdio>
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Records the workload the engine sees as a compact binary timeline (see
+// trace_format.h) for fiforeplay. The engine does not see individual
+// writes, so ingest is recorded per day folder: each scan compares the
+// files and MB of every (entity, day) with the previous scan, net of what
+// cleanups removed in between, and logs what appeared. The first scan
+// after start() logs the existing tree as the baseline. Cleanups log every
+// removed file and the batch duration, and every cycle logs its duration.
+// Recording is off until start(); the hooks return on one atomic load.
+class TraceRecorder {
+public:
+    TraceRecorder();
+    ~TraceRecorder();
+
+    // Start a new trace at path (truncated); 0 on success
+    int  start(const std::string& path);
+    void stop();
+    bool active() const { return active_.load(); }
+
+    void scanned(const ScanResult& scan);
+    void removed(const ScannedFile& f);
+    void cleanup_finished(int files, double mb, double ms);
+    void run_finished(int rc, int action, int files, double mb, double ms);
+
+private:
+    typedef std::pair<int, int> DayKey;   // entity, YYYYMMDD
+
+    struct DayCount {
+        int    files;
+        double mb;
+    };
+
+    void define_entity(int id);       // with mutex_ held
+    void write(const TraceRecord& r); // with mutex_ held
+
+    std::atomic<bool> active_{false};
+    std::mutex  mutex_;
+    FILE*       file_ = nullptr;
+    bool        baseline_ = true;     // next scan is the first one
+    std::vector<bool> defined_;       // entity records already written
+    std::map<DayKey, DayCount> seen_; // per day folder, as of the last scan
+};
+
+// Process-wide recorder; trace_path in the configuration starts it at fifo_init
+TraceRecorder& trace_recorder();
+
+#endif // TRACE_H
@@ -0,0 +1,36 @@
+#ifndef TRACE_FORMAT_H
+#define TRACE_FORMAT_H
+
+#include <cstdint>
+
+// On-disk layout of a workload trace, shared by the recorder and the
+// replay tool. A trace is TRACE_MAGIC followed by fixed 40-byte records in
+// time order; a TRACE_ENTITY record is followed by its asset name.
+static const char TRACE_MAGIC[8] = {'F', 'I', 'F', 'O', 'T', 'R', 'C', '1'};
+
+enum TraceKind {
+    TRACE_ENTITY   = 1,   // entity id -> asset, index_val, category
+    TRACE_BASELINE = 2,   // files in a day folder when recording started
+    TRACE_CREATE   = 3,   // files that appeared in a day folder since the last scan
+    TRACE_DELETE   = 4,   // one file removed by a cleanup
+    TRACE_CLEANUP  = 5,   // a cleanup batch finished
+    TRACE_RUN      = 6    // an engine cycle finished
+};
+
+#pragma pack(push, 1)
+struct TraceRecord {
+    uint8_t kind;         // TRACE_*
+    char    category;     // entity: 'E' or 'F'
+    int16_t index_val;    // entity
+    int32_t entity;       // entity id; run: return code
+    int64_t at_ms;        // unix time in milliseconds
+    int32_t day;          // YYYYMMDD; entity: asset name length; run: action
+    int32_t count;        // files
+    double  mb;
+    double  ms;           // cleanup and run: duration
+};
+#pragma pack(pop)
+
+static_assert(sizeof(TraceRecord) == 40, "trace records are 40 bytes on disk");
+
+#endif // TRACE_FORMAT_H
@@ -0,0 +1,413 @@
+#include "tsstore.h"
+#include "entity_registry.h"
+#include "scanner.h"
+#include "fifo_api.h"
+#include <algorithm>
+#include <cmath>
+#include <cstring>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#ifndef NOMINMAX
+#define NOMINMAX
+#endif
+#include <windows.h>
+
+namespace {
+
+const unsigned int kBlockMagic = 0x42535446;  // "FTSB"
+const size_t       kBlockPoints = 128;
+
+// On-disk block header, little endian; payload of deltas follows
+struct BlockHeader {
+    unsigned int magic;
+    unsigned int count;
+    int          first_day;
+    int          last_day;
+    long long    first_kb;
+    long long    first_files;
+    unsigned int payload;
+    unsigned int reserved;
+};
+
+struct RawPoint {
+    int       day;
+    long long kb;
+    long long files;
+};
+
+RawPoint to_raw(const TsPoint& p) {
+    RawPoint r;
+    r.day = p.day;
+    r.kb = (long long)std::llround(p.size_mb * 1024.0);
+    r.files = p.file_count;
+    return r;
+}
+
+TsPoint from_raw(const RawPoint& r) {
+    TsPoint p;
+    p.day = r.day;
+    p.size_mb = (double)r.kb / 1024.0;
+    p.file_count = r.files;
+    return p;
+}
+
+void put_varint(std::vector<unsigned char>& out, unsigned long long v) {
+    while (v >= 0x80) {
+        out.push_back((unsigned char)(v | 0x80));
+        v >>= 7;
+    }
+    out.push_back((unsigned char)v);
+}
+
+unsigned long long zigzag(long long v) {
+    return ((unsigned long long)v << 1) ^ (unsigned long long)(v >> 63);
+}
+
+long long unzigzag(unsigned long long v) {
+    return (long long)(v >> 1) ^ -(long long)(v & 1);
+}
+
+// Returns false on a truncated varint
+bool get_varint(const unsigned char*& p, const unsigned char* end, unsigned long long& v) {
+    v = 0;
+    for (int shift = 0; p < end && shift < 64; shift += 7) {
+        unsigned char b = *p++;
+        v |= (unsigned long long)(b & 0x7f) << shift;
+        if (!(b & 0x80)) return true;
+    }
+    return false;
+}
+
+std::vector<unsigned char> encode_block(const std::vector<TsPoint>& points) {
+    std::vector<unsigned char> payload;
+    RawPoint prev = to_raw(points.front());
+    for (size_t i = 1; i < points.size(); ++i) {
+        RawPoint cur = to_raw(points[i]);
+        put_varint(payload, (unsigned long long)(cur.day - prev.day));
+        put_varint(payload, zigzag(cur.kb - prev.kb));
+        put_varint(payload, zigzag(cur.files - prev.files));
+        prev = cur;
+    }
+
+    BlockHeader h;
+    RawPoint first = to_raw(points.front());
+    h.magic = kBlockMagic;
+    h.count = (unsigned int)points.size();
+    h.first_day = first.day;
+    h.last_day = points.back().day;
+    h.first_kb = first.kb;
+    h.first_files = first.files;
+    h.payload = (unsigned int)payload.size();
+    h.reserved = 0;
+
+    std::vector<unsigned char> block(sizeof(h) + payload.size());
+    memcpy(block.data(), &h, sizeof(h));
+    if (!payload.empty()) memcpy(block.data() + sizeof(h), payload.data(), payload.size());
+    return block;
+}
+
+// Decode one block's points; false if the block is malformed
+bool decode_block(const BlockHeader& h, const unsigned char* payload, std::vector<TsPoint>& out) {
+    RawPoint cur;
+    cur.day = h.first_day;
+    cur.kb = h.first_kb;
+    cur.files = h.first_files;
+    out.push_back(from_raw(cur));
+
+    const unsigned char* p = payload;
+    const unsigned char* end = payload + h.payload;
+    for (unsigned int i = 1; i < h.count; ++i) {
+        unsigned long long dd, dkb, dfiles;
+        if (!get_varint(p, end, dd) || !get_varint(p, end, dkb) || !get_varint(p, end, dfiles))
+            return false;
+        cur.day += (int)dd;
+        cur.kb += unzigzag(dkb);
+        cur.files += unzigzag(dfiles);
+        out.push_back(from_raw(cur));
+    }
+    return true;
+}
+
+// Read-only view of a whole series file
+class MappedFile {
+public:
+    explicit MappedFile(const std::string& path) {
+        file_ = CreateFileA(path.c_str(), GENERIC_READ, FILE_SHARE_READ | FILE_SHARE_WRITE,
+                            NULL, OPEN_EXISTING, FILE_ATTRIBUTE_NORMAL, NULL);
+        if (file_ == INVALID_HANDLE_VALUE) return;
+        LARGE_INTEGER sz;
+        if (!GetFileSizeEx(file_, &sz) || sz.QuadPart == 0) return;
+        mapping_ = CreateFileMappingA(file_, NULL, PAGE_READONLY, 0, 0, NULL);
+        if (!mapping_) return;
+        data_ = (const unsigned char*)MapViewOfFile(mapping_, FILE_MAP_READ, 0, 0, 0);
+        if (data_) size_ = (size_t)sz.QuadPart;
+    }
+
+    ~MappedFile() {
+        if (data_) UnmapViewOfFile(data_);
+        if (mapping_) CloseHandle(mapping_);
+        if (file_ != INVALID_HANDLE_VALUE) CloseHandle(file_);
+    }
+
+    const unsigned char* data() const { return data_; }
+    size_t size() const { return size_; }
+
+private:
+    HANDLE file_ = INVALID_HANDLE_VALUE;
+    HANDLE mapping_ = NULL;
+    const unsigned char* data_ = nullptr;
+    size_t size_ = 0;
+};
+
+// Calls fn(offset, header) for every well-formed block in order
+template <typename Fn>
+void for_each_block(const MappedFile& mf, Fn fn) {
+    size_t off = 0;
+    while (off + sizeof(BlockHeader) <= mf.size()) {
+        BlockHeader h;
+        memcpy(&h, mf.data() + off, sizeof(h));
+        if (h.magic != kBlockMagic || h.count == 0) break;
+        if (off + sizeof(h) + h.payload > mf.size()) break;
+        if (!fn(off, h)) break;
+        off += sizeof(h) + h.payload;
+    }
+}
+
+} // namespace
+
+TimeSeriesStore::TimeSeriesStore() {}
+
+TimeSeriesStore::~TimeSeriesStore() { close(); }
+
+int TimeSeriesStore::open(const std::string& dir) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_.clear();
+    dir_.clear();
+    bool created = CreateDirectoryA(dir.c_str(), NULL) != 0;
+    DWORD attrs = GetFileAttributesA(dir.c_str());
+    if (attrs == INVALID_FILE_ATTRIBUTES || !(attrs & FILE_ATTRIBUTE_DIRECTORY)) return -1;
+    dir_ = dir;
+    return created ? 1 : 0;
+}
+
+void TimeSeriesStore::close() {
+    std::lock_guard<std::mutex> lock(mutex_);
+    series_.clear();
+    dir_.clear();
+}
+
+bool TimeSeriesStore::is_open() const {
+    return !dir_.empty();
+}
+
+std::string TimeSeriesStore::series_path(TsKind kind, int entity_id) const {
+    return path_join(dir_, std::string(kind == TS_USAGE ? "u_" : "i_") +
+                           std::to_string(entity_id) + ".fts");
+}
+
+TimeSeriesStore::Series& TimeSeriesStore::load_series(TsKind kind, int entity_id) {
+    auto key = std::make_pair((int)kind, entity_id);
+    auto it = series_.find(key);
+    if (it != series_.end()) return it->second;
+
+    Series& s = series_[key];
+    MappedFile mf(series_path(kind, entity_id));
+    if (!mf.data()) return s;
+
+    // The last block stays open for appends
+    size_t last_off = 0;
+    BlockHeader last{};
+    bool any = false;
+    for_each_block(mf, [&](size_t off, const BlockHeader& h) {
+        last_off = off;
+        last = h;
+        any = true;
+        return true;
+    });
+    if (!any) return s;
+
+    // A full last block is kept too, so its newest day can still be
+    // replaced; the next new day seals it
+    s.last_day = last.last_day;
+    s.tail_offset = last_off;
+    decode_block(last, mf.data() + last_off + sizeof(BlockHeader), s.tail);
+    return s;
+}
+
+int TimeSeriesStore::append(TsKind kind, int entity_id, int day, double size_mb,
+                            long long file_count) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dir_.empty()) return -1;
+
+    Series& s = load_series(kind, entity_id);
+    if (day < s.last_day) return 0;
+
+    TsPoint pt;
+    pt.day = day;
+    pt.size_mb = size_mb;
+    pt.file_count = file_count;
+
+    if (day == s.last_day && !s.tail.empty()) {
+        s.tail.back() = pt;
+    } else {
+        if (s.tail.size() >= kBlockPoints) {
+            s.tail_offset += encode_block(s.tail).size();
+            s.tail.clear();
+        }
+        s.tail.push_back(pt);
+        s.last_day = day;
+    }
+
+    // Rewrite the open block in place
+    std::vector<unsigned char> block = encode_block(s.tail);
+    HANDLE h = CreateFileA(series_path(kind, entity_id).c_str(), GENERIC_WRITE,
+                           FILE_SHARE_READ, NULL, OPEN_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return -1;
+    LARGE_INTEGER pos;
+    pos.QuadPart = (LONGLONG)s.tail_offset;
+    DWORD written = 0;
+    bool ok = SetFilePointerEx(h, pos, NULL, FILE_BEGIN) &&
+              WriteFile(h, block.data(), (DWORD)block.size(), &written, NULL) &&
+              written == block.size() &&
+              SetEndOfFile(h);
+    CloseHandle(h);
+    if (!ok) {
+        // Force a reload from disk on the next append
+        series_.erase(std::make_pair((int)kind, entity_id));
+        return -1;
+    }
+    return 0;
+}
+
+int TimeSeriesStore::scan(TsKind kind, int entity_id, int from_day, int to_day,
+                          std::vector<TsPoint>& out) {
+    std::lock_guard<std::mutex> lock(mutex_);
+    if (dir_.empty()) return -1;
+
+    MappedFile mf(series_path(kind, entity_id));
+    if (!mf.data()) return 0;
+
+    std::vector<TsPoint> block;
+    for_each_block(mf, [&](size_t off, const BlockHeader& h) {
+        if (h.first_day > to_day) return false;
+        if (h.last_day < from_day) return true;  // skip without decoding
+        block.clear();
+        if (!decode_block(h, mf.data() + off + sizeof(BlockHeader), block)) return false;
+        for (auto& p : block) {
+            if (p.day >= from_day && p.day <= to_day) out.push_back(p);
+        }
+        return true;
+    });
+    return 0;
+}
+
+std::vector<int> TimeSeriesStore::entities(TsKind kind) {
+    std::string dir;
+    {
+        std::lock_guard<std::mutex> lock(mutex_);
+        dir = dir_;
+    }
+    std::vector<int> ids;
+    if (dir.empty()) return ids;
+
+    const char* prefix = (kind == TS_USAGE) ? "u_" : "i_";
+    for (auto& e : list_dir(dir)) {
+        if (e.is_dir || e.name.size() < 7) continue;
+        if (e.name.compare(0, 2, prefix) != 0) continue;
+        if (e.name.compare(e.name.size() - 4, 4, ".fts") != 0) continue;
+        std::string num = e.name.substr(2, e.name.size() - 6);
+        if (is_number(num)) ids.push_back(std::stoi(num));
+    }
+    std::sort(ids.begin(), ids.end());
+    return ids;
+}
+
+TimeSeriesStore& ts_store() {
+    static TimeSeriesStore store;
+    return store;
+}
+
+int ts_backfill(Database& db, TimeSeriesStore& store) {
+    EntityRegistry& reg = entity_registry();
+
+    // Rows come back oldest first, so later scans of a day replace earlier ones
+    for (auto& r : db.get_history(36500, "", -1, '*', FIFO_GRAN_ASSET_IDX_CAT)) {
+        int id = r.entity_id >= 0 ? r.entity_id : reg.intern(r.asset, r.index_val, r.category);
+        if (store.append(TS_USAGE, id, (int)date_ordinal(r.date), r.size_mb, r.file_count) != 0)
+            return -1;
+    }
+    for (auto& r : db.get_ingest(-1)) {
+        if (store.append(TS_INGEST, r.entity_id, (int)date_ordinal(r.date), r.size_mb, r.file_count) != 0)
+            return -1;
+    }
+    return reg.persist(db);
+}
+
+std::vector<TsPoint> ts_daily_totals(TimeSeriesStore& store, TsKind kind, int days) {
+    int to_day = (int)date_ordinal(today_date());
+    int from_day = to_day - days;
+
+    std::map<int, TsPoint> totals;
+    std::vector<TsPoint> points;
+    for (int id : store.entities(kind)) {
+        points.clear();
+        store.scan(kind, id, from_day, to_day, points);
+        for (auto& p : points) {
+            TsPoint& t = totals[p.day];
+            t.day = p.day;
+            t.size_mb += p.size_mb;
+            t.file_count += p.file_count;
+        }
+    }
+
+    std::vector<TsPoint> result;
+    for (auto& kv : totals) result.push_back(kv.second);
+    return result;
+}
+
+std::vector<WeightRecord> ts_average_weights(TimeSeriesStore& store, int days, int granularity) {
+    EntityRegistry& reg = entity_registry();
+    int to_day = (int)date_ordinal(today_date());
+    int from_day = to_day - days;
+
+    // Roll fine series up to the requested level, summing per day
+    std::map<int, std::map<int, double>> per_entity_day;
+    std::vector<TsPoint> points;
+    for (int id : store.entities(TS_USAGE)) {
+        if (id >= reg.size()) continue;
+        const EntityKey& k = reg.key(id);
+        int agg_id = id;
+        if (granularity < FIFO_GRAN_ASSET_IDX_CAT) {
+            agg_id = reg.intern(k.asset,
+                                (granularity >= FIFO_GRAN_ASSET_INDEX) ? k.index_val : -1,
+                                '*');
+        }
+        points.clear();
+        store.scan(TS_USAGE, id, from_day, to_day, points);
+        auto& days_map = per_entity_day[agg_id];
+        for (auto& p : points) days_map[p.day] += p.size_mb;
+    }
+
+    std::vector<WeightRecord> result;
+    for (auto& kv : per_entity_day) {
+        if (kv.second.empty()) continue;
+        const EntityKey& k = reg.key(kv.first);
+        WeightRecord w;
+        w.asset = k.asset;
+        w.index_val = k.index_val;
+        w.category = k.category;
+        w.total_mb = 0;
+        for (auto& d : kv.second) w.total_mb += d.second;
+        w.day_count = (int)kv.second.size();
+        w.avg_mb = w.total_mb / w.day_count;
+        result.push_back(w);
+    }
+    std::sort(result.begin(), result.end(), [](const WeightRecord& a, const WeightRecord& b) {
+        if (a.asset != b.asset) return a.asset < b.asset;
+        if (a.index_val != b.index_val) return a.index_val < b.index_val;
+        return a.category < b.category;
+    });
+    return result;
+}
@@ -0,0 +1,81 @@
+#ifndef TSSTORE_H
+#define TSSTORE_H
+
+#include "database.h"
+#include <map>
+#include <mutex>
+#include <string>
+#include <utility>
+#include <vector>
+
+// Series kept per entity (finest granularity)
+enum TsKind {
+    TS_USAGE  = 0,  // storage_history snapshot: MB held by the entity on a day
+    TS_INGEST = 1   // daily_ingest: MB that landed in the entity's Day folder
+};
+
+struct TsPoint {
+    int       day;         // days since 1970-01-01
+    double    size_mb;
+    long long file_count;
+};
+
+// Columnar long-horizon history, one file per entity and kind, next to the
+// SQLite database. A file is a run of blocks of up to 128 points: a fixed
+// header with the first point and the block's day range, then day deltas
+// as varints and size (KiB) / file-count deltas as zig-zag varints. Range
+// scans memory-map the file and skip whole blocks by their day range, so a
+// 365-day read touches a few KB per entity.
+//
+// Points are append-only in day order; a second value for the newest day
+// replaces it, and values for older days are ignored (SQLite keeps them).
+class TimeSeriesStore {
+public:
+    TimeSeriesStore();
+    ~TimeSeriesStore();
+
+    // dir is created if missing; returns 1 when it was created empty
+    int  open(const std::string& dir);
+    void close();
+    bool is_open() const;
+
+    int append(TsKind kind, int entity_id, int day, double size_mb, long long file_count);
+
+    // Points with from_day <= day <= to_day, oldest first
+    int scan(TsKind kind, int entity_id, int from_day, int to_day, std::vector<TsPoint>& out);
+
+    // Entity ids that have a series of this kind
+    std::vector<int> entities(TsKind kind);
+
+private:
+    struct Series {
+        unsigned long long   tail_offset = 0;  // file offset of the open block
+        std::vector<TsPoint> tail;             // points of the open block
+        int                  last_day = -1;    // newest day in the file
+    };
+
+    std::string series_path(TsKind kind, int entity_id) const;
+    Series& load_series(TsKind kind, int entity_id);
+
+    std::mutex  mutex_;
+    std::string dir_;
+    std::map<std::pair<int, int>, Series> series_;
+};
+
+// Process-wide store, opened by fifo_init next to the database
+TimeSeriesStore& ts_store();
+
+// Spans longer than this are served from the store instead of SQLite
+const int TS_MIN_SPAN_DAYS = 30;
+
+// Copy SQLite history (finest-level snapshots and daily ingest) into an
+// empty store
+int ts_backfill(Database& db, TimeSeriesStore& store);
+
+// Per-day totals over all entities for the last `days` days, oldest first
+std::vector<TsPoint> ts_daily_totals(TimeSeriesStore& store, TsKind kind, int days);
+
+// Equivalent of Database::get_average_weights served from the store
+std::vector<WeightRecord> ts_average_weights(TimeSeriesStore& store, int days, int granularity);
+
+#endif // TSSTORE_H
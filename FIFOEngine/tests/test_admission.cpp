@@ -0,0 +1,90 @@
+// Space admission: fast-path reservations, eviction of the excess, refusal
+// past the limit, and releasing what was written
+#include "test_util.h"
+#include "admission.h"
+#include "cleanup.h"
+#include "entity_registry.h"
+#include "lease.h"
+#include "fifo_api.h"
+
+static const long long MB = 1024 * 1024;
+
+static int count_files(const std::string& root) {
+    int n = 0;
+    for (int d = 1; d <= 10; ++d) {
+        for (int i = 1; i <= 4; ++i) {
+            std::string day = test_day_dir(root, "A", 1, 'E', 2026, 1, d);
+            if (test_exists(day + "\\f" + std::to_string(i) + ".dat")) n++;
+        }
+    }
+    return n;
+}
+
+int main() {
+    TestDir dir("admission");
+    std::string root = dir / "root";
+    for (int d = 1; d <= 10; ++d) {
+        for (int i = 1; i <= 4; ++i) {
+            std::string day = test_day_dir(root, "A", 1, 'E', 2026, 1, d);
+            CHECK(test_file(day + "\\f" + std::to_string(i) + ".dat", 1,
+                            test_time(2026, 1, d, i)));
+        }
+    }
+
+    Database db;
+    CHECK(db.open(dir / "fifo.db") == 0);
+    CHECK(entity_registry().load(db) == 0);
+    CHECK(root_lease().acquire(root, 90) == 0);
+
+    // 40 MB used of 50; the cleanup band starts at edge
+    Admission& adm = admission();
+    CHECK(adm.reserve(1000 * MB) == FIFO_OK);   // not configured: admission is off
+    adm.configure(dir / "fifo.db", root, 50, 40);
+    CHECK(adm.configured());
+    double edge = band_edge_mb(FIFO_ACTION_CLEANUP, 50);
+    CHECK(edge > 42 && edge < 48);
+
+    // Below the band: granted without touching the root
+    CHECK(adm.reserve(2 * MB) == FIFO_OK);
+    CHECK_NEAR(adm.reserved_mb(), 2, 0.001);
+    CHECK(adm.evictions() == 0);
+    CHECK(count_files(root) == 40);
+
+    // Into the band: the oldest files go first, then it is granted
+    CHECK(adm.reserve(6 * MB) == FIFO_OK);
+    CHECK(adm.evictions() == 1);
+    CHECK_NEAR(adm.reserved_mb(), 8, 0.001);
+    CHECK(adm.usage_mb() + adm.reserved_mb() <= edge + 0.001);
+    CHECK_NEAR(adm.evicted_mb(), 40 - adm.usage_mb(), 0.001);
+    int left = count_files(root);
+    CHECK(left == 40 - (int)(adm.evicted_mb() + 0.5));
+    CHECK(!test_exists(test_day_dir(root, "A", 1, 'E', 2026, 1, 1) + "\\f1.dat"));
+    CHECK(test_exists(test_day_dir(root, "A", 1, 'E', 2026, 1, 5) + "\\f4.dat"));
+
+    // Beyond the limit even after evicting: refused, nothing reserved
+    CHECK(adm.reserve(60 * MB) == FIFO_ERR_FULL);
+    CHECK(adm.denied() == 1);
+    CHECK(adm.evictions() == 2);
+    CHECK_NEAR(adm.reserved_mb(), 8, 0.001);
+    // The newest day folder is never evicted
+    for (int i = 1; i <= 4; ++i)
+        CHECK(test_exists(test_day_dir(root, "A", 1, 'E', 2026, 1, 10) + "\\f" +
+                          std::to_string(i) + ".dat"));
+
+    // Written bytes count as usage until the next scan re-bases it
+    double usage = adm.usage_mb();
+    adm.release(2 * MB, 1 * MB);
+    CHECK_NEAR(adm.reserved_mb(), 6, 0.001);
+    CHECK_NEAR(adm.usage_mb(), usage + 1, 0.001);
+    adm.on_scan(root, 12);
+    CHECK_NEAR(adm.usage_mb(), 12, 0.001);
+    adm.on_scan(dir / "other", 30);
+    CHECK_NEAR(adm.usage_mb(), 12, 0.001);
+    adm.release(6 * MB, 0);
+    CHECK_NEAR(adm.reserved_mb(), 0, 0.001);
+
+    adm.close();
+    root_lease().release();
+    db.close();
+    return test_result("test_admission");
+}
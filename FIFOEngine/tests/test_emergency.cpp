@@ -0,0 +1,105 @@
+// Emergency eviction: the watermark check, and stepping through the oldest
+// eligible folders under the retention and deletion limits.
+// The watermarks are set far below the fill of the test volume, so a run
+// always triggers and never gets back under the soft one.
+#include "test_util.h"
+#include "emergency.h"
+#include "entity_registry.h"
+#include "lease.h"
+
+static const char* ASSETS[] = {"A", "B"};
+
+static void make_tree(const std::string& root) {
+    for (const char* asset : ASSETS) {
+        for (int d = 1; d <= 3; ++d) {
+            for (int i = 1; i <= 2; ++i) {
+                std::string day = test_day_dir(root, asset, 1, 'E', 2026, 1, d);
+                CHECK(test_file(day + "\\f" + std::to_string(i) + ".dat", 1,
+                                test_time(2026, 1, d, i)));
+            }
+        }
+    }
+}
+
+static int count_files(const std::string& root, int day) {
+    int n = 0;
+    for (const char* asset : ASSETS) {
+        for (int i = 1; i <= 2; ++i) {
+            std::string dir = test_day_dir(root, asset, 1, 'E', 2026, 1, day);
+            if (test_exists(dir + "\\f" + std::to_string(i) + ".dat")) n++;
+        }
+    }
+    return n;
+}
+
+static int count_reason(Database& db, const std::string& reason) {
+    int n = 0;
+    for (auto& r : db.get_deletion_logs(1000))
+        if (r.reason == reason) n++;
+    return n;
+}
+
+int main() {
+    TestDir dir("emergency");
+    std::string root = dir / "root";
+    make_tree(root);
+
+    Database db;
+    CHECK(db.open(dir / "fifo.db") == 0);
+    CHECK(entity_registry().load(db) == 0);
+    CHECK(root_lease().acquire(root, 90) == 0);
+    EvictionParams eviction;
+
+    VolumeSpace vol;
+    CHECK(volume_space(root, vol));
+    CHECK(vol.total_mb > 0 && vol.used_pct > 0.002);
+
+    // Off, and under the hard watermark: one query, nothing deleted
+    db.set_config("emergency_hard_pct", "0");
+    EmergencyStats off = run_emergency(db, root, eviction);
+    CHECK(!off.triggered);
+    db.set_config("emergency_hard_pct", "100");
+    EmergencyStats under = run_emergency(db, root, eviction);
+    CHECK(!under.triggered);
+    CHECK(under.used_pct_before > 0);
+    CHECK(count_files(root, 1) + count_files(root, 2) + count_files(root, 3) == 12);
+
+    // A soft watermark at or above the hard one falls back below it
+    db.set_config("emergency_hard_pct", "0.002");
+    db.set_config("emergency_soft_pct", "50");
+    CHECK_NEAR(load_emergency_params(db).soft_pct, 0.002 - 5, 0.0001);
+
+    // The deletion cap ends the run, oldest folders first
+    db.set_config("emergency_soft_pct", "0.001");
+    eviction.max_deletions = 3;
+    EmergencyStats capped = run_emergency(db, root, eviction);
+    CHECK(capped.triggered);
+    CHECK(capped.files_deleted == 3);
+    CHECK(capped.steps >= 1);
+    CHECK(count_files(root, 1) == 1);
+    CHECK(count_files(root, 2) == 4);
+
+    // Uncapped: every eligible file goes, each entity's newest day stays
+    eviction.max_deletions = 500;
+    EmergencyStats all = run_emergency(db, root, eviction);
+    CHECK(all.triggered);
+    CHECK(all.files_deleted == 5);
+    CHECK_NEAR(all.mb_freed, 5, 0.001);
+    CHECK(all.steps >= 1);
+    CHECK(all.elapsed_ms >= 0);
+    CHECK(count_files(root, 1) == 0);
+    CHECK(count_files(root, 2) == 0);
+    CHECK(count_files(root, 3) == 4);
+    CHECK(count_reason(db, "EMERGENCY_CLEANUP") == 8);
+    CHECK(db.get_open_cleanup_batches().empty());
+
+    // Nothing eligible left: still triggered, nothing more deleted
+    EmergencyStats again = run_emergency(db, root, eviction);
+    CHECK(again.triggered);
+    CHECK(again.files_deleted == 0);
+    CHECK(count_files(root, 3) == 4);
+
+    root_lease().release();
+    db.close();
+    return test_result("test_emergency");
+}
@@ -0,0 +1,113 @@
+// Eviction policies: the order each one hands to the cleanup walk
+#include "test_util.h"
+#include "eviction.h"
+#include "entity_registry.h"
+#include <vector>
+
+static ScannedFile file(int entity_id, time_t created, double size_mb) {
+    ScannedFile f{};
+    f.full_path = std::to_string(entity_id) + "_" + std::to_string((long long)created) + "_" +
+                  std::to_string(size_mb);
+    f.entity_id = entity_id;
+    f.created_time = created;
+    f.size_mb = size_mb;
+    return f;
+}
+
+static std::vector<ScannedFile> ordered(const EvictionParams& params,
+                                        std::vector<ScannedFile> candidates, double amount_mb) {
+    std::vector<ScannedFile> all = candidates;
+    make_eviction_policy(params)->order(candidates, all, amount_mb);
+    return candidates;
+}
+
+int main() {
+    TestDir dir("eviction");
+    Database db;
+    CHECK(db.open(dir / "fifo.db") == 0);
+    CHECK(entity_registry().load(db) == 0);
+    int a_e = entity_registry().intern("A", 1, 'E');
+    int b_e = entity_registry().intern("B", 1, 'E');
+    int b_f = entity_registry().intern("B", 1, 'F');
+
+    // fifo, and unknown names that fall back to it: oldest first
+    {
+        EvictionParams params;
+        std::vector<ScannedFile> files = {file(a_e, test_time(2026, 1, 3), 1),
+                                          file(b_e, test_time(2026, 1, 1), 1),
+                                          file(a_e, test_time(2026, 1, 2), 1)};
+        for (const char* policy : {"fifo", "no_such_policy"}) {
+            params.policy = policy;
+            std::vector<ScannedFile> out = ordered(params, files, 1);
+            CHECK(out[0].created_time == test_time(2026, 1, 1));
+            CHECK(out[1].created_time == test_time(2026, 1, 2));
+            CHECK(out[2].created_time == test_time(2026, 1, 3));
+        }
+    }
+
+    // largest_oldest: slack_days windows from the oldest file, largest
+    // first inside a window
+    {
+        std::vector<ScannedFile> files = {file(a_e, test_time(2026, 1, 1, 1), 1),
+                                          file(a_e, test_time(2026, 1, 1, 2), 3),
+                                          file(a_e, test_time(2026, 1, 1, 3), 2),
+                                          file(a_e, test_time(2026, 1, 2, 1), 5),
+                                          file(a_e, test_time(2026, 1, 2, 2), 1)};
+        EvictionParams params;
+        params.policy = "largest_oldest";
+        params.slack_days = 1;
+        std::vector<ScannedFile> out = ordered(params, files, 1);
+        const double by_day[] = {3, 2, 1, 5, 1};
+        for (int i = 0; i < 5; ++i) CHECK_NEAR(out[i].size_mb, by_day[i], 0.001);
+
+        params.slack_days = 2;
+        out = ordered(params, files, 1);
+        const double two_days[] = {5, 3, 2, 1, 1};
+        for (int i = 0; i < 5; ++i) CHECK_NEAR(out[i].size_mb, two_days[i], 0.001);
+    }
+
+    // fair_share: asset A holds 30 MB and B 10 MB, B's files are older.
+    // With equal shares of the 30 MB left after freeing 10, A is evicted
+    // until it is no further over its quota than B
+    {
+        std::vector<ScannedFile> files;
+        for (int i = 0; i < 10; ++i)
+            files.push_back(file(i % 2 ? b_e : b_f, test_time(2026, 1, 1, i), 1));
+        for (int i = 0; i < 30; ++i) files.push_back(file(a_e, test_time(2026, 1, 2) + i * 60, 1));
+
+        EvictionParams params;
+        params.policy = "fair_share";
+        std::vector<ScannedFile> out = ordered(params, files, 10);
+        CHECK(out.size() == 40);
+        for (int i = 0; i < 20; ++i) CHECK(out[i].entity_id == a_e);
+        // Then both sit at their quota and take turns
+        CHECK(out[20].entity_id != a_e || out[21].entity_id != a_e);
+        // Oldest first within an asset
+        for (int i = 1; i < 20; ++i) CHECK(out[i].created_time > out[i - 1].created_time);
+
+        // A weighted share moves the balance point: A=1, B=3
+        params.asset_shares["A"] = 1;
+        params.asset_shares["B"] = 3;
+        out = ordered(params, files, 10);
+        for (int i = 0; i < 27; ++i) CHECK(out[i].entity_id == a_e);
+        CHECK(out[27].entity_id != a_e);
+    }
+
+    // category_weighted: a heavier category ages more slowly
+    {
+        time_t now = time(nullptr);
+        std::vector<ScannedFile> files = {file(b_e, now - 10 * 86400, 1),
+                                          file(b_f, now - 6 * 86400, 1)};
+        EvictionParams params;
+        params.policy = "category_weighted";
+        params.weight_e = 2;
+        std::vector<ScannedFile> out = ordered(params, files, 1);
+        CHECK(out[0].entity_id == b_f);
+        params.weight_e = 1;
+        out = ordered(params, files, 1);
+        CHECK(out[0].entity_id == b_e);
+    }
+
+    db.close();
+    return test_result("test_eviction");
+}
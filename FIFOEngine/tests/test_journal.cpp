@@ -0,0 +1,95 @@
+// Cleanup intent journal: live batches, and resuming one a crash left open
+#include "test_util.h"
+#include "journal.h"
+#include "entity_registry.h"
+#include "lease.h"
+#include <vector>
+
+static bool allow(const std::string&) { return true; }
+static bool deny(const std::string&) { return false; }
+
+static int count_reason(Database& db, const std::string& reason) {
+    int n = 0;
+    for (auto& r : db.get_deletion_logs(1000))
+        if (r.reason == reason) n++;
+    return n;
+}
+
+int main() {
+    TestDir dir("journal");
+    std::string root = dir / "root";
+    std::string day = test_day_dir(root, "A", 1, 'E', 2026, 1, 1);
+
+    Database db;
+    CHECK(db.open(dir / "fifo.db") == 0);
+    CHECK(entity_registry().load(db) == 0);
+    int entity = entity_registry().intern("A", 1, 'E');
+
+    std::vector<ScannedFile> files;
+    for (int i = 0; i < 10; ++i) {
+        ScannedFile f{};
+        f.full_path = day + "\\f" + std::to_string(i) + ".dat";
+        f.size_mb = 1;
+        f.created_time = test_time(2026, 1, 1, i);
+        f.entity_id = entity;
+        f.day = 20260101;
+        CHECK(test_file(f.full_path, 1, f.created_time));
+        files.push_back(f);
+    }
+    CHECK(root_lease().acquire(root, 90) == 0);
+
+    // Live batch: every removal is marked and logged, and close() ends it
+    {
+        CleanupJournal journal(db, root, "PREDICTIVE_CLEANUP");
+        std::vector<ScannedFile> batch(files.begin(), files.begin() + 3);
+        int seq = journal.plan(batch);
+        CHECK(seq >= 0);
+        for (auto& f : batch) CHECK(journal.remove(f, seq++));
+        journal.close();
+    }
+    for (int i = 0; i < 3; ++i) CHECK(!test_exists(files[i].full_path));
+    CHECK(db.get_open_cleanup_batches().empty());
+    CHECK(count_reason(db, "PREDICTIVE_CLEANUP") == 3);
+
+    // A crash after the plan committed: four intents stay planned, and one
+    // of those files was unlinked before its mark could commit
+    long long batch_id = db.open_cleanup_batch(root, "PREDICTIVE_CLEANUP");
+    CHECK(batch_id >= 0);
+    for (int i = 3; i < 7; ++i)
+        CHECK(db.add_cleanup_intent(batch_id, i - 3, files[i].full_path, entity, 1) == 0);
+    DeleteFileA(files[3].full_path.c_str());
+
+    // Not ours to delete from: left open for whoever holds the lease
+    ResumeStats skipped = resume_cleanup_batches(db, deny);
+    CHECK(skipped.batches == 0);
+    CHECK(db.get_open_cleanup_batches().size() == 1);
+    CHECK(test_exists(files[4].full_path));
+
+    ResumeStats resumed = resume_cleanup_batches(db, allow);
+    CHECK(resumed.batches == 1);
+    CHECK(resumed.files_deleted == 3);
+    CHECK(resumed.files_reconciled == 1);
+    CHECK_NEAR(resumed.mb_freed, 4, 0.001);
+    for (int i = 3; i < 7; ++i) CHECK(!test_exists(files[i].full_path));
+    CHECK(db.get_open_cleanup_batches().empty());
+    CHECK(db.get_planned_intents(batch_id).empty());
+    CHECK(count_reason(db, "PREDICTIVE_CLEANUP") == 6);
+    CHECK(count_reason(db, "RESUMED_CLEANUP") == 1);
+
+    // Once the lease is gone nothing more is removed
+    {
+        CleanupJournal journal(db, root, "PREDICTIVE_CLEANUP");
+        std::vector<ScannedFile> batch(files.begin() + 7, files.end());
+        int seq = journal.plan(batch);
+        CHECK(seq >= 0);
+        CHECK(journal.remove(batch[0], seq));
+        root_lease().release();
+        CHECK(!journal.remove(batch[1], seq + 1));
+        CHECK(journal.lease_lost());
+    }
+    CHECK(!test_exists(files[7].full_path));
+    CHECK(test_exists(files[8].full_path));
+
+    db.close();
+    return test_result("test_journal");
+}
@@ -0,0 +1,80 @@
+// Pipelined execute mode: eviction starts while the scan is still walking,
+// and a following cycle does not evict the same amount again
+#include "test_util.h"
+#include "pipeline.h"
+#include "fifo_api.h"
+#include "entity_registry.h"
+#include "lease.h"
+
+static int count_files(const std::string& root) {
+    int n = 0;
+    for (char cat : {'E', 'F'}) {
+        for (int d = 1; d <= 10; ++d) {
+            for (int i = 1; i <= 4; ++i) {
+                std::string dir = test_day_dir(root, "A", 1, cat, 2026, 1, d);
+                if (test_exists(dir + "\\f" + std::to_string(i) + ".dat")) n++;
+            }
+        }
+    }
+    return n;
+}
+
+int main() {
+    TestDir dir("pipeline");
+    std::string root = dir / "root";
+    for (char cat : {'E', 'F'}) {
+        for (int d = 1; d <= 10; ++d) {
+            for (int i = 1; i <= 4; ++i) {
+                std::string day = test_day_dir(root, "A", 1, cat, 2026, 1, d);
+                CHECK(test_file(day + "\\f" + std::to_string(i) + ".dat", 1,
+                                test_time(2026, 1, d, i)));
+            }
+        }
+    }
+
+    Database db;
+    CHECK(db.open(dir / "fifo.db") == 0);
+    CHECK(entity_registry().load(db) == 0);
+    CHECK(root_lease().acquire(root, 90) == 0);
+    db.set_config("eviction_policy", "fifo");
+    EvictionParams params = load_eviction_params(db);
+
+    // 80 MB against a 60 MB limit: once the scanned total crosses the
+    // cleanup band, the oldest folders are evicted while the walk goes on
+    PipelineResult first = execute_pipelined(db, root, FIFO_GRAN_ASSET_IDX_CAT, 60, 70, params);
+    CHECK(first.early_files_deleted > 0);
+    CHECK(first.first_free_secs >= 0);
+    // The scan total is what is left once the early deletions are done
+    CHECK_NEAR(first.scan.total_mb + first.early_mb_freed, 80, 0.01);
+    CHECK(first.cleanup.files_deleted >= first.early_files_deleted);
+    CHECK(first.cleanup.new_usage_mb <= 60 * 0.70 + 0.01);
+    CHECK(count_files(root) == 80 - first.cleanup.files_deleted);
+
+    // Each entity's newest day folder is never evicted
+    for (char cat : {'E', 'F'}) {
+        std::string newest = test_day_dir(root, "A", 1, cat, 2026, 1, 10);
+        for (int i = 1; i <= 4; ++i)
+            CHECK(test_exists(newest + "\\f" + std::to_string(i) + ".dat"));
+    }
+
+    // A forecast stored before a cleanup still predicts the old usage; what
+    // was freed since is netted out of the early budget, so the next cycle
+    // does not evict the same amount again
+    int left = count_files(root);
+    CHECK(db.insert_forecast("2026-01-10", 100) == 0);
+    DeletionRecord freed;
+    freed.file_path = test_day_dir(root, "A", 1, 'E', 2026, 1, 1) + "\\f1.dat";
+    freed.asset = "A";
+    freed.size_mb = 58;
+    freed.reason = "PREDICTIVE_CLEANUP";
+    CHECK(db.log_deletion(freed) == 0);
+    PipelineResult second = execute_pipelined(db, root, FIFO_GRAN_ASSET_IDX_CAT, 60, 70, params);
+    CHECK(second.early_files_deleted == 0);
+    CHECK(second.cleanup.files_deleted == 0);
+    CHECK(second.first_free_secs < 0);
+    CHECK(count_files(root) == left);
+
+    root_lease().release();
+    db.close();
+    return test_result("test_pipeline");
+}
@@ -0,0 +1,89 @@
+// Columnar time-series store: block sealing, reload and newest-day updates
+#include "test_util.h"
+#include "tsstore.h"
+#include "scanner.h"
+#include <vector>
+
+int main() {
+    TestDir dir("tsstore");
+    std::string path = dir / "series";
+
+    CHECK(date_ordinal("1970-01-01") == 0);
+    CHECK(ordinal_date(date_ordinal("2024-02-29")) == "2024-02-29");
+    CHECK(date_ordinal("2024-03-01") - date_ordinal("2024-02-28") == 2);
+
+    const int first = 19000;
+    {
+        TimeSeriesStore store;
+        CHECK(store.open(path) == 1);
+
+        // 300 days span three blocks: two sealed, one open
+        for (int d = 0; d < 300; ++d)
+            CHECK(store.append(TS_USAGE, 3, first + d, d * 1.5, d) == 0);
+        CHECK(store.append(TS_USAGE, 3, first + 299, 7.25, 9) == 0);   // newest day replaced
+        CHECK(store.append(TS_USAGE, 3, first + 100, 1, 1) == 0);      // older day ignored
+
+        std::vector<TsPoint> out;
+        CHECK(store.scan(TS_USAGE, 3, first, first + 299, out) == 0);
+        CHECK(out.size() == 300);
+        if (out.size() == 300) {
+            CHECK_NEAR(out[10].size_mb, 15.0, 0.001);
+            CHECK_NEAR(out[100].size_mb, 150.0, 0.001);
+            CHECK_NEAR(out.back().size_mb, 7.25, 0.001);
+            CHECK(out.back().file_count == 9);
+        }
+
+        // A range inside the second block
+        out.clear();
+        CHECK(store.scan(TS_USAGE, 3, first + 130, first + 139, out) == 0);
+        CHECK(out.size() == 10);
+        if (!out.empty()) CHECK(out.front().day == first + 130);
+    }
+
+    // Reopened: the open block is appended to where it left off
+    {
+        TimeSeriesStore store;
+        CHECK(store.open(path) == 0);
+        CHECK(store.append(TS_USAGE, 3, first + 300, 100, 1) == 0);
+        std::vector<TsPoint> out;
+        CHECK(store.scan(TS_USAGE, 3, first + 250, first + 400, out) == 0);
+        CHECK(out.size() == 51);
+        if (out.size() == 51) {
+            CHECK(out.front().day == first + 250);
+            CHECK_NEAR(out.back().size_mb, 100, 0.001);
+        }
+        std::vector<int> ids = store.entities(TS_USAGE);
+        CHECK(ids.size() == 1 && ids[0] == 3);
+
+        // Exactly one full block
+        for (int d = 0; d < 128; ++d)
+            CHECK(store.append(TS_INGEST, 4, first + d, d, d) == 0);
+    }
+
+    // A series reloaded on a full last block can still replace its newest
+    // day, and the next day seals that block
+    {
+        TimeSeriesStore store;
+        CHECK(store.open(path) == 0);
+        CHECK(store.append(TS_INGEST, 4, first + 127, 42, 1) == 0);
+        std::vector<TsPoint> out;
+        CHECK(store.scan(TS_INGEST, 4, first, first + 200, out) == 0);
+        CHECK(out.size() == 128);
+        if (!out.empty()) CHECK_NEAR(out.back().size_mb, 42, 0.001);
+        CHECK(store.append(TS_INGEST, 4, first + 128, 43, 1) == 0);
+    }
+    {
+        TimeSeriesStore store;
+        CHECK(store.open(path) == 0);
+        std::vector<TsPoint> out;
+        CHECK(store.scan(TS_INGEST, 4, first, first + 200, out) == 0);
+        CHECK(out.size() == 129);
+        if (out.size() == 129) {
+            CHECK_NEAR(out[127].size_mb, 42, 0.001);
+            CHECK_NEAR(out[128].size_mb, 43, 0.001);
+            CHECK_NEAR(out[50].size_mb, 50, 0.001);
+        }
+    }
+
+    return test_result("test_tsstore");
+}
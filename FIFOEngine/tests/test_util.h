@@ -0,0 +1,121 @@
+#ifndef FIFO_TEST_UTIL_H
+#define FIFO_TEST_UTIL_H
+
+// Shared by the engine tests. Each test is a plain executable registered
+// with CTest: failed CHECKs are printed and make main() return non-zero.
+
+#include <cmath>
+#include <cstdio>
+#include <ctime>
+#include <string>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+static int g_test_failures = 0;
+
+#define CHECK(cond)                                                              \
+    do {                                                                         \
+        if (!(cond)) {                                                           \
+            std::fprintf(stderr, "%s:%d: CHECK(%s) failed\n", __FILE__, __LINE__, \
+                         #cond);                                                 \
+            g_test_failures++;                                                   \
+        }                                                                        \
+    } while (0)
+
+#define CHECK_NEAR(a, b, eps) CHECK(std::fabs((double)(a) - (double)(b)) <= (eps))
+
+static inline int test_result(const char* name) {
+    std::printf("%s: %s\n", name, g_test_failures ? "FAILED" : "ok");
+    return g_test_failures ? 1 : 0;
+}
+
+// Local time of a calendar day and hour
+static inline time_t test_time(int year, int month, int day, int hour = 0) {
+    struct tm t = {};
+    t.tm_year = year - 1900;
+    t.tm_mon = month - 1;
+    t.tm_mday = day;
+    t.tm_hour = hour;
+    t.tm_isdst = -1;
+    return mktime(&t);
+}
+
+static inline void test_mkdirs(const std::string& path) {
+    for (size_t i = 1; i <= path.size(); ++i) {
+        if (i == path.size() || path[i] == '\\' || path[i] == '/')
+            CreateDirectoryA(path.substr(0, i).c_str(), NULL);
+    }
+}
+
+// size_mb of zeros at path, created and last written at `when`; parent
+// folders are created as needed
+static inline bool test_file(const std::string& path, double size_mb, time_t when) {
+    size_t slash = path.find_last_of("\\/");
+    if (slash != std::string::npos) test_mkdirs(path.substr(0, slash));
+    HANDLE h = CreateFileA(path.c_str(), GENERIC_WRITE, 0, NULL, CREATE_ALWAYS,
+                           FILE_ATTRIBUTE_NORMAL, NULL);
+    if (h == INVALID_HANDLE_VALUE) return false;
+    LARGE_INTEGER size;
+    size.QuadPart = (LONGLONG)(size_mb * 1024 * 1024);
+    unsigned long long ticks = (unsigned long long)when * 10000000ULL + 116444736000000000ULL;
+    FILETIME ft;
+    ft.dwLowDateTime = (DWORD)ticks;
+    ft.dwHighDateTime = (DWORD)(ticks >> 32);
+    bool ok = SetFilePointerEx(h, size, NULL, FILE_BEGIN) && SetEndOfFile(h) &&
+              SetFileTime(h, &ft, NULL, &ft);
+    CloseHandle(h);
+    return ok;
+}
+
+static inline bool test_exists(const std::string& path) {
+    return GetFileAttributesA(path.c_str()) != INVALID_FILE_ATTRIBUTES;
+}
+
+static inline void test_rmtree(const std::string& path) {
+    WIN32_FIND_DATAA fd;
+    HANDLE h = FindFirstFileA((path + "\\*").c_str(), &fd);
+    if (h != INVALID_HANDLE_VALUE) {
+        do {
+            std::string name = fd.cFileName;
+            if (name == "." || name == "..") continue;
+            std::string child = path + "\\" + name;
+            if (fd.dwFileAttributes & FILE_ATTRIBUTE_DIRECTORY) test_rmtree(child);
+            else DeleteFileA(child.c_str());
+        } while (FindNextFileA(h, &fd));
+        FindClose(h);
+    }
+    RemoveDirectoryA(path.c_str());
+}
+
+// Empty scratch folder under %TEMP%, removed again by the destructor
+class TestDir {
+public:
+    explicit TestDir(const char* name) {
+        char tmp[MAX_PATH];
+        GetTempPathA(MAX_PATH, tmp);
+        path_ = std::string(tmp) + "fifo_" + name;
+        test_rmtree(path_);
+        test_mkdirs(path_);
+    }
+    ~TestDir() { test_rmtree(path_); }
+
+    const std::string& path() const { return path_; }
+    std::string operator/(const std::string& rel) const { return path_ + "\\" + rel; }
+
+private:
+    std::string path_;
+};
+
+// ASSET\Index\E|F\YYYY\MM\DD below root
+static inline std::string test_day_dir(const std::string& root, const char* asset, int index,
+                                       char cat, int year, int month, int day) {
+    char buf[64];
+    std::snprintf(buf, sizeof(buf), "\\%s\\%d\\%c\\%04d\\%02d\\%02d", asset, index, cat,
+                  year, month, day);
+    return root + buf;
+}
+
+#endif // FIFO_TEST_UTIL_H
@@ -0,0 +1,61 @@
+// fifoctl: sends one command to a running fifod and prints its JSON reply.
+//
+//   fifoctl [--socket PATH] status|metrics|run|stop
+//
+// Exit code is 0 when the daemon answered with "ok":true, 1 when it
+// answered with an error, 2 when it could not be reached.
+
+#include "ipc.h"
+#include <cstdio>
+#include <cstring>
+#include <string>
+
+static void usage() {
+    fprintf(stderr, "usage: fifoctl [--socket PATH] status|metrics|run|stop\n");
+}
+
+int main(int argc, char** argv) {
+    std::string socket_path = ipc_default_path();
+    std::string command;
+    for (int i = 1; i < argc; ++i) {
+        if (strcmp(argv[i], "--socket") == 0 && i + 1 < argc) {
+            socket_path = argv[++i];
+        } else if (command.empty() && argv[i][0] != '-') {
+            command = argv[i];
+        } else {
+            usage();
+            return 2;
+        }
+    }
+    if (command.empty()) {
+        usage();
+        return 2;
+    }
+
+    if (!ipc_startup()) {
+        printf("{\"ok\":false,\"error\":\"winsock unavailable\"}\n");
+        return 2;
+    }
+
+    sockaddr_un addr;
+    SOCKET s = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (s == INVALID_SOCKET || !ipc_address(socket_path, addr) ||
+        connect(s, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        printf("{\"ok\":false,\"error\":\"fifod not reachable\"}\n");
+        if (s != INVALID_SOCKET) closesocket(s);
+        WSACleanup();
+        return 2;
+    }
+
+    std::string reply;
+    bool ok = ipc_send_all(s, command + "\n") && ipc_recv_line(s, reply, 1 << 20);
+    closesocket(s);
+    WSACleanup();
+    if (!ok) {
+        printf("{\"ok\":false,\"error\":\"no reply from fifod\"}\n");
+        return 2;
+    }
+
+    printf("%s\n", reply.c_str());
+    return reply.find("\"ok\":true") != std::string::npos ? 0 : 1;
+}
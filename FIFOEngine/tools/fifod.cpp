@@ -0,0 +1,379 @@
+// fifod: headless resident host for the engine.
+//
+//   fifod --db PATH --root PATH --limit-mb N [--target-pct P]
+//         [--granularity G] [--interval MIN | --at HH:MM | --adaptive MIN:MAX]
+//         [--socket PATH] [--trace PATH]
+//
+// Keeps one engine instance loaded with its database connection and last
+// scan in memory, runs the scheduler on that warm state, and answers
+// fifoctl commands over a local socket:
+//   status   current usage, forecast and schedule
+//   metrics  cycle counters from fifo_get_metrics
+//   run      one full cycle now; replies when it has finished
+//   stop     shut down
+// Ctrl+C or a service stop does the same as "stop". --trace records the
+// workload for fiforeplay.
+
+#include "fifo_api.h"
+#include "ipc.h"
+#include <aclapi.h>
+#include <sddl.h>
+#include <atomic>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <mutex>
+#include <string>
+#include <thread>
+
+struct DaemonConfig {
+    std::string db_path;
+    std::string root_path;
+    std::string socket_path;
+    std::string trace_path;
+    int    granularity = FIFO_GRAN_ASSET_IDX_CAT;
+    double limit_mb = 0;
+    double target_pct = 70;
+    int    interval_minutes = 60;
+    int    hour = -1;           // daily mode when >= 0
+    int    minute = 0;
+    int    adaptive_min = 0;    // adaptive mode when > 0
+    int    adaptive_max = 0;
+};
+
+static std::atomic<bool> g_stop{false};
+static std::atomic<int>  g_clients{0};
+static SOCKET            g_listener = INVALID_SOCKET;
+
+// Last status read while no cycle was running; served during cycles
+static std::mutex g_status_mutex;
+static StatusInfo g_status;
+
+static void request_stop() {
+    if (g_stop.exchange(true)) return;
+    // Unblocks accept() in the main loop
+    SOCKET s = g_listener;
+    if (s != INVALID_SOCKET) closesocket(s);
+}
+
+static BOOL WINAPI on_console_ctrl(DWORD) {
+    request_stop();
+    return TRUE;
+}
+
+// Connecting to an AF_UNIX socket needs write access to its file, which
+// under %ProgramData% any local user would otherwise get. Limits it to
+// SYSTEM, Administrators and the account running fifod. Done between
+// bind() and listen(), so nobody can connect before it is in place.
+static bool restrict_socket(const std::string& path) {
+    PSECURITY_DESCRIPTOR sd = nullptr;
+    if (!ConvertStringSecurityDescriptorToSecurityDescriptorA(
+            "D:P(A;;FA;;;SY)(A;;FA;;;BA)(A;;FA;;;OW)", SDDL_REVISION_1, &sd, nullptr))
+        return false;
+    bool ok = false;
+    PACL dacl = nullptr;
+    BOOL present = FALSE, defaulted = FALSE;
+    // The socket file is a reparse point; open it rather than what it names
+    HANDLE h = CreateFileA(path.c_str(), READ_CONTROL | WRITE_DAC, 0, nullptr, OPEN_EXISTING,
+                           FILE_FLAG_OPEN_REPARSE_POINT | FILE_FLAG_BACKUP_SEMANTICS, nullptr);
+    if (h != INVALID_HANDLE_VALUE) {
+        ok = GetSecurityDescriptorDacl(sd, &present, &dacl, &defaulted) &&
+             SetSecurityInfo(h, SE_FILE_OBJECT,
+                             DACL_SECURITY_INFORMATION | PROTECTED_DACL_SECURITY_INFORMATION,
+                             nullptr, nullptr, dacl, nullptr) == ERROR_SUCCESS;
+        CloseHandle(h);
+    }
+    LocalFree(sd);
+    return ok;
+}
+
+static void usage() {
+    fprintf(stderr,
+            "usage: fifod --db PATH --root PATH --limit-mb N [--target-pct P]\n"
+            "             [--granularity G] [--interval MIN | --at HH:MM | --adaptive MIN:MAX]\n"
+            "             [--socket PATH] [--trace PATH]\n");
+}
+
+static bool parse_args(int argc, char** argv, DaemonConfig& cfg) {
+    cfg.socket_path = ipc_default_path();
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (i + 1 >= argc) return false;
+        const char* v = argv[++i];
+        if (arg == "--db") cfg.db_path = v;
+        else if (arg == "--root") cfg.root_path = v;
+        else if (arg == "--socket") cfg.socket_path = v;
+        else if (arg == "--trace") cfg.trace_path = v;
+        else if (arg == "--limit-mb") cfg.limit_mb = atof(v);
+        else if (arg == "--target-pct") cfg.target_pct = atof(v);
+        else if (arg == "--granularity") cfg.granularity = atoi(v);
+        else if (arg == "--interval") cfg.interval_minutes = atoi(v);
+        else if (arg == "--at") {
+            if (sscanf(v, "%d:%d", &cfg.hour, &cfg.minute) != 2) return false;
+        } else if (arg == "--adaptive") {
+            if (sscanf(v, "%d:%d", &cfg.adaptive_min, &cfg.adaptive_max) != 2) return false;
+        } else {
+            return false;
+        }
+    }
+    return !cfg.db_path.empty() && !cfg.root_path.empty() && cfg.limit_mb > 0;
+}
+
+// Minimal JSON writer for the flat replies below
+class JsonObject {
+public:
+    JsonObject& str(const char* key, const char* value) {
+        field(key);
+        out_ += '"';
+        for (const char* p = value; *p; ++p) {
+            unsigned char c = (unsigned char)*p;
+            if (c == '"' || c == '\\') {
+                out_ += '\\';
+                out_ += (char)c;
+            } else if (c < 0x20) {
+                char esc[8];
+                snprintf(esc, sizeof(esc), "\\u%04x", c);
+                out_ += esc;
+            } else {
+                out_ += (char)c;
+            }
+        }
+        out_ += '"';
+        return *this;
+    }
+    JsonObject& num(const char* key, double value) {
+        char buf[32];
+        snprintf(buf, sizeof(buf), "%.3f", value);
+        field(key);
+        out_ += buf;
+        return *this;
+    }
+    JsonObject& num(const char* key, long long value) {
+        field(key);
+        out_ += std::to_string(value);
+        return *this;
+    }
+    JsonObject& num(const char* key, int value) { return num(key, (long long)value); }
+    JsonObject& flag(const char* key, bool value) {
+        field(key);
+        out_ += value ? "true" : "false";
+        return *this;
+    }
+    std::string done() const { return out_ + "}"; }
+
+private:
+    void field(const char* key) {
+        out_ += out_.size() > 1 ? ",\"" : "\"";
+        out_ += key;
+        out_ += "\":";
+    }
+    std::string out_ = "{";
+};
+
+static const char* action_label(int action) {
+    switch (action) {
+    case FIFO_ACTION_SAFE:    return "SAFE";
+    case FIFO_ACTION_MONITOR: return "MONITOR";
+    case FIFO_ACTION_CAUTION: return "CAUTION";
+    case FIFO_ACTION_CLEANUP: return "CLEANUP";
+    default:                  return "UNKNOWN";
+    }
+}
+
+static std::string error_reply(const char* message, int rc = 0) {
+    JsonObject j;
+    j.flag("ok", false).str("error", message);
+    if (rc) j.num("rc", rc);
+    return j.done();
+}
+
+static std::string cmd_status(const DaemonConfig& cfg) {
+    EngineMetrics m;
+    fifo_get_metrics(&m);
+
+    // fifo_get_status waits for a running cycle; answer from the last
+    // reading instead so status stays instant
+    StatusInfo st;
+    bool busy = m.in_cycle != 0;
+    if (!busy && fifo_get_status(&st) == FIFO_OK) {
+        std::lock_guard<std::mutex> lock(g_status_mutex);
+        g_status = st;
+    } else {
+        std::lock_guard<std::mutex> lock(g_status_mutex);
+        st = g_status;
+    }
+
+    JsonObject j;
+    j.flag("ok", true)
+        .flag("busy", busy)
+        .str("root", cfg.root_path.c_str())
+        .flag("scheduled", st.is_scheduled != 0)
+        .str("last_run", st.last_run)
+        .str("next_run", st.next_run)
+        .num("current_mb", st.current_mb)
+        .num("predicted_mb", st.predicted_mb)
+        .num("limit_mb", cfg.limit_mb)
+        .num("usage_pct", cfg.limit_mb > 0 ? st.current_mb / cfg.limit_mb * 100.0 : 0.0)
+        .str("last_action", action_label(m.last_action));
+    return j.done();
+}
+
+static std::string cmd_metrics() {
+    EngineMetrics m;
+    if (fifo_get_metrics(&m) != FIFO_OK) return error_reply("metrics unavailable");
+    JsonObject j;
+    j.flag("ok", true)
+        .num("uptime_secs", m.uptime_secs)
+        .num("cycles", m.cycles)
+        .num("failed_cycles", m.failed_cycles)
+        .flag("in_cycle", m.in_cycle != 0)
+        .num("last_rc", m.last_rc)
+        .str("last_action", action_label(m.last_action))
+        .num("last_cycle_ms", m.last_cycle_ms)
+        .num("files_deleted", m.files_deleted)
+        .num("mb_freed", m.mb_freed)
+        .num("scan_id", m.scan_id)
+        .num("scan_files", m.scan_files)
+        .num("scan_mb", m.scan_mb);
+    return j.done();
+}
+
+static std::string cmd_run(const DaemonConfig& cfg) {
+    FullResult r;
+    int rc = fifo_execute_full(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                               cfg.target_pct, &r);
+    if (rc != FIFO_OK) return error_reply(rc == FIFO_ERR_LEASED ? "root leased by another engine"
+                                                                : "cycle failed", rc);
+    JsonObject j;
+    j.flag("ok", true)
+        .str("action", action_label(r.action))
+        .num("current_mb", r.current_mb)
+        .num("predicted_mb", r.predicted_mb)
+        .num("growth_mb_per_day", r.growth_rate)
+        .num("usage_pct", r.usage_pct)
+        .num("files_deleted", r.files_deleted)
+        .num("mb_freed", r.mb_freed)
+        .num("history_days", r.history_days)
+        .num("early_mb_freed", r.early_mb_freed)
+        .num("first_free_secs", r.first_free_secs);
+    return j.done();
+}
+
+static std::string dispatch(const std::string& command, const DaemonConfig& cfg) {
+    if (command == "status") return cmd_status(cfg);
+    if (command == "metrics") return cmd_metrics();
+    if (command == "run") return cmd_run(cfg);
+    if (command == "stop") {
+        request_stop();
+        JsonObject j;
+        return j.flag("ok", true).str("state", "stopping").done();
+    }
+    return error_reply("unknown command");
+}
+
+static void serve_client(SOCKET s, const DaemonConfig* cfg) {
+    std::string command;
+    if (ipc_recv_line(s, command, IPC_MAX_LINE)) ipc_send_all(s, dispatch(command, *cfg) + "\n");
+    closesocket(s);
+    g_clients--;
+}
+
+int main(int argc, char** argv) {
+    DaemonConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        usage();
+        return 2;
+    }
+    if (!ipc_startup()) {
+        fprintf(stderr, "fifod: winsock unavailable\n");
+        return 1;
+    }
+
+    if (fifo_init(cfg.db_path.c_str()) != FIFO_OK) {
+        fprintf(stderr, "fifod: cannot open database %s\n", cfg.db_path.c_str());
+        return 1;
+    }
+    // Scheduled cycles share this process's connection and scan state
+    fifo_set_scheduler_warm(1);
+    if (!cfg.trace_path.empty() && fifo_trace_start(cfg.trace_path.c_str()) != FIFO_OK)
+        fprintf(stderr, "fifod: cannot write trace %s\n", cfg.trace_path.c_str());
+
+    sockaddr_un addr;
+    if (!ipc_address(cfg.socket_path, addr)) {
+        fprintf(stderr, "fifod: socket path too long: %s\n", cfg.socket_path.c_str());
+        fifo_shutdown();
+        return 1;
+    }
+    DeleteFileA(cfg.socket_path.c_str());  // left behind by an unclean exit
+    g_listener = socket(AF_UNIX, SOCK_STREAM, 0);
+    if (g_listener == INVALID_SOCKET || bind(g_listener, (sockaddr*)&addr, sizeof(addr)) != 0) {
+        fprintf(stderr, "fifod: cannot listen on %s (%d)\n", cfg.socket_path.c_str(),
+                WSAGetLastError());
+        fifo_shutdown();
+        return 1;
+    }
+    if (!restrict_socket(cfg.socket_path)) {
+        fprintf(stderr, "fifod: cannot restrict access to %s (%lu)\n", cfg.socket_path.c_str(),
+                GetLastError());
+        closesocket(g_listener);
+        DeleteFileA(cfg.socket_path.c_str());
+        fifo_shutdown();
+        return 1;
+    }
+    if (listen(g_listener, SOMAXCONN) != 0) {
+        fprintf(stderr, "fifod: cannot listen on %s (%d)\n", cfg.socket_path.c_str(),
+                WSAGetLastError());
+        closesocket(g_listener);
+        DeleteFileA(cfg.socket_path.c_str());
+        fifo_shutdown();
+        return 1;
+    }
+    SetConsoleCtrlHandler(on_console_ctrl, TRUE);
+
+    // Warm the in-memory scan before the first scheduled cycle. A scan
+    // only reads; a lease held elsewhere just leaves the cached totals.
+    fifo_scan(cfg.root_path.c_str(), cfg.granularity);
+    {
+        std::lock_guard<std::mutex> lock(g_status_mutex);
+        fifo_get_status(&g_status);
+    }
+
+    int rc;
+    if (cfg.adaptive_min > 0)
+        rc = fifo_schedule_start_adaptive(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                                          cfg.target_pct, cfg.adaptive_min, cfg.adaptive_max);
+    else if (cfg.hour >= 0)
+        rc = fifo_schedule_start(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                                 cfg.target_pct, cfg.hour, cfg.minute);
+    else
+        rc = fifo_schedule_start_interval(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                                          cfg.target_pct, cfg.interval_minutes);
+    if (rc != FIFO_OK) {
+        fprintf(stderr, "fifod: cannot start scheduler (%d)\n", rc);
+        request_stop();
+    } else {
+        printf("fifod: serving %s on %s\n", cfg.root_path.c_str(), cfg.socket_path.c_str());
+        fflush(stdout);
+    }
+
+    while (!g_stop.load()) {
+        SOCKET client = accept(g_listener, nullptr, nullptr);
+        if (client == INVALID_SOCKET) {
+            if (g_stop.load()) break;
+            Sleep(100);
+            continue;
+        }
+        // "run" blocks for a whole cycle; other commands must not wait behind it
+        g_clients++;
+        std::thread(serve_client, client, &cfg).detach();
+    }
+
+    // Let in-flight replies (a running cycle included) finish first
+    while (g_clients.load() > 0) Sleep(100);
+    fifo_shutdown();
+    DeleteFileA(cfg.socket_path.c_str());
+    WSACleanup();
+    printf("fifod: stopped\n");
+    return 0;
+}
@@ -0,0 +1,342 @@
+// fiforeplay: replays a recorded workload trace against a scratch tree.
+//
+//   fiforeplay TRACE --root DIR --db PATH --limit-mb N [--speed X]
+//              [--interval MIN] [--granularity G] [--target-pct P] [--out PATH]
+//   fiforeplay --summary TRACE
+//
+// Rebuilds the trace's baseline under --root, then re-creates every
+// recorded ingest at --speed times real time (default 600: a week in under
+// 17 minutes) while the engine runs its normal Scheduler on --db. Recorded
+// deletions are not replayed; the engine under test makes its own. File
+// and folder dates are shifted so that the trace ends when the replay
+// does, which keeps retention and the oldest-first order consistent with
+// the accelerated clock. At the end the recorded cycles and the replayed
+// ones are summarised side by side; --out records the replay itself as a
+// trace, so two policies or builds can be compared with --summary.
+
+#include "fifo_api.h"
+#include "trace_format.h"
+#include <algorithm>
+#include <chrono>
+#include <cstdio>
+#include <cstdlib>
+#include <cstring>
+#include <ctime>
+#include <map>
+#include <string>
+#include <vector>
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <windows.h>
+
+struct ReplayConfig {
+    std::string trace_path;
+    std::string root_path;
+    std::string db_path;
+    std::string out_path;
+    int    granularity = FIFO_GRAN_ASSET_IDX_CAT;
+    double limit_mb = 0;
+    double target_pct = 70;
+    double speed = 600;
+    int    interval_minutes = 1;
+    bool   summary_only = false;
+};
+
+struct TraceEntity {
+    std::string asset;
+    int         index_val;
+    char        category;
+};
+
+struct Trace {
+    std::map<int, TraceEntity> entities;
+    std::vector<TraceRecord>   records;   // everything but entity records
+};
+
+static void usage() {
+    fprintf(stderr,
+            "usage: fiforeplay TRACE --root DIR --db PATH --limit-mb N [--speed X]\n"
+            "                  [--interval MIN] [--granularity G] [--target-pct P] [--out PATH]\n"
+            "       fiforeplay --summary TRACE\n");
+}
+
+static bool parse_args(int argc, char** argv, ReplayConfig& cfg) {
+    for (int i = 1; i < argc; ++i) {
+        std::string arg = argv[i];
+        if (arg.compare(0, 2, "--") != 0) {
+            cfg.trace_path = arg;
+            continue;
+        }
+        if (arg == "--summary") {
+            cfg.summary_only = true;
+            continue;
+        }
+        if (i + 1 >= argc) return false;
+        const char* v = argv[++i];
+        if (arg == "--root") cfg.root_path = v;
+        else if (arg == "--db") cfg.db_path = v;
+        else if (arg == "--out") cfg.out_path = v;
+        else if (arg == "--limit-mb") cfg.limit_mb = atof(v);
+        else if (arg == "--target-pct") cfg.target_pct = atof(v);
+        else if (arg == "--speed") cfg.speed = atof(v);
+        else if (arg == "--interval") cfg.interval_minutes = atoi(v);
+        else if (arg == "--granularity") cfg.granularity = atoi(v);
+        else return false;
+    }
+    if (cfg.trace_path.empty()) return false;
+    if (cfg.summary_only) return true;
+    return !cfg.root_path.empty() && !cfg.db_path.empty() && cfg.limit_mb > 0 &&
+           cfg.speed > 0 && cfg.interval_minutes > 0;
+}
+
+static bool load_trace(const std::string& path, Trace& out) {
+    FILE* f = fopen(path.c_str(), "rb");
+    if (!f) return false;
+    char magic[sizeof(TRACE_MAGIC)];
+    bool ok = fread(magic, 1, sizeof(magic), f) == sizeof(magic) &&
+              memcmp(magic, TRACE_MAGIC, sizeof(magic)) == 0;
+
+    TraceRecord r;
+    while (ok && fread(&r, sizeof(r), 1, f) == 1) {
+        if (r.kind != TRACE_ENTITY) {
+            out.records.push_back(r);
+            continue;
+        }
+        TraceEntity e;
+        e.asset.resize(r.day > 0 ? r.day : 0);
+        if (!e.asset.empty() && fread(&e.asset[0], 1, e.asset.size(), f) != e.asset.size())
+            break;  // truncated by a crash: keep what came before
+        e.index_val = r.index_val;
+        e.category = r.category;
+        out.entities[r.entity] = e;
+    }
+    fclose(f);
+    return ok;
+}
+
+// Cycle and cleanup statistics of one trace
+static void print_summary(const char* title, const Trace& t) {
+    std::vector<double> run_ms;
+    int baseline_files = 0, created_files = 0, deleted_files = 0, cleanups = 0;
+    double baseline_mb = 0, created_mb = 0, deleted_mb = 0, cleanup_ms = 0;
+    int64_t first = 0, last = 0;
+
+    for (auto& r : t.records) {
+        if (!first) first = r.at_ms;
+        last = r.at_ms;
+        switch (r.kind) {
+        case TRACE_BASELINE: baseline_files += r.count; baseline_mb += r.mb; break;
+        case TRACE_CREATE:   created_files += r.count; created_mb += r.mb; break;
+        case TRACE_DELETE:   deleted_files += r.count; deleted_mb += r.mb; break;
+        case TRACE_CLEANUP:  cleanups++; cleanup_ms += r.ms; break;
+        case TRACE_RUN:      run_ms.push_back(r.ms); break;
+        }
+    }
+    std::sort(run_ms.begin(), run_ms.end());
+    double total = 0;
+    for (double ms : run_ms) total += ms;
+    auto pct = [&](double p) {
+        return run_ms.empty() ? 0.0 : run_ms[(size_t)(p * (run_ms.size() - 1))];
+    };
+
+    printf("%s\n", title);
+    printf("  span        %.1f h, %d entities\n", (last - first) / 3600000.0,
+           (int)t.entities.size());
+    printf("  baseline    %d files, %.1f MB\n", baseline_files, baseline_mb);
+    printf("  ingest      %d files, %.1f MB\n", created_files, created_mb);
+    printf("  deleted     %d files, %.1f MB in %d cleanups (avg %.0f ms)\n", deleted_files,
+           deleted_mb, cleanups, cleanups ? cleanup_ms / cleanups : 0.0);
+    printf("  cycles      %d: avg %.0f ms, p50 %.0f, p95 %.0f, max %.0f\n", (int)run_ms.size(),
+           run_ms.empty() ? 0.0 : total / run_ms.size(), pct(0.5), pct(0.95), pct(1.0));
+}
+
+static void create_dirs(const std::string& path) {
+    for (size_t i = 1; i < path.size(); ++i) {
+        if (path[i] == '\\' || path[i] == '/') CreateDirectoryA(path.substr(0, i).c_str(), NULL);
+    }
+    CreateDirectoryA(path.c_str(), NULL);
+}
+
+static FILETIME to_filetime(time_t t) {
+    ULARGE_INTEGER ull;
+    ull.QuadPart = (unsigned long long)t * 10000000ULL + 116444736000000000ULL;
+    FILETIME ft;
+    ft.dwLowDateTime = ull.LowPart;
+    ft.dwHighDateTime = ull.HighPart;
+    return ft;
+}
+
+// Materialises trace records under the scratch root. Trace times are moved
+// by a fixed shift onto the replay clock.
+class Materializer {
+public:
+    Materializer(const std::string& root, const Trace& trace, int64_t shift_ms)
+        : root_(root), trace_(trace), shift_ms_(shift_ms) {}
+
+    // Files of one baseline or ingest record; false if the entity is unknown
+    bool apply(const TraceRecord& r) {
+        auto it = trace_.entities.find(r.entity);
+        if (it == trace_.entities.end()) return false;
+        const TraceEntity& e = it->second;
+
+        // Baseline files are dated at noon of their day folder, ingest at
+        // the scan that saw it; both then move onto the replay clock
+        time_t t;
+        if (r.kind == TRACE_BASELINE) {
+            struct tm day = {};
+            day.tm_year = r.day / 10000 - 1900;
+            day.tm_mon = r.day / 100 % 100 - 1;
+            day.tm_mday = r.day % 100;
+            day.tm_hour = 12;
+            day.tm_isdst = -1;
+            t = mktime(&day) + (time_t)(shift_ms_ / 1000);
+        } else {
+            t = (time_t)((r.at_ms + shift_ms_) / 1000);
+        }
+        struct tm lt;
+        localtime_s(&lt, &t);
+
+        char dir[64];
+        snprintf(dir, sizeof(dir), "\\%d\\%c\\%04d\\%02d\\%02d", e.index_val, e.category,
+                 lt.tm_year + 1900, lt.tm_mon + 1, lt.tm_mday);
+        std::string path = root_ + "\\" + e.asset + dir;
+        create_dirs(path);
+
+        int files = r.count > 0 ? r.count : 1;   // growth of existing files
+        long long bytes = (long long)(r.mb * 1048576.0 / files);
+        FILETIME ft = to_filetime(t);
+        for (int i = 0; i < files; ++i) {
+            char name[32];
+            snprintf(name, sizeof(name), "\\r%08d.dat", ++seq_);
+            HANDLE h = CreateFileA((path + name).c_str(), GENERIC_WRITE, 0, NULL,
+                                   CREATE_ALWAYS, FILE_ATTRIBUTE_NORMAL, NULL);
+            if (h == INVALID_HANDLE_VALUE) continue;
+            // Sized, not written: the engine only looks at sizes and dates
+            LARGE_INTEGER size;
+            size.QuadPart = bytes;
+            SetFilePointerEx(h, size, NULL, FILE_BEGIN);
+            SetEndOfFile(h);
+            SetFileTime(h, &ft, NULL, &ft);
+            CloseHandle(h);
+            created_mb_ += bytes / 1048576.0;
+        }
+        return true;
+    }
+
+    double created_mb() const { return created_mb_; }
+
+private:
+    std::string  root_;
+    const Trace& trace_;
+    int64_t      shift_ms_;
+    int          seq_ = 0;
+    double       created_mb_ = 0;
+};
+
+static int64_t now_ms() {
+    return std::chrono::duration_cast<std::chrono::milliseconds>(
+        std::chrono::system_clock::now().time_since_epoch()).count();
+}
+
+int main(int argc, char** argv) {
+    ReplayConfig cfg;
+    if (!parse_args(argc, argv, cfg)) {
+        usage();
+        return 2;
+    }
+
+    Trace trace;
+    if (!load_trace(cfg.trace_path, trace)) {
+        fprintf(stderr, "fiforeplay: %s is not a trace\n", cfg.trace_path.c_str());
+        return 1;
+    }
+    if (cfg.summary_only) {
+        print_summary(cfg.trace_path.c_str(), trace);
+        return 0;
+    }
+
+    // The replay clock covers the ingest records; the trace ends when it does
+    int64_t t0 = 0, t_end = 0;
+    for (auto& r : trace.records) {
+        if (r.kind != TRACE_CREATE) continue;
+        if (!t0) t0 = r.at_ms;
+        t_end = r.at_ms;
+    }
+    int64_t r0 = now_ms();
+    int64_t span_ms = (int64_t)((t_end - t0) / cfg.speed);
+    int64_t shift_ms = (r0 + span_ms) - (t_end ? t_end : r0);
+
+    create_dirs(cfg.root_path);
+    Materializer tree(cfg.root_path, trace, shift_ms);
+    for (auto& r : trace.records) {
+        if (r.kind == TRACE_BASELINE) tree.apply(r);
+    }
+    printf("fiforeplay: baseline %.1f MB under %s, replaying %.1f h in %.1f min\n",
+           tree.created_mb(), cfg.root_path.c_str(), (t_end - t0) / 3600000.0,
+           span_ms / 60000.0);
+    fflush(stdout);
+
+    if (fifo_init(cfg.db_path.c_str()) != FIFO_OK) {
+        fprintf(stderr, "fiforeplay: cannot open database %s\n", cfg.db_path.c_str());
+        return 1;
+    }
+    if (!cfg.out_path.empty() && fifo_trace_start(cfg.out_path.c_str()) != FIFO_OK) {
+        fprintf(stderr, "fiforeplay: cannot write %s\n", cfg.out_path.c_str());
+        fifo_shutdown();
+        return 1;
+    }
+    int rc = fifo_schedule_start_interval(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb,
+                                          cfg.target_pct, cfg.interval_minutes);
+    if (rc != FIFO_OK) {
+        fprintf(stderr, "fiforeplay: cannot start scheduler (%d)\n", rc);
+        fifo_shutdown();
+        return 1;
+    }
+
+    // Ingest lands when the replay clock reaches its recorded time
+    r0 = now_ms();
+    size_t done = 0, total = 0;
+    for (auto& r : trace.records) total += r.kind == TRACE_CREATE;
+    int64_t next_report = r0 + 60000;
+    for (auto& r : trace.records) {
+        if (r.kind != TRACE_CREATE) continue;
+        int64_t due = r0 + (int64_t)((r.at_ms - t0) / cfg.speed);
+        for (int64_t now = now_ms(); now < due; now = now_ms())
+            Sleep((DWORD)std::min<int64_t>(due - now, 1000));
+        tree.apply(r);
+        done++;
+        if (now_ms() >= next_report) {
+            EngineMetrics m;
+            fifo_get_metrics(&m);
+            printf("fiforeplay: %zu/%zu ingest records, %lld cycles, %.1f MB freed\n", done, total,
+                   m.cycles, m.mb_freed);
+            fflush(stdout);
+            next_report += 60000;
+        }
+    }
+
+    // One last cycle on the final tree, after any scheduled one in flight
+    fifo_schedule_stop();
+    FullResult last = {};
+    fifo_execute_full(cfg.root_path.c_str(), cfg.granularity, cfg.limit_mb, cfg.target_pct, &last);
+
+    EngineMetrics m;
+    fifo_get_metrics(&m);
+    fifo_trace_stop();
+    fifo_shutdown();
+
+    print_summary("recorded", trace);
+    if (!cfg.out_path.empty()) {
+        Trace replayed;
+        if (load_trace(cfg.out_path, replayed)) print_summary("replayed", replayed);
+    } else {
+        printf("replayed\n");
+        printf("  cycles      %lld (%lld failed), %lld files, %.1f MB freed\n", m.cycles,
+               m.failed_cycles, m.files_deleted, m.mb_freed);
+    }
+    printf("  final       %.1f MB of %.1f MB limit\n", last.current_mb - last.mb_freed,
+           cfg.limit_mb);
+    return 0;
+}
@@ -0,0 +1,65 @@
+#ifndef FIFO_TOOLS_IPC_H
+#define FIFO_TOOLS_IPC_H
+
+// Control channel shared by fifod and fifoctl: an AF_UNIX stream socket
+// (Windows 10 1803+). The client sends one command line, the daemon
+// answers with one line of JSON and closes the connection.
+
+#ifndef WIN32_LEAN_AND_MEAN
+#define WIN32_LEAN_AND_MEAN
+#endif
+#include <winsock2.h>
+#include <windows.h>
+#include <afunix.h>
+#include <cstring>
+#include <string>
+
+static const size_t IPC_MAX_LINE = 1024;
+
+inline bool ipc_startup() {
+    WSADATA wsa;
+    return WSAStartup(MAKEWORD(2, 2), &wsa) == 0;
+}
+
+// %ProgramData%\fifod.sock unless overridden with FIFOD_SOCKET
+inline std::string ipc_default_path() {
+    char buf[MAX_PATH];
+    DWORD n = GetEnvironmentVariableA("FIFOD_SOCKET", buf, sizeof(buf));
+    if (n > 0 && n < sizeof(buf)) return buf;
+    n = GetEnvironmentVariableA("ProgramData", buf, sizeof(buf));
+    if (n > 0 && n < sizeof(buf)) return std::string(buf) + "\\fifod.sock";
+    return "C:\\ProgramData\\fifod.sock";
+}
+
+inline bool ipc_address(const std::string& path, sockaddr_un& addr) {
+    std::memset(&addr, 0, sizeof(addr));
+    addr.sun_family = AF_UNIX;
+    if (path.size() >= sizeof(addr.sun_path)) return false;
+    std::memcpy(addr.sun_path, path.c_str(), path.size());
+    return true;
+}
+
+inline bool ipc_send_all(SOCKET s, const std::string& data) {
+    size_t sent = 0;
+    while (sent < data.size()) {
+        int n = send(s, data.data() + sent, (int)(data.size() - sent), 0);
+        if (n <= 0) return false;
+        sent += (size_t)n;
+    }
+    return true;
+}
+
+// Reads up to the first newline (dropped) or until the peer closes
+inline bool ipc_recv_line(SOCKET s, std::string& line, size_t max_len) {
+    line.clear();
+    char c;
+    while (line.size() < max_len) {
+        int n = recv(s, &c, 1, 0);
+        if (n <= 0) return !line.empty();
+        if (c == '\n') return true;
+        if (c != '\r') line += c;
+    }
+    return true;
+}
+
+#endif // FIFO_TOOLS_IPC_H
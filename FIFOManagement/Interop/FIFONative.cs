@@ -14,6 +14,9 @@ namespace FIFOManagement.Interop
         public const int ERR_CLEANUP = -5;
         public const int ERR_BUSY = -6;
         public const int ERR_NODATA = -7;
+        public const int ERR_LEASED = -8;
+        public const int ERR_FULL = -9;
+        public const int ERR_ARG = -10;
     }
 
     // Granularity levels
@@ -42,6 +45,31 @@ namespace FIFOManagement.Interop
         };
     }
 
+    // Event kinds (bit flags)
+    public static class FIFOEvent
+    {
+        public const int ScanDone = 0x1;
+        public const int ActionChanged = 0x2;
+        public const int CleanupStarted = 0x4;
+        public const int CleanupFinished = 0x8;
+        public const int All = 0xF;
+    }
+
+    // Deletion log export formats
+    public static class FIFOExportFormat
+    {
+        public const int Csv = 0;
+        public const int NdJson = 1;
+    }
+
+    // Bulk view kinds
+    public static class FIFOViewKind
+    {
+        public const int Entries = 0;
+        public const int Files = 1;
+        public const int Weights = 2;
+    }
+
     [StructLayout(LayoutKind.Sequential, Pack = 8, CharSet = CharSet.Ansi)]
     public struct WeightInfo
     {
@@ -94,6 +122,107 @@ namespace FIFOManagement.Interop
         public int FilesDeleted;
         public double MBFreed;
         public int HistoryDays;
+        public int EarlyFilesDeleted;
+        public double EarlyMBFreed;
+        public double FirstFreeSecs;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct EstimateResult
+    {
+        public double TotalMB;
+        public double LowMB;
+        public double HighMB;
+        public double PredictedLowMB;
+        public double PredictedHighMB;
+        public int Action;
+        public int NeedsExactScan;
+        public int ManifestFolders;
+        public int ListedFolders;
+        public int SampledFolders;
+        public int EstimatedFolders;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8, CharSet = CharSet.Ansi)]
+    public struct LeaseInfo
+    {
+        public int HeldByMe;
+        public int OwnerPid;
+        [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 64)]
+        public string OwnerHost;
+        public long HeartbeatAgeSecs;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8, CharSet = CharSet.Ansi)]
+    public struct DeletionLogEntry
+    {
+        public long Id;
+        [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 32)]
+        public string DeletedAt;
+        [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 64)]
+        public string Asset;
+        [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 260)]
+        public string FilePath;
+        public double SizeMB;
+        [MarshalAs(UnmanagedType.ByValTStr, SizeConst = 32)]
+        public string Reason;
+    }
+
+    // Rows of a bulk view; *Off fields index the view's string table
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct ScanEntryRow
+    {
+        public long AssetOff;
+        public long DateOff;
+        public int EntityId;
+        public int Granularity;
+        public int IndexVal;
+        public byte Category;
+        private byte _pad0, _pad1, _pad2;
+        public double SizeMB;
+        public int FileCount;
+        private int _pad3;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct ScanFileRow
+    {
+        public long PathOff;
+        public long CreatedTime;
+        public double SizeMB;
+        public int EntityId;
+        public int Day;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct WeightRow
+    {
+        public long AssetOff;
+        public int IndexVal;
+        public byte Category;
+        private byte _pad0, _pad1, _pad2;
+        public double AvgMB;
+        public double TotalMB;
+        public int DayCount;
+        private int _pad3;
+    }
+
+    // Engine-owned rows, valid until fifo_view_release
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct FifoView
+    {
+        public int Handle;
+        public int Kind;
+        public IntPtr Rows;
+        public long Count;
+        public int Stride;
+        private int _pad;
+        public IntPtr Strings;
+        public long StringsSize;
+        public long SnapshotId;
+
+        public string StringAt(long offset) =>
+            Marshal.PtrToStringAnsi(IntPtr.Add(Strings, (int)offset)) ?? "";
     }
 
     [StructLayout(LayoutKind.Sequential, Pack = 8, CharSet = CharSet.Ansi)]
@@ -111,6 +240,68 @@ namespace FIFOManagement.Interop
         public int LastAction;
     }
 
+    // ETA rows index MONITOR, CAUTION, CLEANUP and the limit; 0 = crossed,
+    // -1 = not within 14 days
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct TimeToFull
+    {
+        public double CurrentMB;
+        public double RateMBPerHour;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 4)]
+        public double[] EtaHours;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 4)]
+        public double[] EtaEarlyHours;
+        [MarshalAs(UnmanagedType.ByValArray, SizeConst = 4)]
+        public double[] EtaLateHours;
+        public int Intervals;
+        public int HoursCovered;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct AdmissionInfo
+    {
+        public double UsageMB;
+        public double ReservedMB;
+        public double LimitMB;
+        public double EvictedMB;
+        public long Evictions;
+        public long Denied;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct EngineMetrics
+    {
+        public long UptimeSecs;
+        public long Cycles;
+        public long FailedCycles;
+        public int LastRc;
+        public int LastAction;
+        public double LastCycleMs;
+        public long FilesDeleted;
+        public double MBFreed;
+        public long ScanId;
+        public int ScanFiles;
+        public int InCycle;
+        public double ScanMB;
+    }
+
+    [StructLayout(LayoutKind.Sequential, Pack = 8)]
+    public struct FifoEvent
+    {
+        public long Seq;
+        public long At;
+        public int Kinds;
+        public int Action;
+        public int PrevAction;
+        public int FilesDeleted;
+        public double MBFreed;
+        public double CurrentMB;
+        public double CleanupPlannedMB;
+    }
+
+    [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
+    public delegate void FifoEventCallback(ref FifoEvent ev, IntPtr user);
+
     [UnmanagedFunctionPointer(CallingConvention.Cdecl)]
     public delegate void ProgressCallback(int percent, [MarshalAs(UnmanagedType.LPStr)] string message);
 
@@ -130,12 +321,25 @@ namespace FIFOManagement.Interop
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_forecast(ref ForecastResult outResult);
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_forecast_entity(
+            [MarshalAs(UnmanagedType.LPStr)] string asset,
+            int indexVal, byte category, ref ForecastResult outResult);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_rebuild_forecast_state();
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_evaluate(double limitMb, ref EvalResult outResult);
 
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_cleanup(double limitMb, double targetPct, ref CleanupResult outResult);
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_estimate(
+            [MarshalAs(UnmanagedType.LPStr)] string rootPath,
+            double limitMb, ref EstimateResult outResult);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_execute_full(
             [MarshalAs(UnmanagedType.LPStr)] string root,
@@ -156,9 +360,24 @@ namespace FIFOManagement.Interop
         public static extern int fifo_get_weights(
             [Out] WeightInfo[] buf, int bufSize, out int outCount);
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_weights_at(
+            int granularity, [Out] WeightInfo[] buf, int bufSize, out int outCount);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_weights_span(
+            int days, int granularity, [Out] WeightInfo[] buf, int bufSize, out int outCount);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_usage_series(
+            int days, [Out] double[] buf, int bufSize, out int outCount);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_get_history_day_count();
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_time_to_full(double limitMb, ref TimeToFull outResult);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_schedule_start(
             [MarshalAs(UnmanagedType.LPStr)] string root,
@@ -171,12 +390,81 @@ namespace FIFOManagement.Interop
             int granularity, double limitMb, double targetPct,
             int intervalMinutes);
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_schedule_start_adaptive(
+            [MarshalAs(UnmanagedType.LPStr)] string root,
+            int granularity, double limitMb, double targetPct,
+            int minIntervalMinutes, int maxIntervalMinutes);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_schedule_stop();
 
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_get_status(ref StatusInfo outInfo);
 
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_metrics(ref EngineMetrics outMetrics);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_lease(
+            [MarshalAs(UnmanagedType.LPStr)] string rootPath, ref LeaseInfo outInfo);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_log_query(
+            [MarshalAs(UnmanagedType.LPStr)] string? from,
+            [MarshalAs(UnmanagedType.LPStr)] string? to,
+            [MarshalAs(UnmanagedType.LPStr)] string? asset,
+            int pageSize, out int handle);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_log_next(
+            int handle, [Out] DeletionLogEntry[] buf, int bufSize, out int outCount);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_log_close(int handle);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_log_export_file(
+            [MarshalAs(UnmanagedType.LPStr)] string? from,
+            [MarshalAs(UnmanagedType.LPStr)] string? to,
+            [MarshalAs(UnmanagedType.LPStr)] string? asset,
+            int format,
+            [MarshalAs(UnmanagedType.LPStr)] string path,
+            out long outRows);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_view_open(int kind, int granularity, int days, out FifoView outView);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_view_release(int handle);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_admission_start([MarshalAs(UnmanagedType.LPStr)] string rootPath, double limitMb);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_reserve(long bytes);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_release(long reservedBytes, long writtenBytes);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_admission(ref AdmissionInfo outInfo);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_trace_start([MarshalAs(UnmanagedType.LPStr)] string path);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_trace_stop();
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_subscribe(int kinds, FifoEventCallback cb, IntPtr user, out int handle);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_unsubscribe(int handle);
+
+        [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
+        public static extern int fifo_get_last_event(ref FifoEvent outEvent);
+
         [DllImport(DllName, CallingConvention = CallingConvention.Cdecl)]
         public static extern int fifo_set_config(
             [MarshalAs(UnmanagedType.LPStr)] string key,
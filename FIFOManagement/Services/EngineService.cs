@@ -1,4 +1,5 @@
 using System;
+using System.Collections.Generic;
 using System.IO;
 using System.Threading.Tasks;
 using FIFOManagement.Interop;
@@ -9,6 +10,11 @@ namespace FIFOManagement.Services
     {
         private bool _initialized;
         private ProgressCallback? _progressDelegate;
+        private FifoEventCallback? _eventDelegate;
+        private int _eventHandle;
+
+        // Raised on the engine's notifier thread
+        public event Action<FifoEvent>? EngineEvent;
 
         public string DbPath { get; private set; } = string.Empty;
 
@@ -19,13 +25,20 @@ namespace FIFOManagement.Services
             if (_initialized) return FIFOError.OK;
             DbPath = dbPath;
             int rc = FIFONative.fifo_init(dbPath);
-            if (rc == FIFOError.OK) _initialized = true;
+            if (rc != FIFOError.OK) return rc;
+            _initialized = true;
+
+            // Kept in a field so the GC does not collect it while native code holds it
+            _eventDelegate = (ref FifoEvent ev, IntPtr user) => EngineEvent?.Invoke(ev);
+            FIFONative.fifo_subscribe(FIFOEvent.All, _eventDelegate, IntPtr.Zero, out _eventHandle);
             return rc;
         }
 
         public void Shutdown()
         {
             if (!_initialized) return;
+            if (_eventHandle > 0) FIFONative.fifo_unsubscribe(_eventHandle);
+            _eventHandle = 0;
             FIFONative.fifo_shutdown();
             _initialized = false;
         }
@@ -36,7 +49,8 @@ namespace FIFOManagement.Services
             {
                 var result = new FullResult();
                 int rc = FIFONative.fifo_execute_full(rootPath, granularity, limitMb, targetPct, ref result);
-                if (rc != FIFOError.OK)
+                // ERR_LEASED: another engine owns the root; result holds its stored figures
+                if (rc != FIFOError.OK && rc != FIFOError.ERR_LEASED)
                     throw new EngineException($"Execute full failed (code {rc})", rc);
                 return result;
             });
@@ -47,7 +61,7 @@ namespace FIFOManagement.Services
             return Task.Run(() =>
             {
                 int rc = FIFONative.fifo_scan(rootPath, granularity);
-                if (rc != FIFOError.OK && rc != FIFOError.ERR_NODATA)
+                if (rc != FIFOError.OK && rc != FIFOError.ERR_NODATA && rc != FIFOError.ERR_LEASED)
                     throw new EngineException($"Scan failed (code {rc})", rc);
 
                 var forecast = new ForecastResult();
@@ -85,7 +99,7 @@ namespace FIFOManagement.Services
             return Task.Run(() =>
             {
                 int rc = FIFONative.fifo_scan(rootPath, granularity);
-                if (rc != FIFOError.OK && rc != FIFOError.ERR_NODATA)
+                if (rc != FIFOError.OK && rc != FIFOError.ERR_NODATA && rc != FIFOError.ERR_LEASED)
                     throw new EngineException($"Scan failed (code {rc})", rc);
 
                 var result = new CleanupResult();
@@ -107,6 +121,55 @@ namespace FIFOManagement.Services
             return result;
         }
 
+        public WeightInfo[] GetWeights(int granularity)
+        {
+            var buf = new WeightInfo[200];
+            int count;
+            int rc = FIFONative.fifo_get_weights_at(granularity, buf, buf.Length, out count);
+            if (rc != FIFOError.OK) return Array.Empty<WeightInfo>();
+            var result = new WeightInfo[count];
+            Array.Copy(buf, result, count);
+            return result;
+        }
+
+        // Deletion log, newest first, one engine page at a time
+        public IEnumerable<DeletionLogEntry> QueryDeletionLog(string? from = null, string? to = null,
+                                                              string? asset = null, int pageSize = 500)
+        {
+            int rc = FIFONative.fifo_log_query(from, to, asset, pageSize, out int handle);
+            if (rc != FIFOError.OK)
+                throw new EngineException($"Log query failed (code {rc})", rc);
+            try
+            {
+                var buf = new DeletionLogEntry[pageSize];
+                while (true)
+                {
+                    rc = FIFONative.fifo_log_next(handle, buf, buf.Length, out int count);
+                    if (rc != FIFOError.OK)
+                        throw new EngineException($"Log read failed (code {rc})", rc);
+                    if (count == 0) yield break;
+                    for (int i = 0; i < count; i++)
+                        yield return buf[i];
+                }
+            }
+            finally
+            {
+                FIFONative.fifo_log_close(handle);
+            }
+        }
+
+        public Task<long> ExportDeletionLogAsync(string path, int format, string? from = null,
+                                                 string? to = null, string? asset = null)
+        {
+            return Task.Run(() =>
+            {
+                int rc = FIFONative.fifo_log_export_file(from, to, asset, format, path, out long rows);
+                if (rc != FIFOError.OK)
+                    throw new EngineException($"Log export failed (code {rc})", rc);
+                return rows;
+            });
+        }
+
         public int GetHistoryDayCount()
         {
             return FIFONative.fifo_get_history_day_count();
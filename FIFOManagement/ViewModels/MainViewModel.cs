@@ -136,6 +136,7 @@ namespace FIFOManagement.ViewModels
 
                 DayCounter = _engine.GetHistoryDayCount();
                 IsInitialized = true;
+                _engine.EngineEvent += OnEngineEvent;
                 RefreshWeights();
                 StatusMessage = $"Engine initialized — {DayCounter} days of history in DB";
             }
@@ -372,6 +373,24 @@ namespace FIFOManagement.ViewModels
             DayCounter = _engine.GetHistoryDayCount();
         }
 
+        // Scheduled runs report here instead of being polled for
+        private void OnEngineEvent(FifoEvent ev)
+        {
+            Application.Current?.Dispatcher.BeginInvoke(() =>
+            {
+                if ((ev.Kinds & FIFOEvent.ActionChanged) != 0)
+                    ActionLabel = FIFOAction.ToLabel(ev.Action);
+                if ((ev.Kinds & FIFOEvent.CleanupFinished) != 0)
+                {
+                    LastFilesDeleted = ev.FilesDeleted;
+                    LastMBFreed = ev.MBFreed;
+                }
+                if ((ev.Kinds & FIFOEvent.ScanDone) != 0)
+                    CurrentStorageMB = ev.CurrentMB;
+                RefreshStatus();
+            });
+        }
+
         private void RefreshStatus()
         {
             try
@@ -30,16 +30,39 @@ Write-Host "========================================" -ForegroundColor Cyan
 $sources = @(
     "$engineDir\third_party\sqlite3.c",
     "$engineDir\src\database.cpp",
+    "$engineDir\src\db_manager.cpp",
+    "$engineDir\src\entity_registry.cpp",
     "$engineDir\src\scanner.cpp",
+    "$engineDir\src\oldest_first.cpp",
     "$engineDir\src\forecast.cpp",
+    "$engineDir\src\forecast_state.cpp",
+    "$engineDir\src\intraday.cpp",
+    "$engineDir\src\tsstore.cpp",
+    "$engineDir\src\estimate.cpp",
+    "$engineDir\src\eviction.cpp",
     "$engineDir\src\cleanup.cpp",
+    "$engineDir\src\tiering.cpp",
     "$engineDir\src\datagen.cpp",
+    "$engineDir\src\log_export.cpp",
+    "$engineDir\src\snapshot.cpp",
+    "$engineDir\src\lease.cpp",
+    "$engineDir\src\journal.cpp",
+    "$engineDir\src\admission.cpp",
+    "$engineDir\src\emergency.cpp",
+    "$engineDir\src\trace.cpp",
+    "$engineDir\src\spill.cpp",
+    "$engineDir\src\events.cpp",
+    "$engineDir\src\io_budget.cpp",
     "$engineDir\src\scheduler.cpp",
+    "$engineDir\src\pipeline.cpp",
     "$engineDir\src\fifo_api.cpp"
 )
 
 $includes = "/I`"$engineDir\include`" /I`"$engineDir\third_party`" /I`"$engineDir\src`""
 $defines = "/DFIFO_ENGINE_EXPORTS /DSQLITE_THREADSAFE=1 /D_CRT_SECURE_NO_WARNINGS"
+# Amalgamation options, kept in step with CMakeLists.txt
+$defines += " /DSQLITE_DEFAULT_MEMSTATUS=0 /DSQLITE_DEFAULT_WAL_SYNCHRONOUS=1 /DSQLITE_LIKE_DOESNT_MATCH_BLOBS"
+$defines += " /DSQLITE_MAX_EXPRESSION_DEPTH=0 /DSQLITE_OMIT_DEPRECATED /DSQLITE_OMIT_SHARED_CACHE /DSQLITE_USE_ALLOCA"
 $flags = "/nologo /O2 /EHsc /std:c++14 /W3 /utf-8 /MD"
 
 # Step 1: Compile each source to .obj